@@ -99,18 +99,19 @@ void RtspServer::methodSetup(Stream &stream, int clientID, std::string &htmlBody
 				"RTSP/1.0 200 OK\r\n" \
 				"CSeq: %1\r\n" \
 				"Session: %2;timeout=%3\r\n" \
-				"Transport: RTP/AVP;multicast;destination=%4;port=%5-%6;ttl=5\r\n" \
-				"com.ses.streamID: %7\r\n" \
+				"Transport: RTP/AVP;multicast;destination=%4;port=%5-%6;ttl=%7\r\n" \
+				"com.ses.streamID: %8\r\n" \
 				"\r\n";
 
-			// setup reply
+			// setup reply, the destination is the group all clients of this stream join
 			htmlBody = StringConverter::stringFormat(RTSP_SETUP_OK,
 				client.getCSeq(),
 				client.getSessionID(),
 				client.getSessionTimeout(),
-				client.getIPAddressOfStream(),
+				client.getRtpSocketAttr().getIPAddressOfSocket(),
 				client.getRtpSocketAttr().getSocketPort(),
 				client.getRtcpSocketAttr().getSocketPort(),
+				stream.getMulticastTTL(),
 				stream.getStreamID());
 			break;
 		}
@@ -22,9 +22,12 @@
 #include <Log.h>
 #include <StringConverter.h>
 #include <Utils.h>
+#include <input/WarmStandby.h>
 #include <input/dvb/Frontend.h>
 #include <input/dvb/FrontendData.h>
 #include <input/dvb/delivery/DVBS.h>
+#include <mpegts/PacketBuffer.h>
+#include <mpegts/PidFilter.h>
 #include <output/StreamThreadHttp.h>
 #include <output/StreamThreadRtp.h>
 #include <output/StreamThreadRtpTcp.h>
@@ -34,28 +37,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
 static unsigned int seedp = 0xFEED;
 const unsigned int Stream::MAX_CLIENTS = 8;
+const std::size_t Stream::MAX_CONGESTION_DROP = 95;
+const std::size_t Stream::MAX_RTP_BATCH_SIZE = output::StreamThreadBase::MAX_OUTPUT_BATCH;
+const unsigned int Stream::MAX_RTP_BATCH_LATENCY = 20;
+const std::size_t Stream::MAX_HTTP_BATCH_SIZE = output::StreamThreadBase::MAX_OUTPUT_BATCH;
 
 Stream::Stream(int streamID, input::SpDevice device, decrypt::dvbapi::SpClient decrypt) :
 	_streamID(streamID),
 	_streamingType(StreamingType::NONE),
 	_enabled(true),
 	_streamInUse(false),
+	_preTuning(false),
 	_streamActive(false),
+	_headend(false),
+	_shared(false),
 	_client(new StreamClient[MAX_CLIENTS]),
 	_streaming(nullptr),
 	_decrypt(decrypt),
 	_device(device),
+	_reactor(nullptr),
+	_pool(nullptr),
+	_standby(nullptr),
 	_ssrc((uint32_t)(rand_r(&seedp) % 0xffff)),
 	_spc(0),
 	_soc(0),
 	_timestamp(0),
 	_rtp_payload(0.0),
-	_rtcpSignalUpdate(1) {
+	_rtcpSignalUpdate(1),
+	_splitStreaming(false),
+	_stripNullPackets(false),
+	_congestionDrop(0),
+	_rtpBatchSize(32),
+	_rtpBatchLatency(0),
+	_rtpGso(false),
+	_httpBatchSize(32),
+	_httpZeroCopy(false),
+	_multicastGroup(StringConverter::stringFormat("239.255.1.%1", streamID + 1)),
+	_multicastPort(5004),
+	_multicastTTL(5),
+	_rtpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS),
+	_rtpTcpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS),
+	_httpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS) {
 	ASSERT(device);
 	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
 		_client[i].setStreamIDandClientID(streamID, i);
+		// The owner uses the SSRC of the stream (see RTCP)
+		_client[i].setSSRC((i == 0) ? _ssrc.load() : static_cast<uint32_t>(rand_r(&seedp)));
 	}
 }
 
@@ -75,10 +107,95 @@ StreamClient &Stream::getStreamClient(int clientID) const {
 	return _client[clientID];
 }
 
+std::size_t Stream::getMaxStreamClients() const {
+	return MAX_CLIENTS;
+}
+
+bool Stream::isShared() const {
+	return _shared;
+}
+
 input::SpDevice Stream::getInputDevice() const {
 	return _device;
 }
 
+input::SpInputReactor Stream::getInputReactor() const {
+	base::MutexLock lock(_xmlMutex);
+	return _reactor;
+}
+
+mpegts::SpPacketBufferPool Stream::getPacketBufferPool() const {
+	base::MutexLock lock(_xmlMutex);
+	return _pool;
+}
+
+bool Stream::isSplitStreaming() const {
+	base::MutexLock lock(_xmlMutex);
+	return _splitStreaming;
+}
+
+// The next ones are read by the streaming thread for each buffer, so they
+// are atomic and read without the lock: a request may hold it while
+// waiting for that thread to pause
+bool Stream::isNullPacketStripping() const {
+	return _stripNullPackets;
+}
+
+std::size_t Stream::getCongestionDropThreshold() const {
+	return _congestionDrop;
+}
+
+std::size_t Stream::getRtpBatchSize() const {
+	return _rtpBatchSize;
+}
+
+unsigned int Stream::getRtpBatchLatency() const {
+	return _rtpBatchLatency;
+}
+
+bool Stream::isRtpSegmentationOffload() const {
+	return _rtpGso;
+}
+
+std::size_t Stream::getHttpBatchSize() const {
+	return _httpBatchSize;
+}
+
+bool Stream::isHttpZeroCopy() const {
+	return _httpZeroCopy;
+}
+
+bool Stream::isMulticast() const {
+	base::MutexLock lock(_xmlMutex);
+	return _streamingType == StreamingType::RTSP_MULTICAST;
+}
+
+unsigned int Stream::getMulticastTTL() const {
+	base::MutexLock lock(_xmlMutex);
+	return _multicastTTL;
+}
+
+std::string Stream::getMulticastInterface() const {
+	base::MutexLock lock(_xmlMutex);
+	return _multicastInterface;
+}
+
+std::size_t Stream::getTSPacketsPerBuffer() const {
+	base::MutexLock lock(_xmlMutex);
+	switch (_streamingType) {
+		case StreamingType::RTSP_UNICAST:
+		case StreamingType::RTSP_MULTICAST:
+			return _rtpTSPackets;
+		case StreamingType::RTP_TCP:
+			return _rtpTcpTSPackets;
+		case StreamingType::HTTP:
+		case StreamingType::FILE:
+			return _httpTSPackets;
+		default:
+			return mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS;
+	}
+}
+
 #ifdef LIBDVBCSA
 decrypt::dvbapi::SpClient Stream::getDecryptDevice() const {
 	return _decrypt;
@@ -134,14 +251,29 @@ void Stream::addToXML(std::string &xml) const {
 
 		ADD_XML_CHECKBOX(xml, "enable", (_enabled ? "true" : "false"));
 		ADD_XML_ELEMENT(xml, "attached", _streamInUse ? "yes" : "no");
+		ADD_XML_ELEMENT(xml, "sessions", getClientsInUse(-1));
 		ADD_XML_ELEMENT(xml, "owner", _client[0].getIPAddressOfStream());
 		ADD_XML_ELEMENT(xml, "ownerSessionID", _client[0].getSessionID());
 		ADD_XML_ELEMENT(xml, "userAgent", _client[0].getUserAgent());
 
 		ADD_XML_NUMBER_INPUT(xml, "rtcpSignalUpdate", _rtcpSignalUpdate, 0, 5);
+		ADD_XML_CHECKBOX(xml, "splitStreaming", (_splitStreaming ? "true" : "false"));
+		ADD_XML_CHECKBOX(xml, "stripNullPackets", (_stripNullPackets ? "true" : "false"));
+		ADD_XML_NUMBER_INPUT(xml, "congestionDrop", _congestionDrop.load(), 0, MAX_CONGESTION_DROP);
+		ADD_XML_NUMBER_INPUT(xml, "rtpBatchSize", _rtpBatchSize.load(), 1, MAX_RTP_BATCH_SIZE);
+		ADD_XML_NUMBER_INPUT(xml, "rtpBatchLatency", _rtpBatchLatency.load(), 0, MAX_RTP_BATCH_LATENCY);
+		ADD_XML_CHECKBOX(xml, "rtpGso", (_rtpGso ? "true" : "false"));
+		ADD_XML_NUMBER_INPUT(xml, "httpBatchSize", _httpBatchSize.load(), 1, MAX_HTTP_BATCH_SIZE);
+		ADD_XML_CHECKBOX(xml, "httpZeroCopy", (_httpZeroCopy ? "true" : "false"));
+		ADD_XML_IP_INPUT(xml, "multicastGroup", _multicastGroup);
+		ADD_XML_NUMBER_INPUT(xml, "multicastPort", _multicastPort, 1024, 65534);
+		ADD_XML_NUMBER_INPUT(xml, "multicastTTL", _multicastTTL, 1, 255);
 
 		ADD_XML_ELEMENT(xml, "spc", _spc.load());
 		ADD_XML_ELEMENT(xml, "payload", _rtp_payload.load() / (1024.0 * 1024.0));
+		if (_streaming) {
+			_streaming->addToXML(xml);
+		}
 	}
 	_device->addToXML(xml);
 }
@@ -157,6 +289,51 @@ void Stream::fromXML(const std::string &xml) {
 		if (findXMLElement(xml, "rtcpSignalUpdate.value", element)) {
 			_rtcpSignalUpdate = std::stoi(element);
 		}
+		if (findXMLElement(xml, "splitStreaming.value", element)) {
+			_splitStreaming = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "stripNullPackets.value", element)) {
+			_stripNullPackets = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "congestionDrop.value", element)) {
+			const std::size_t threshold = std::stoi(element);
+			_congestionDrop = (threshold <= MAX_CONGESTION_DROP) ? threshold : 0;
+		}
+		if (findXMLElement(xml, "rtpBatchSize.value", element)) {
+			const std::size_t size = std::stoi(element);
+			_rtpBatchSize = (size >= 1 && size <= MAX_RTP_BATCH_SIZE) ? size : 1;
+		}
+		if (findXMLElement(xml, "rtpBatchLatency.value", element)) {
+			const unsigned int latency = std::stoi(element);
+			_rtpBatchLatency = (latency <= MAX_RTP_BATCH_LATENCY) ? latency : 0;
+		}
+		if (findXMLElement(xml, "rtpGso.value", element)) {
+			_rtpGso = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "httpBatchSize.value", element)) {
+			const std::size_t size = std::stoi(element);
+			_httpBatchSize = (size >= 1 && size <= MAX_HTTP_BATCH_SIZE) ? size : 1;
+		}
+		if (findXMLElement(xml, "httpZeroCopy.value", element)) {
+			_httpZeroCopy = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "multicastGroup.value", element)) {
+			if (isMulticastAddress(element)) {
+				_multicastGroup = element;
+			}
+		}
+		if (findXMLElement(xml, "multicastPort.value", element)) {
+			const int port = std::stoi(element);
+			if (port >= 1024 && port <= 65534) {
+				_multicastPort = port;
+			}
+		}
+		if (findXMLElement(xml, "multicastTTL.value", element)) {
+			const unsigned int ttl = std::stoi(element);
+			if (ttl >= 1 && ttl <= 255) {
+				_multicastTTL = ttl;
+			}
+		}
 	}
 	_device->fromXML(xml);
 }
@@ -186,14 +363,23 @@ bool Stream::findClientIDFor(SocketClient &socketClient,
 		return false;
 	}
 
+	// A new multicast session may join a stream that is already streaming
+	// to its multicast group (SETUP rtsp://server/stream=x)
+	const bool joinMulticast = newSession && _streamInUse &&
+		_streamingType == StreamingType::RTSP_MULTICAST &&
+		getStreamingTypeFor(message, method) == StreamingType::RTSP_MULTICAST;
+
 	// Do we have a new session then check some things
-	if (newSession) {
+	if (newSession && !joinMulticast) {
 		if (!_enabled) {
 			SI_LOG_INFO("Stream: %d, New session but this stream is not enabled, skipping...", _streamID);
 			return false;
 		} else if (_streamInUse) {
 			SI_LOG_INFO("Stream: %d, New session but this stream is in use, skipping...", _streamID);
 			return false;
+		} else if (_preTuning) {
+			SI_LOG_INFO("Stream: %d, New session but this stream is pre-tuning, skipping...", _streamID);
+			return false;
 		} else if (!_device->capableOf(msys)) {
 			if (_device->capableToTransform(message, method)) {
 				SI_LOG_INFO("Stream: %d, Capable of transforming msys=%s",
@@ -219,7 +405,9 @@ bool Stream::findClientIDFor(SocketClient &socketClient,
 			}
 			_client[i].setIPAddressOfStream(socketClient.getIPAddressOfSocket());
 			_client[i].setSocketClient(socketClient);
+			_client[i].setInUse(true);
 			_streamInUse = true;
+			updateSharedState();
 			clientID = i;
 			return true;
 		}
@@ -234,6 +422,117 @@ bool Stream::findClientIDFor(SocketClient &socketClient,
 	return false;
 }
 
+bool Stream::findSharedClientIDFor(SocketClient &socketClient,
+                                   const std::string &key,
+                                   const StreamingType streamingType,
+                                   int &clientID) {
+	base::MutexLock lock(_xmlMutex);
+
+	if (!_enabled || !_streamInUse || key.empty() ||
+	    _streamingType == StreamingType::NONE ||
+	    _streamingType != streamingType ||
+	    key != _device->getTransponderKey()) {
+		return false;
+	}
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		if (!_client[i].isInUse()) {
+			SI_LOG_INFO("Stream: %d, StreamClient[%d] shares transponder %s",
+			            _streamID, i, key.c_str());
+			_client[i].setIPAddressOfStream(socketClient.getIPAddressOfSocket());
+			_client[i].setSocketClient(socketClient);
+			_client[i].setInUse(true);
+			updateSharedState();
+			clientID = i;
+			return true;
+		}
+	}
+	SI_LOG_INFO("Stream: %d, No free StreamClient to share transponder %s", _streamID, key.c_str());
+	return false;
+}
+
+void Stream::takeOverSession(const int clientID, const StreamClient &client, const StreamingType streamingType) {
+	base::MutexLock lock(_xmlMutex);
+	_client[clientID].takeOverSession(client);
+	if (_streamingType == StreamingType::NONE) {
+		_streamingType = streamingType;
+	}
+}
+
+bool Stream::hasOtherClients(const int clientID) const {
+	base::MutexLock lock(_xmlMutex);
+	return getClientsInUse(clientID) > 0;
+}
+
+std::string Stream::getTransponderKey() const {
+	base::MutexLock lock(_xmlMutex);
+	return _streamInUse ? _device->getTransponderKey() : "";
+}
+
+Stream::StreamingType Stream::getStreamingTypeFor(const std::string &msg, const std::string &method) {
+	if (method == "GET") {
+		return StreamingType::HTTP;
+	}
+	std::string transport;
+	StringConverter::getHeaderFieldParameter(msg, "Transport:", transport);
+	// First check 'RTP/AVP/TCP' then 'RTP/AVP'
+	if (transport.find("RTP/AVP/TCP") != std::string::npos) {
+		return StreamingType::RTP_TCP;
+	} else if (transport.find("RTP/AVP") != std::string::npos) {
+		if (transport.find("multicast") != std::string::npos) {
+			return StreamingType::RTSP_MULTICAST;
+		}
+		return StreamingType::RTSP_UNICAST;
+	}
+	return StreamingType::NONE;
+}
+
+std::size_t Stream::getClientsInUse(const int clientID) const {
+	std::size_t clients = 0;
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		if (static_cast<int>(i) != clientID && _client[i].isInUse()) {
+			++clients;
+		}
+	}
+	return clients;
+}
+
+void Stream::getPIDsOfClients(mpegts::PidFilter &pids) const {
+	pids.clear();
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		if (_client[i].isInUse()) {
+			pids.merge(_client[i].getPidFilter());
+		}
+	}
+}
+
+bool Stream::isMulticastAddress(const std::string &ipAddr) {
+	struct in_addr addr;
+	return ::inet_aton(ipAddr.c_str(), &addr) != 0 && IN_MULTICAST(ntohl(addr.s_addr));
+}
+
+void Stream::updateSharedState() {
+	// Only the owner alone gets the complete output of the input device. With
+	// multicast all clients watch the same group, so it is send only once
+	_shared = _streamingType != StreamingType::RTSP_MULTICAST &&
+		!(_client[0].isInUse() && getClientsInUse(0) == 0);
+
+	// Clients that requested all PIDs the input device delivers, get the
+	// same buffers without filtering
+	mpegts::PidFilter pids;
+	getPIDsOfClients(pids);
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		_client[i].setFullView(_client[i].isInUse() && _client[i].getPidFilter().isEqual(pids));
+	}
+}
+
+void Stream::applySharedPIDs() {
+	mpegts::PidFilter pids;
+	getPIDsOfClients(pids);
+	const std::string method("PLAY");
+	const std::string msg = StringConverter::stringFormat("%1 /?pids=%2 RTSP/1.0\r\n\r\n", method, pids.toString());
+	_device->parseStreamString(msg, method);
+}
+
 void Stream::checkForSessionTimeout() {
 	base::MutexLock lock(_xmlMutex);
 
@@ -314,29 +613,152 @@ bool Stream::teardown(int clientID) {
 	SI_LOG_INFO("Stream: %d, Teardown StreamClient[%d] with SessionID %s",
 	            _streamID, clientID, _client[clientID].getSessionID().c_str());
 
+	// Other clients are still watching this transponder, so only remove
+	// this client and its PIDs. With multicast the group is send with the
+	// sockets of the first client, so keep them for the others
+	if (getClientsInUse(clientID) > 0) {
+		if (_streamingType != StreamingType::RTSP_MULTICAST || clientID != 0) {
+			_client[clientID].getRtpSocketAttr().closeFD();
+			_client[clientID].getRtcpSocketAttr().closeFD();
+		}
+		_client[clientID].teardown();
+		updateSharedState();
+		applySharedPIDs();
+		_device->update();
+		return true;
+	}
+
 	// Stop streaming by deleting object
 	if (_streaming) {
 		_streaming.reset(nullptr);
 	}
 
 	_device->clearMPEGFilters();
-	_device->teardown();
+	if (_standby && _standby->isEnabled()) {
+		_device->standby();
+	} else {
+		_device->teardown();
+	}
 
 	// as last, else sessionID and IP is reset
-	_client[clientID].teardown();
+	for (std::size_t i = 0; i < MAX_CLIENTS; ++i) {
+		_client[i].teardown();
+	}
+	updateSharedState();
+	_streamActive = false;
+	_streamInUse = false;
+	_headend = false;
+	_streamingType = StreamingType::NONE;
+	return true;
+}
+
+std::string Stream::getStandbyKey() const {
+	base::MutexLock lock(_xmlMutex);
+	if (_streamInUse || _preTuning || !_enabled) {
+		return "";
+	}
+	return _device->getStandbyKey();
+}
 
-	// @TODO Are all other StreamClients stopped??
-	if (clientID == 0) {
-		for (std::size_t i = 1; i < MAX_CLIENTS; ++i) {
-			_client[i].teardown();
+bool Stream::preTune(const std::string &query) {
+	{
+		base::MutexLock lock(_xmlMutex);
+		if (_streamInUse || _preTuning || !_enabled) {
+			return false;
 		}
-		_streamActive = false;
-		_streamInUse = false;
-		_streamingType = StreamingType::NONE;
+		_preTuning = true;
+	}
+	// Tune outside the lock, it takes up to the lock timeout. New sessions
+	// skip this stream meanwhile
+	SI_LOG_INFO("Stream: %d, Pre-tuning idle device to %s", _streamID, query.c_str());
+	const std::string method("PLAY");
+	const std::string msg = StringConverter::stringFormat("%1 /?%2 RTSP/1.0\r\n\r\n", method, query);
+	_device->clearMPEGFilters();
+	_device->parseStreamString(msg, method);
+	const bool locked = _device->update();
+	if (locked) {
+		_device->standby();
+	} else {
+		_device->teardown();
+	}
+	base::MutexLock lock(_xmlMutex);
+	_preTuning = false;
+	return locked;
+}
+
+void Stream::releaseStandby() {
+	base::MutexLock lock(_xmlMutex);
+	if (!_streamInUse && !_preTuning && !_device->getStandbyKey().empty()) {
+		SI_LOG_INFO("Stream: %d, Releasing device from standby", _streamID);
+		_device->teardown();
+	}
+}
+
+bool Stream::startHeadend(const std::string &query, const std::string &group, const int port) {
+	base::MutexLock lock(_xmlMutex);
+	if (_streamInUse || _preTuning || !_enabled) {
+		return false;
+	}
+	SI_LOG_INFO("Stream: %d, Starting headend channel to %s:%d", _streamID, group.c_str(), port);
+	// Client 0 owns the stream without an RTSP session, so without timeout
+	_client[0].setSessionID("headend");
+	_client[0].setIPAddressOfStream(group);
+	_client[0].setInUse(true);
+	_streamInUse = true;
+	_headend = true;
+	const std::string method("SETUP");
+	const std::string msg = StringConverter::stringFormat(
+		"%1 /?%2 RTSP/1.0\r\nTransport: RTP/AVP;multicast;destination=%3;port=%4-%5\r\n\r\n",
+		method, query, group, port, port + 1);
+	processStreamingRequest(msg, 0, method);
+	_client[0].stopWatchDog();
+	if (!update(0, true)) {
+		SI_LOG_ERROR("Stream: %d, Unable to start headend channel to %s:%d", _streamID, group.c_str(), port);
+		teardown(0);
+		return false;
 	}
 	return true;
 }
 
+void Stream::stopHeadend() {
+	base::MutexLock lock(_xmlMutex);
+	if (!_headend) {
+		return;
+	}
+	SI_LOG_INFO("Stream: %d, Stopping headend channel", _streamID);
+	teardown(0);
+	_headend = false;
+}
+
+bool Stream::retuneHeadend(const std::string &query) {
+	base::MutexLock lock(_xmlMutex);
+	if (!_headend) {
+		return false;
+	}
+	SI_LOG_INFO("Stream: %d, Re-tuning headend channel", _streamID);
+	const std::string method("PLAY");
+	const std::string msg = StringConverter::stringFormat("%1 /?%2 RTSP/1.0\r\n\r\n", method, query);
+	_device->clearMPEGFilters();
+	_device->parseStreamString(msg, method);
+	if (hasOtherClients(0)) {
+		// Keep the PIDs the joined clients asked for also
+		applySharedPIDs();
+	}
+	if (_streaming) {
+		_streaming->pauseStreaming(0);
+	}
+	return update(0, true);
+}
+
+bool Stream::isMulticastStreamingTo(const std::string &group, const int port) {
+	base::MutexLock lock(_xmlMutex);
+	if (!_streamInUse || _streamingType != StreamingType::RTSP_MULTICAST) {
+		return false;
+	}
+	const SocketAttr &rtp = _client[0].getRtpSocketAttr();
+	return rtp.getIPAddressOfSocket() == group && rtp.getSocketPort() == port;
+}
+
 bool Stream::processStreamingRequest(const std::string &msg, const int clientID, const std::string &method) {
 	base::MutexLock lock(_xmlMutex);
 
@@ -354,8 +776,19 @@ bool Stream::processStreamingRequest(const std::string &msg, const int clientID,
 
 	if ((method == "SETUP" || method == "PLAY"  || method == "GET") &&
 	    StringConverter::hasTransportParameters(msg)) {
-		_device->clearMPEGFilters();
-		_device->parseStreamString(msg, method);
+		if (_standby) {
+			_standby->addRequest(msg, method);
+		}
+		_client[clientID].getPidFilter().parseStreamString(msg, method);
+		updateSharedState();
+		if (getClientsInUse(clientID) > 0) {
+			// Other clients are watching this transponder also, so only
+			// change the PIDs of the input device
+			applySharedPIDs();
+		} else {
+			_device->clearMPEGFilters();
+			_device->parseStreamString(msg, method);
+		}
 	}
 
 	// Channel changed?.. stop/pause Stream
@@ -366,18 +799,7 @@ bool Stream::processStreamingRequest(const std::string &msg, const int clientID,
 
 	// Get transport type from request, and maybe ports
 	if (_streamingType == StreamingType::NONE) {
-		if (method == "GET") {
-			_streamingType = StreamingType::HTTP;
-		} else {
-			std::string transport;
-			StringConverter::getHeaderFieldParameter(msg, "Transport:", transport);
-			// First check 'RTP/AVP/TCP' then 'RTP/AVP'
-			if (transport.find("RTP/AVP/TCP") != std::string::npos) {
-				_streamingType = StreamingType::RTP_TCP;
-			} else if (transport.find("RTP/AVP") != std::string::npos) {
-				_streamingType = StreamingType::RTSP_UNICAST;
-			}
-		}
+		_streamingType = getStreamingTypeFor(msg, method);
 	}
 	switch (_streamingType) {
 		case StreamingType::RTP_TCP: {
@@ -396,10 +818,27 @@ bool Stream::processStreamingRequest(const std::string &msg, const int clientID,
 			}
 			break;
 		case StreamingType::RTSP_MULTICAST: {
-				const int port = StringConverter::getIntParameter(msg, "Transport:", "port=");
+				std::string group;
+				int port = -1;
+				if (getClientsInUse(clientID) > 0) {
+					// Join the group that is already streaming
+					const SocketAttr &rtp = _client[0].getRtpSocketAttr();
+					group = rtp.getIPAddressOfSocket();
+					port = rtp.getSocketPort();
+				} else if (method == "SETUP") {
+					// Use the requested group and port, or assign them
+					if (!StringConverter::getStringParameter(msg, "Transport:", "destination=", group) ||
+					    !isMulticastAddress(group)) {
+						group = _multicastGroup;
+					}
+					port = StringConverter::getIntParameter(msg, "Transport:", "port=");
+					if (port <= 0 || port > 65534) {
+						port = _multicastPort;
+					}
+				}
 				if (port != -1) {
-					_client[clientID].getRtpSocketAttr().setupSocketStructure(_client[clientID].getIPAddressOfStream(), port);
-					_client[clientID].getRtcpSocketAttr().setupSocketStructure(_client[clientID].getIPAddressOfStream(), port + 1);
+					_client[clientID].getRtpSocketAttr().setupSocketStructure(group, port);
+					_client[clientID].getRtcpSocketAttr().setupSocketStructure(group, port + 1);
 				}
 			}
 			break;
@@ -35,9 +35,13 @@
 FW_DECL_NS0(SocketClient);
 FW_DECL_NS1(output, StreamThreadBase);
 FW_DECL_NS1(input, DeviceData);
+FW_DECL_NS1(mpegts, PidFilter);
 
 FW_DECL_UP_NS1(output, StreamThreadBase);
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
+FW_DECL_SP_NS1(input, InputReactor);
+FW_DECL_SP_NS1(input, WarmStandby);
+FW_DECL_SP_NS1(mpegts, PacketBufferPool);
 FW_DECL_SP_NS2(input, dvb, FrontendDecryptInterface);
 
 FW_DECL_VECTOR_NS0(Stream);
@@ -48,6 +52,10 @@ class Stream :
 	public base::XMLSupport {
 	public:
 		static const unsigned int MAX_CLIENTS;
+		static const std::size_t MAX_CONGESTION_DROP;
+		static const std::size_t MAX_RTP_BATCH_SIZE;
+		static const unsigned int MAX_RTP_BATCH_LATENCY;
+		static const std::size_t MAX_HTTP_BATCH_SIZE;
 
 		enum class StreamingType {
 			NONE,
@@ -83,8 +91,40 @@ class Stream :
 
 		virtual StreamClient &getStreamClient(int clientID) const override;
 
+		virtual std::size_t getMaxStreamClients() const override;
+
+		virtual bool isShared() const override;
+
 		virtual input::SpDevice getInputDevice() const override;
 
+		virtual input::SpInputReactor getInputReactor() const override;
+
+		virtual mpegts::SpPacketBufferPool getPacketBufferPool() const override;
+
+		virtual bool isSplitStreaming() const override;
+
+		virtual bool isNullPacketStripping() const override;
+
+		virtual std::size_t getCongestionDropThreshold() const override;
+
+		virtual std::size_t getRtpBatchSize() const override;
+
+		virtual unsigned int getRtpBatchLatency() const override;
+
+		virtual bool isRtpSegmentationOffload() const override;
+
+		virtual std::size_t getHttpBatchSize() const override;
+
+		virtual bool isHttpZeroCopy() const override;
+
+		virtual bool isMulticast() const override;
+
+		virtual unsigned int getMulticastTTL() const override;
+
+		virtual std::string getMulticastInterface() const override;
+
+		virtual std::size_t getTSPacketsPerBuffer() const override;
+
 #ifdef LIBDVBCSA
 		///
 		virtual decrypt::dvbapi::SpClient getDecryptDevice() const override;
@@ -135,6 +175,33 @@ class Stream :
 		                     const std::string &method,
 		                     int &clientID);
 
+		/// Find a free clientID for a session that requests the same
+		/// transponder, with key @a key (see @c WarmStandby), and streaming
+		/// type as this stream is streaming already. The key has to match
+		/// completely, so a session asking for another modulation, PLP or
+		/// T2 system ID on the same frequency gets its own frontend
+		bool findSharedClientIDFor(SocketClient &socketClient,
+		                           const std::string &key,
+		                           StreamingType streamingType,
+		                           int &clientID);
+
+		/// Take over the session of @a client, that moves from another stream
+		/// to @a clientID of this stream
+		void takeOverSession(int clientID, const StreamClient &client, StreamingType streamingType);
+
+		/// Check if other clients than @a clientID are using this stream
+		bool hasOtherClients(int clientID) const;
+
+		/// Get the transponder key of the transponder this stream is
+		/// streaming, or an empty string when not in use
+		std::string getTransponderKey() const;
+
+		/// Get the streaming type the request in @a msg would use
+		static StreamingType getStreamingTypeFor(const std::string &msg, const std::string &method);
+
+		/// Check if @a ipAddr is an IPv4 multicast address
+		static bool isMulticastAddress(const std::string &ipAddr);
+
 		/// Check is this stream used already
 		bool streamInUse() const {
 			base::MutexLock lock(_xmlMutex);
@@ -153,6 +220,83 @@ class Stream :
 			return _streamingType;
 		}
 
+		/// Set the input reactor that should be used to watch the input device
+		void setInputReactor(input::SpInputReactor reactor) {
+			base::MutexLock lock(_xmlMutex);
+			_reactor = reactor;
+		}
+
+		/// Set the pool the packet buffers of this stream should be taken from
+		void setPacketBufferPool(mpegts::SpPacketBufferPool pool) {
+			base::MutexLock lock(_xmlMutex);
+			_pool = pool;
+		}
+
+		/// Set the IP address of the interface multicast packets are send from
+		void setMulticastInterface(const std::string &ipAddr) {
+			base::MutexLock lock(_xmlMutex);
+			_multicastInterface = ipAddr;
+		}
+
+		/// Set the warm standby policy that should be used with teardown
+		void setWarmStandby(input::SpWarmStandby standby) {
+			base::MutexLock lock(_xmlMutex);
+			_standby = standby;
+		}
+
+		/// Set the amount of TS packets in one packet buffer for each output
+		/// type, used when streaming starts
+		void setTSPacketsPerBuffer(std::size_t rtp, std::size_t rtpTcp, std::size_t http) {
+			base::MutexLock lock(_xmlMutex);
+			_rtpTSPackets = rtp;
+			_rtpTcpTSPackets = rtpTcp;
+			_httpTSPackets = http;
+		}
+
+		/// Get the transponder key the idle input device is still tuned to,
+		/// or an empty string when not in standby or in use
+		std::string getStandbyKey() const;
+
+		/// Tune the idle input device to the transponder in @a query and put
+		/// it in standby. The tune is done without holding the lock, new
+		/// sessions skip this stream meanwhile
+		/// @return true if the device locked on this transponder
+		bool preTune(const std::string &query);
+
+		/// Release the input device when it is idle in standby
+		void releaseStandby();
+
+		/// Start streaming the channel in @a query permanently to the
+		/// multicast @a group and @a port, without an RTSP session
+		/// @return true if the idle stream is tuned and streaming
+		bool startHeadend(const std::string &query, const std::string &group, int port);
+
+		/// Stop streaming the headend channel, RTSP clients that joined
+		/// the group keep the stream
+		void stopHeadend();
+
+		/// Tune the input device of the headend channel again to @a query,
+		/// for instance after the lock was lost. The stream keeps streaming
+		/// to its group, with the RTSP clients that joined it
+		/// @return true if the device is tuned again
+		bool retuneHeadend(const std::string &query);
+
+		/// Check if this stream is streaming with RTSP multicast to @a group
+		/// and @a port, like the RTSP clients that joined a stopped headend
+		/// channel still do
+		bool isMulticastStreamingTo(const std::string &group, int port);
+
+		/// Check if this stream is streaming a headend channel
+		bool isHeadend() const {
+			base::MutexLock lock(_xmlMutex);
+			return _headend;
+		}
+
+		/// Check if the input device of this stream has a signal lock
+		bool hasInputLock() const {
+			return _device->hasLock();
+		}
+
 		/// Teardown the stream client with clientID
 		bool teardown(int clientID);
 
@@ -171,10 +315,21 @@ class Stream :
 		///
 		bool update(int clientID, bool start);
 
-	protected:
-
 	private:
 
+		/// Get the amount of clients using this stream, without @a clientID
+		std::size_t getClientsInUse(int clientID) const;
+
+		/// Get the PIDs requested by all clients of this stream
+		void getPIDsOfClients(mpegts::PidFilter &pids) const;
+
+		/// Update the shared flag and the full view of the clients, after a
+		/// client is added or removed or changed its PIDs
+		void updateSharedState();
+
+		/// Give the PIDs of all clients to the input device
+		void applySharedPIDs();
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -183,19 +338,40 @@ class Stream :
 		StreamingType     _streamingType; ///
 		bool              _enabled;       /// is this stream enabled, could we use it?
 		bool              _streamInUse;   ///
+		bool              _preTuning;     /// idle device is tuned for warm standby
 		bool              _streamActive;  ///
+		bool              _headend;       /// streaming a headend channel, no session timeout
+		std::atomic<bool> _shared;        /// stream is shared by more clients
 
 		StreamClient     *_client;        /// defines the participants of this stream
 		                                  /// index 0 is the owner of this stream
 		output::UpStreamThreadBase _streaming; ///
 		decrypt::dvbapi::SpClient _decrypt;///
 		input::SpDevice _device;          ///
+		input::SpInputReactor _reactor;   ///
+		mpegts::SpPacketBufferPool _pool; ///
+		input::SpWarmStandby _standby;    ///
 		std::atomic<uint32_t> _ssrc;      /// synchronisation source identifier of sender
 		std::atomic<uint32_t> _spc;       /// sender RTP packet count  (used in SR packet)
 		std::atomic<uint32_t> _soc;       /// sender RTP payload count (used in SR packet)
 		std::atomic<long> _timestamp;     ///
 		std::atomic<double> _rtp_payload; ///
 		unsigned int _rtcpSignalUpdate;   ///
+		bool _splitStreaming;             /// separate input and output thread
+		std::atomic<bool> _stripNullPackets; /// remove null packets before sending
+		std::atomic<std::size_t> _congestionDrop; /// ring usage (%) to drop low priority PIDs, 0 = off
+		std::atomic<std::size_t> _rtpBatchSize; /// RTP/UDP packets per sendmmsg
+		std::atomic<unsigned int> _rtpBatchLatency; /// ms ready RTP/UDP packets may wait for a batch
+		std::atomic<bool> _rtpGso;        /// send RTP/UDP batches with UDP_SEGMENT
+		std::atomic<std::size_t> _httpBatchSize; /// buffers per HTTP writev/sendmsg
+		std::atomic<bool> _httpZeroCopy;  /// send HTTP batches with MSG_ZEROCOPY
+		std::string _multicastGroup;      /// group assigned when the client does not request one
+		int _multicastPort;               /// RTP port assigned with this group, RTCP is +1
+		unsigned int _multicastTTL;       ///
+		std::string _multicastInterface;  /// IP address of the outgoing interface
+		std::size_t _rtpTSPackets;        /// TS packets per buffer for RTP/UDP
+		std::size_t _rtpTcpTSPackets;     /// TS packets per buffer for RTP/TCP
+		std::size_t _httpTSPackets;       /// TS packets per buffer for HTTP (and file)
 
 };
 
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <cerrno>
 #include <ctime>
 
 	StreamClient::StreamClient() :
@@ -38,7 +39,11 @@
 			_sessionTimeout(60),
 			_sessionID("-1"),
 			_userAgent("None"),
-			_cseq(0) {}
+			_cseq(0),
+			_inUse(false),
+			_fullView(false),
+			_ssrc(0),
+			_rtpSequence(0) {}
 
 	StreamClient::~StreamClient() {}
 
@@ -49,11 +54,27 @@
 		_sessionID = "-1";
 		_ipAddress = "0.0.0.0";
 		_userAgent = "None";
+		_inUse = false;
+		_fullView = false;
+		_pidFilter.clear();
+		_rtpSequence = 0;
 
 		// Do not delete
 		_httpStream = nullptr;
 	}
 
+	void StreamClient::takeOverSession(const StreamClient &client) {
+		base::MutexLock lock(_mutex);
+		base::MutexLock lockClient(client._mutex);
+
+		_ipAddress = client._ipAddress;
+		_userAgent = client._userAgent;
+		_cseq = client._cseq;
+		_sessionTimeout = client._sessionTimeout;
+		_rtp.setupSocketStructure(client._rtp.getIPAddressOfSocket(), client._rtp.getSocketPort());
+		_rtcp.setupSocketStructure(client._rtcp.getIPAddressOfSocket(), client._rtcp.getSocketPort());
+	}
+
 	void StreamClient::restartWatchDog() {
 		base::MutexLock lock(_mutex);
 
@@ -61,6 +82,11 @@
 		_watchdog = std::time(nullptr) + _sessionTimeout + 15;
 	}
 
+	void StreamClient::stopWatchDog() {
+		base::MutexLock lock(_mutex);
+		_watchdog = 0;
+	}
+
 	void StreamClient::selfDestruct() {
 		base::MutexLock lock(_mutex);
 		_watchdog = 1;
@@ -106,6 +132,25 @@
 		return (_httpStream == nullptr) ? false : _httpStream->writeData(iov, iovcnt);
 	}
 
+	ssize_t StreamClient::sendHttpMessage(const struct msghdr *msg, int flags) {
+		base::MutexLock lock(_mutex);
+		if (_httpStream == nullptr) {
+			errno = EBADF;
+			return -1;
+		}
+		return _httpStream->sendMessage(msg, flags);
+	}
+
+	bool StreamClient::setHttpZeroCopy() {
+		base::MutexLock lock(_mutex);
+		return (_httpStream == nullptr) ? false : _httpStream->setZeroCopy();
+	}
+
+	bool StreamClient::readHttpZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied) {
+		base::MutexLock lock(_mutex);
+		return (_httpStream == nullptr) ? false : _httpStream->readZeroCopyCompletion(lo, hi, copied);
+	}
+
 	int StreamClient::getHttpSocketPort() const {
 		base::MutexLock lock(_mutex);
 		return (_httpStream == nullptr) ? 0 : _httpStream->getSocketPort();
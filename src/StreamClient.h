@@ -24,7 +24,10 @@
 #include <socket/SocketAttr.h>
 #include <socket/SocketClient.h>
 #include <base/Mutex.h>
+#include <mpegts/PidFilter.h>
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <ctime>
 
@@ -52,6 +55,61 @@ class StreamClient {
 		///
 		void teardown();
 
+		/// Mark this client as (not) being used by a session
+		void setInUse(bool inUse) {
+			_inUse = inUse;
+		}
+
+		/// Check if this client is used by a session
+		bool isInUse() const {
+			return _inUse;
+		}
+
+		/// Set if this client requested all the PIDs the input device
+		/// delivers, then it can get the same buffers as the input device
+		/// delivers without filtering (and copying)
+		void setFullView(bool fullView) {
+			_fullView = fullView;
+		}
+
+		/// Check if this client requested all the PIDs the input device delivers
+		bool isFullView() const {
+			return _fullView;
+		}
+
+		/// Set the RTP synchronisation source identifier of this client
+		void setSSRC(uint32_t ssrc) {
+			_ssrc = ssrc;
+		}
+
+		/// Get the RTP synchronisation source identifier of this client
+		uint32_t getSSRC() const {
+			return _ssrc;
+		}
+
+		/// Take over the session of @a client, that moves to this client
+		/// (IP, User-Agent, CSeq and RTP/RTCP destination)
+		void takeOverSession(const StreamClient &client);
+
+		/// Get the PIDs this client requested, used when the stream is
+		/// shared by more clients
+		mpegts::PidFilter &getPidFilter() {
+			return _pidFilter;
+		}
+		const mpegts::PidFilter &getPidFilter() const {
+			return _pidFilter;
+		}
+
+		/// Get the next RTP sequence number for this client
+		uint16_t getNextRtpSequenceNumber() {
+			return ++_rtpSequence;
+		}
+
+		/// Reset the RTP sequence number for this client
+		void resetRtpSequenceNumber() {
+			_rtpSequence = 0;
+		}
+
 		/// Call this if the stream should stop because of some error
 		void selfDestruct();
 
@@ -61,6 +119,9 @@ class StreamClient {
 		///
 		void restartWatchDog();
 
+		/// Stop the watchdog, so this client has no session timeout
+		void stopWatchDog();
+
 		/// Check if this client has an session timeout
 		bool sessionTimeout() const;
 
@@ -139,6 +200,17 @@ class StreamClient {
 		/// Send HTTP/RTSP data to connected client
 		bool writeHttpData(const struct iovec *iov, int iovcnt);
 
+		/// Send HTTP data to connected client, like with MSG_ZEROCOPY
+		/// @return the amount of Bytes send, or -1 on error (see errno)
+		ssize_t sendHttpMessage(const struct msghdr *msg, int flags);
+
+		/// Let the HTTP socket accept sends with MSG_ZEROCOPY
+		bool setHttpZeroCopy();
+
+		/// Read one completion notification of the MSG_ZEROCOPY sends
+		/// on the HTTP socket, without waiting
+		bool readHttpZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied);
+
 		/// Get the HTTP/RTSP port of the connected client
 		int getHttpSocketPort() const;
 
@@ -166,6 +238,11 @@ class StreamClient {
 		int          _cseq;            /// RTSP sequence number
 		SocketAttr   _rtp;
 		SocketAttr   _rtcp;
+		std::atomic<bool> _inUse;      /// is this client used by a session
+		std::atomic<bool> _fullView;   /// did this client request all PIDs of the stream
+		std::atomic<uint32_t> _ssrc;   /// RTP synchronisation source identifier
+		mpegts::PidFilter _pidFilter;  /// PIDs requested by this client
+		uint16_t     _rtpSequence;     /// RTP sequence number
 };
 
 #endif // STREAM_CLIENT_H_INCLUDE
@@ -22,8 +22,12 @@
 
 #include <FwDecl.h>
 
+#include <cstddef>
+
 FW_DECL_NS0(StreamClient);
 FW_DECL_SP_NS1(input, Device);
+FW_DECL_SP_NS1(input, InputReactor);
+FW_DECL_SP_NS1(mpegts, PacketBufferPool);
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
 
 /// The class @c StreamInterface is an interface to an @c Stream
@@ -46,9 +50,68 @@ class StreamInterface {
 		///
 		virtual StreamClient &getStreamClient(int clientID) const = 0;
 
+		/// Get the maximum amount of stream clients of this stream
+		virtual std::size_t getMaxStreamClients() const = 0;
+
+		/// Check if the stream is shared by more clients, then each client
+		/// should only get the PIDs it requested itself
+		virtual bool isShared() const = 0;
+
 		///
 		virtual input::SpDevice getInputDevice() const = 0;
 
+		/// Get the input reactor, or nullptr if there is none
+		virtual input::SpInputReactor getInputReactor() const = 0;
+
+		/// Get the pool the packet buffers should be taken from, or nullptr
+		/// if there is none
+		virtual mpegts::SpPacketBufferPool getPacketBufferPool() const = 0;
+
+		/// Check if reading the input and sending should be done by separate
+		/// threads
+		virtual bool isSplitStreaming() const = 0;
+
+		/// Check if null packets should be removed from the stream
+		virtual bool isNullPacketStripping() const = 0;
+
+		/// Get the percentage of the ring that may be used, before low priority
+		/// PIDs are dropped. 0 means nothing is dropped, reading the input just
+		/// stops when the ring is full
+		virtual std::size_t getCongestionDropThreshold() const = 0;
+
+		/// Get the maximum amount of RTP/UDP packets that may be send with one
+		/// syscall, 1 means every packet is send by itself
+		virtual std::size_t getRtpBatchSize() const = 0;
+
+		/// Get the time (ms) ready RTP/UDP packets may wait to fill up a batch
+		virtual unsigned int getRtpBatchLatency() const = 0;
+
+		/// Check if a batch of RTP/UDP packets should be send as one buffer,
+		/// that is split into the packets by the kernel or NIC (UDP GSO)
+		virtual bool isRtpSegmentationOffload() const = 0;
+
+		/// Get the maximum amount of buffers that may be send with one HTTP
+		/// syscall, 1 means every buffer is send by itself
+		virtual std::size_t getHttpBatchSize() const = 0;
+
+		/// Check if HTTP batches should be send with MSG_ZEROCOPY, so the
+		/// kernel sends from the ring buffers without copying them
+		virtual bool isHttpZeroCopy() const = 0;
+
+		/// Check if this stream is send to a multicast group
+		virtual bool isMulticast() const = 0;
+
+		/// Get the TTL of the multicast packets of this stream
+		virtual unsigned int getMulticastTTL() const = 0;
+
+		/// Get the IP address of the interface the multicast packets should
+		/// be send from, empty to let the kernel choose
+		virtual std::string getMulticastInterface() const = 0;
+
+		/// Get the amount of TS packets in one packet buffer, for the output
+		/// type of this stream
+		virtual std::size_t getTSPacketsPerBuffer() const = 0;
+
 #ifdef LIBDVBCSA
 		///
 		virtual decrypt::dvbapi::SpClient getDecryptDevice() const = 0;
@@ -24,28 +24,72 @@
 #include <StreamClient.h>
 #include <socket/SocketClient.h>
 #include <StringConverter.h>
+#include <input/InputReactor.h>
+#include <input/WarmStandby.h>
 #include <input/dvb/Frontend.h>
 #include <input/file/TSReader.h>
 #include <input/stream/Streamer.h>
+#include <mpegts/PacketBuffer.h>
+#include <mpegts/PacketBufferPool.h>
+#include <mpegts/TSHeaderParser.h>
+#include <output/Headend.h>
 #ifdef LIBDVBCSA
 	#include <decrypt/dvbapi/Client.h>
 	#include <input/dvb/FrontendDecryptInterface.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <random>
+#include <thread>
 #include <cmath>
 
 #include <assert.h>
 
 StreamManager::StreamManager() :
 	XMLSupport(),
-	_decrypt(nullptr) {
+	_decrypt(nullptr),
+	_reactor(std::make_shared<input::InputReactor>()),
+	_pool(std::make_shared<mpegts::PacketBufferPool>()),
+	_standby(std::make_shared<input::WarmStandby>()),
+	_standbyThread("WarmStandby", [this] {
+		preTuneIdleStreams();
+		// Park while warm standby is off, until the settings change
+		std::unique_lock<std::mutex> lock(_standbyMutex);
+		if (_standby->isEnabled()) {
+			_standbyChanged.wait_for(lock, std::chrono::seconds(1), [this] { return _standbyStopping; });
+		} else {
+			_standbyChanged.wait(lock, [this] { return _standbyStopping || _standby->isEnabled(); });
+		}
+		return true;
+	}),
+	_standbyStopping(false),
+	_headend(std::make_shared<output::Headend>()),
+	_headendThread("Headend", [this] {
+		updateHeadend();
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		return true;
+	}),
+	_transponderSharing(false),
+	_sharedAttaches(0),
+	_sharedMoves(0),
+	_rtpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS),
+	_rtpTcpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS),
+	_httpTSPackets(mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS) {
 #ifdef LIBDVBCSA
 	_decrypt = std::make_shared<decrypt::dvbapi::Client>(*this);
 #endif
 }
 
-StreamManager::~StreamManager() {}
+StreamManager::~StreamManager() {
+	{
+		std::unique_lock<std::mutex> lock(_standbyMutex);
+		_standbyStopping = true;
+	}
+	_standbyChanged.notify_all();
+	_standbyThread.terminateThread();
+	_headendThread.terminateThread();
+}
 
 #ifdef LIBDVBCSA
 	decrypt::dvbapi::SpClient StreamManager::getDecrypt() const {
@@ -67,12 +111,28 @@ void StreamManager::enumerateDevices(
 	SI_LOG_ERROR("Not the preferred DVB API version, for correct function it should be 5.5 or higher");
 #endif
 	SI_LOG_INFO("Current DVB_API_VERSION: %d.%d", DVB_API_VERSION, DVB_API_VERSION_MINOR);
+	SI_LOG_INFO("Using %s TS header parser", mpegts::TSHeaderParser::getImplementationName());
 	SI_LOG_INFO("Enumerating all devices...");
 
 	// enumerate streams (frontends)
 	input::dvb::Frontend::enumerate(_stream, appDataPath, _decrypt, dvbPath);
 	input::file::TSReader::enumerate(_stream, appDataPath);
 	input::stream::Streamer::enumerate(_stream, bindIPAddress);
+
+	for (SpStream stream : _stream) {
+		stream->setInputReactor(_reactor);
+		stream->setPacketBufferPool(_pool);
+		stream->setWarmStandby(_standby);
+		stream->setMulticastInterface(bindIPAddress);
+		stream->setTSPacketsPerBuffer(_rtpTSPackets, _rtpTcpTSPackets, _httpTSPackets);
+	}
+	if (!_standbyThread.startThread()) {
+		SI_LOG_ERROR("Unable to start warm standby thread");
+	}
+	_headend->setAppDataPath(appDataPath);
+	if (!_headendThread.startThread()) {
+		SI_LOG_ERROR("Unable to start headend thread");
+	}
 }
 
 std::string StreamManager::getXMLDeliveryString() const {
@@ -147,7 +207,11 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 
 	// if no sessionID, then try to find it.
 	if (!foundSessionID) {
-		if (StringConverter::hasTransportParameters(socketClient.getMessage())) {
+		// A SETUP of a multicast session without transport parameters
+		// joins the group of the requested stream
+		const bool joinMulticast = streamID != -1 && method == "SETUP" &&
+			Stream::getStreamingTypeFor(msg, method) == Stream::StreamingType::RTSP_MULTICAST;
+		if (StringConverter::hasTransportParameters(socketClient.getMessage()) || joinMulticast) {
 			// Do we need to make a new sessionID (only if there are transport parameters)
 			std::random_device rd;
 			std::mt19937 gen(rd());
@@ -168,19 +232,53 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 			for (SpStream stream : _stream) {
 				if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
 					stream->getStreamClient(clientID).setSessionID(sessionID);
-					return stream;
+					return moveSharedSession(stream, socketClient, sessionID, method, clientID);
 				}
 			}
 		} else {
 			SI_LOG_INFO("Found StreamID x - SessionID x - Creating new SessionID: %s", sessionID.c_str());
-			for (SpStream stream : _stream) {
-				if (!stream->streamInUse()) {
-					if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
+			// First try to share a stream that is streaming the requested transponder,
+			// so the same transponder key, multicast clients always join the group
+			// of such a stream
+			const Stream::StreamingType streamingType = Stream::getStreamingTypeFor(msg, method);
+			if (_transponderSharing || streamingType == Stream::StreamingType::RTSP_MULTICAST) {
+				const std::string key = input::WarmStandby::getTransponderKey(msg, method);
+				for (SpStream stream : _stream) {
+					if (stream->findSharedClientIDFor(socketClient, key, streamingType, clientID)) {
+						SI_LOG_INFO("Stream: %d, Sharing transponder %s", stream->getStreamID(), key.c_str());
+						++_sharedAttaches;
 						stream->getStreamClient(clientID).setSessionID(sessionID);
 						return stream;
 					}
 				}
 			}
+			// First try a stream that is in standby on the requested transponder
+			if (_standby->isEnabled()) {
+				const std::string key = input::WarmStandby::getTransponderKey(msg, method);
+				for (SpStream stream : _stream) {
+					if (!key.empty() && stream->getStandbyKey() == key) {
+						if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
+							SI_LOG_INFO("Stream: %d, Using device in standby for %s", stream->getStreamID(), key.c_str());
+							_standby->addHit();
+							stream->getStreamClient(clientID).setSessionID(sessionID);
+							return stream;
+						}
+					}
+				}
+				_standby->addMiss();
+			}
+			// Prefer streams that are not in standby, to keep those tuned
+			const bool standby = _standby->isEnabled();
+			for (int pass = standby ? 0 : 1; pass < 2; ++pass) {
+				for (SpStream stream : _stream) {
+					if (!stream->streamInUse() && (pass == 1 || stream->getStandbyKey().empty())) {
+						if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
+							stream->getStreamClient(clientID).setSessionID(sessionID);
+							return stream;
+						}
+					}
+				}
+			}
 		}
 	} else {
 		SI_LOG_INFO("Found StreamID %d - SessionID %s", streamID, sessionID.c_str());
@@ -189,12 +287,12 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 			for (SpStream stream : _stream) {
 				if (stream->findClientIDFor(socketClient, newSession, sessionID, method, clientID)) {
 					stream->getStreamClient(clientID).setSessionID(sessionID);
-					return stream;
+					return moveSharedSession(stream, socketClient, sessionID, method, clientID);
 				}
 			}
 		} else {
 			_stream[streamID]->getStreamClient(clientID).setSessionID(sessionID);
-			return _stream[streamID];
+			return moveSharedSession(_stream[streamID], socketClient, sessionID, method, clientID);
 		}
 	}
 	// Did not find anything
@@ -202,17 +300,132 @@ SpStream StreamManager::findStreamAndClientIDFor(SocketClient &socketClient, int
 	return nullptr;
 }
 
+SpStream StreamManager::moveSharedSession(
+		SpStream stream,
+		SocketClient &socketClient,
+		const std::string &sessionID,
+		const std::string &method,
+		int &clientID) {
+	if (!_transponderSharing || (method != "SETUP" && method != "PLAY") ||
+	    !stream->hasOtherClients(clientID)) {
+		return stream;
+	}
+	const std::string &msg = socketClient.getMessage();
+	const std::string key = input::WarmStandby::getTransponderKey(msg, method);
+	if (key.empty() || key == stream->getTransponderKey()) {
+		return stream;
+	}
+	// Other sessions still watch the current transponder, so move this session
+	// to a stream that is streaming the requested transponder or to a free one
+	const Stream::StreamingType streamingType = stream->getStreamingType();
+	SpStream moveTo;
+	int moveToClientID = 0;
+	for (SpStream other : _stream) {
+		if (other != stream && other->findSharedClientIDFor(socketClient, key, streamingType, moveToClientID)) {
+			moveTo = other;
+			break;
+		}
+	}
+	if (!moveTo) {
+		for (SpStream other : _stream) {
+			if (other != stream && !other->streamInUse() &&
+			    other->findClientIDFor(socketClient, true, sessionID, method, moveToClientID)) {
+				moveTo = other;
+				break;
+			}
+		}
+	}
+	if (!moveTo) {
+		SI_LOG_ERROR("Stream: %d, No free stream to move SessionID %s to %s",
+		             stream->getStreamID(), sessionID.c_str(), key.c_str());
+		return nullptr;
+	}
+	SI_LOG_INFO("Stream: %d, Moving SessionID %s to Stream: %d for %s", stream->getStreamID(),
+	            sessionID.c_str(), moveTo->getStreamID(), key.c_str());
+	moveTo->getStreamClient(moveToClientID).setSessionID(sessionID);
+	moveTo->takeOverSession(moveToClientID, stream->getStreamClient(clientID), streamingType);
+	stream->teardown(clientID);
+	++_sharedMoves;
+	clientID = moveToClientID;
+	return moveTo;
+}
+
 void StreamManager::checkForSessionTimeout() {
-	base::MutexLock lock(_xmlMutex);
+	{
+		base::MutexLock lock(_xmlMutex);
 
-	assert(!_stream.empty());
-	for (SpStream stream : _stream) {
-		if (stream->streamInUse()) {
-			stream->checkForSessionTimeout();
+		assert(!_stream.empty());
+		for (SpStream stream : _stream) {
+			if (stream->streamInUse()) {
+				stream->checkForSessionTimeout();
+			}
 		}
 	}
 }
 
+void StreamManager::preTuneIdleStreams() {
+	SpStream preTuneStream;
+	input::WarmStandby::Transponder preTuneTransponder;
+	{
+		base::MutexLock lock(_xmlMutex);
+		if (!_standby->isEnabled()) {
+			for (SpStream stream : _stream) {
+				stream->releaseStandby();
+			}
+			return;
+		}
+		// Find the idle streams and the transponders they are in standby for
+		StreamVector idle;
+		std::vector<std::string> standbyKeys;
+		for (SpStream stream : _stream) {
+			if (stream->streamEnabled() && !stream->streamInUse()) {
+				idle.push_back(stream);
+				standbyKeys.push_back(stream->getStandbyKey());
+			}
+		}
+		if (idle.empty()) {
+			return;
+		}
+		const input::WarmStandby::TransponderVector likely = _standby->getMostLikely(idle.size());
+		for (const input::WarmStandby::Transponder &transponder : likely) {
+			if (std::find(standbyKeys.begin(), standbyKeys.end(), transponder.key) != standbyKeys.end() ||
+			    !_standby->mayPreTune(transponder.key)) {
+				continue;
+			}
+			// Use an idle stream that is not in standby for one of the likely transponders
+			for (std::size_t i = 0; i < idle.size(); ++i) {
+				const bool likelyKey = std::find_if(likely.begin(), likely.end(),
+					[&](const input::WarmStandby::Transponder &t) {
+						return t.key == standbyKeys[i];
+					}) != likely.end();
+				if (!likelyKey && idle[i]->getInputDevice()->capableOf(transponder.msys)) {
+					preTuneStream = idle[i];
+					preTuneTransponder = transponder;
+					break;
+				}
+			}
+			if (preTuneStream) {
+				break;
+			}
+		}
+	}
+	// Tune outside the lock, it takes some time. Only one per call
+	if (preTuneStream) {
+		const bool locked = preTuneStream->preTune(preTuneTransponder.query);
+		_standby->setPreTuned(preTuneTransponder.key, locked);
+	}
+}
+
+void StreamManager::updateHeadend() {
+	StreamVector streams;
+	{
+		base::MutexLock lock(_xmlMutex);
+		streams = _stream;
+	}
+	// Tune outside the lock, it takes some time
+	_headend->update(streams);
+}
+
 std::string StreamManager::attributeDescribeString(const std::size_t stream, bool &active) const {
 	base::MutexLock lock(_xmlMutex);
 
@@ -224,6 +437,15 @@ std::string StreamManager::attributeDescribeString(const std::size_t stream, boo
 //  -- base::XMLSupport --------------------------------------------------
 // =======================================================================
 
+/// Get the TS packets per buffer from @a element, limited to @a max
+static std::size_t parseTSPacketsPerBuffer(const std::string &element, const std::size_t max) {
+	const std::size_t packets = std::stoi(element);
+	if (packets < mpegts::PacketBuffer::MIN_NUMBER_OF_TS_PACKETS || packets > max) {
+		return mpegts::PacketBuffer::NUMBER_OF_TS_PACKETS;
+	}
+	return packets;
+}
+
 void StreamManager::fromXML(const std::string &xml) {
 	base::MutexLock lock(_xmlMutex);
 	std::size_t i = 0;
@@ -235,8 +457,39 @@ void StreamManager::fromXML(const std::string &xml) {
 		}
 		++i;
 	}
-#ifdef LIBDVBCSA
 	std::string element;
+	if (findXMLElement(xml, "inputreactor", element)) {
+		_reactor->fromXML(element);
+	}
+	if (findXMLElement(xml, "packetpool", element)) {
+		_pool->fromXML(element);
+	}
+	if (findXMLElement(xml, "warmstandby", element)) {
+		{
+			std::unique_lock<std::mutex> lock(_standbyMutex);
+			_standby->fromXML(element);
+		}
+		_standbyChanged.notify_all();
+	}
+	if (findXMLElement(xml, "headend", element)) {
+		_headend->fromXML(element);
+	}
+	if (findXMLElement(xml, "transpondersharing.enable.value", element)) {
+		_transponderSharing = (element == "true") ? true : false;
+	}
+	if (findXMLElement(xml, "packetbuffer.rtp.value", element)) {
+		_rtpTSPackets = parseTSPacketsPerBuffer(element, mpegts::PacketBuffer::JUMBO_NUMBER_OF_TS_PACKETS);
+	}
+	if (findXMLElement(xml, "packetbuffer.rtptcp.value", element)) {
+		_rtpTcpTSPackets = parseTSPacketsPerBuffer(element, mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS);
+	}
+	if (findXMLElement(xml, "packetbuffer.http.value", element)) {
+		_httpTSPackets = parseTSPacketsPerBuffer(element, mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS);
+	}
+	for (SpStream stream : _stream) {
+		stream->setTSPacketsPerBuffer(_rtpTSPackets, _rtpTcpTSPackets, _httpTSPackets);
+	}
+#ifdef LIBDVBCSA
 	if (findXMLElement(xml, "decrypt", element)) {
 		_decrypt->fromXML(element);
 	}
@@ -252,6 +505,25 @@ void StreamManager::addToXML(std::string &xml) const {
 		ADD_XML_N_ELEMENT(xml, "stream", i, stream->toXML());
 		++i;
 	}
+	ADD_XML_ELEMENT(xml, "inputreactor", _reactor->toXML());
+	ADD_XML_ELEMENT(xml, "packetpool", _pool->toXML());
+	ADD_XML_ELEMENT(xml, "warmstandby", _standby->toXML());
+	ADD_XML_ELEMENT(xml, "headend", _headend->toXML());
+
+	std::string sharing;
+	ADD_XML_CHECKBOX(sharing, "enable", (_transponderSharing ? "true" : "false"));
+	ADD_XML_ELEMENT(sharing, "attaches", _sharedAttaches);
+	ADD_XML_ELEMENT(sharing, "moves", _sharedMoves);
+	ADD_XML_ELEMENT(xml, "transpondersharing", sharing);
+
+	std::string packetBuffer;
+	ADD_XML_NUMBER_INPUT(packetBuffer, "rtp", _rtpTSPackets,
+		mpegts::PacketBuffer::MIN_NUMBER_OF_TS_PACKETS, mpegts::PacketBuffer::JUMBO_NUMBER_OF_TS_PACKETS);
+	ADD_XML_NUMBER_INPUT(packetBuffer, "rtptcp", _rtpTcpTSPackets,
+		mpegts::PacketBuffer::MIN_NUMBER_OF_TS_PACKETS, mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS);
+	ADD_XML_NUMBER_INPUT(packetBuffer, "http", _httpTSPackets,
+		mpegts::PacketBuffer::MIN_NUMBER_OF_TS_PACKETS, mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS);
+	ADD_XML_ELEMENT(xml, "packetbuffer", packetBuffer);
 #ifdef LIBDVBCSA
 	ADD_XML_ELEMENT(xml, "decrypt", _decrypt->toXML());
 #endif
@@ -21,8 +21,11 @@
 #define STREAM_MANAGER_H_INCLUDE STREAM_MANAGER_H_INCLUDE
 
 #include <FwDecl.h>
+#include <base/Thread.h>
 #include <base/XMLSupport.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -32,6 +35,10 @@ FW_DECL_NS0(SocketClient);
 FW_DECL_VECTOR_NS0(Stream);
 
 FW_DECL_SP_NS2(decrypt, dvbapi, Client);
+FW_DECL_SP_NS1(input, InputReactor);
+FW_DECL_SP_NS1(input, WarmStandby);
+FW_DECL_SP_NS1(mpegts, PacketBufferPool);
+FW_DECL_SP_NS1(output, Headend);
 FW_DECL_SP_NS2(input, dvb, FrontendDecryptInterface);
 
 /// The class @c StreamManager manages all the available/open streams
@@ -79,6 +86,30 @@ class StreamManager :
 		///
 		void checkForSessionTimeout();
 
+	private:
+
+		/// Move the session of @a clientID to a free stream, when it requests
+		/// another transponder while other sessions still share @a stream
+		/// @return the stream the session is using now, or nullptr if the
+		/// session could not be moved
+		SpStream moveSharedSession(
+			SpStream stream,
+			SocketClient &socketClient,
+			const std::string &sessionID,
+			const std::string &method,
+			int &clientID);
+
+		/// Pre-tune one idle stream to the most likely requested transponder
+		/// that has no stream in standby yet, when warm standby is enabled.
+		/// Called from the warm standby thread
+		void preTuneIdleStreams();
+
+		/// Start, check and restart the headend channels on the streams.
+		/// Called from the headend thread
+		void updateHeadend();
+
+	public:
+
 		///
 		std::string getXMLDeliveryString() const;
 
@@ -111,6 +142,21 @@ class StreamManager :
 	private:
 
 		decrypt::dvbapi::SpClient _decrypt;
+		input::SpInputReactor _reactor;
+		mpegts::SpPacketBufferPool _pool;
+		input::SpWarmStandby _standby;
+		base::Thread _standbyThread;
+		std::mutex _standbyMutex;
+		std::condition_variable _standbyChanged; /// warm standby settings changed or stopping
+		bool _standbyStopping;
+		output::SpHeadend _headend;
+		base::Thread _headendThread;
+		bool _transponderSharing;        /// attach sessions to a stream on the same transponder
+		std::size_t _sharedAttaches;     /// sessions attached to an already tuned stream
+		std::size_t _sharedMoves;        /// sessions moved to a free stream for another transponder
+		std::size_t _rtpTSPackets;       /// TS packets per buffer for RTP/UDP
+		std::size_t _rtpTcpTSPackets;    /// TS packets per buffer for RTP/TCP
+		std::size_t _httpTSPackets;      /// TS packets per buffer for HTTP
 		StreamVector _stream;
 };
 
@@ -92,6 +92,57 @@ namespace base {
 		}
 	}
 
+	bool M3UParser::readEntries(const std::string &filePath, EntryVector &entries) {
+		std::ifstream file;
+		file.open(filePath);
+		if (!file.is_open()) {
+			SI_LOG_ERROR("Error: could not open file: %s", filePath.c_str());
+			return false;
+		}
+		std::string line;
+		// first line should be '#EXTM3U'
+		if (!std::getline(file, line) || line.find("#EXTM3U") == std::string::npos) {
+			SI_LOG_ERROR("Error: not an M3U file: %s", filePath.c_str());
+			return false;
+		}
+		Entry entry;
+		bool extinf = false;
+		while (std::getline(file, line)) {
+			line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+			if (line.empty()) {
+				continue;
+			}
+			if (line.find("#EXTINF") == 0) {
+				// #EXTINF:<duration> <key>="<value>" ...,<title>
+				entry = Entry();
+				extinf = true;
+				std::string::size_type pos = 0;
+				for (;;) {
+					const std::string::size_type quote = line.find("=\"", pos);
+					const std::string::size_type comma = line.find(',', pos);
+					if (quote == std::string::npos || (comma != std::string::npos && comma < quote)) {
+						if (comma != std::string::npos) {
+							entry.title = line.substr(comma + 1);
+						}
+						break;
+					}
+					const std::string::size_type begin = line.find_last_of(" :", quote) + 1;
+					const std::string::size_type end = line.find('"', quote + 2);
+					if (end == std::string::npos) {
+						break;
+					}
+					entry.attribute[line.substr(begin, quote - begin)] = line.substr(quote + 2, end - quote - 2);
+					pos = end + 1;
+				}
+			} else if (line[0] != '#' && extinf) {
+				entry.uri = line;
+				entries.push_back(entry);
+				extinf = false;
+			}
+		}
+		return true;
+	}
+
 	bool M3UParser::findURIFor(double freq, std::string &uri) const {
 		const auto uriMap = _transformationMap.find(freq);
 		if(uriMap != _transformationMap.end()) {
@@ -25,6 +25,8 @@
 
 #include <fstream>
 #include <map>
+#include <string>
+#include <vector>
 
 namespace base {
 
@@ -33,6 +35,14 @@ namespace base {
 		public:
 			using TransformationMap = std::map<double, std::string>;
 
+			/// An entry of an M3U file, the '#EXTINF' line and the URI after it
+			struct Entry {
+				std::map<std::string, std::string> attribute; /// attributes like satip-freq="..."
+				std::string title;
+				std::string uri;
+			};
+			using EntryVector = std::vector<Entry>;
+
 			// =======================================================================
 			//  -- Constructors and destructor ---------------------------------------
 			// =======================================================================
@@ -58,6 +68,13 @@ namespace base {
 			/// @retval
 			bool findURIFor(double freq, std::string &uri) const;
 
+			/// Read all the entries of an M3U file, with their attributes
+			/// @param filePath
+			/// @param entries the entries found in the file
+			/// @retval true specifies the file is red, false means it could
+			/// not be opened or it is not an M3U file
+			static bool readEntries(const std::string &filePath, EntryVector &entries);
+
 			/// Check if the requested frequency can be transformed
 			/// @retval true means the frequency can be used for
 			/// transformation
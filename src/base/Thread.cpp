@@ -67,25 +67,40 @@ namespace base {
 		if (_state == State::Unknown) {
 			return;
 		}
-		_state = State::Stopping;
-		size_t timeout = 0u;
-		while (_state != State::Stopped) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-			++timeout;
-			if (timeout > 50u) {
-				cancelThread();
-				SI_LOG_DEBUG("%s: Thread did not stop within timeout?  !!TIMEOUT!!", _name.c_str());
-				break;
-			}
+		setState(State::Stopping);
+		std::unique_lock<std::mutex> lock(_stateMutex);
+		if (!_stateChanged.wait_for(lock, std::chrono::seconds(5),
+				[this] { return _state == State::Stopped; })) {
+			lock.unlock();
+			cancelThread();
+			SI_LOG_DEBUG("%s: Thread did not stop within timeout?  !!TIMEOUT!!", _name.c_str());
 		}
 	}
 
 	void Thread::pauseThread() {
-		_state = State::Pausing;
+		setState(State::Pausing);
 	}
 
 	void Thread::restartThread() {
-		_state = State::Starting;
+		setState(State::Starting);
+	}
+
+	void Thread::setState(const State state) {
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			_state = state;
+		}
+		_stateChanged.notify_all();
+	}
+
+	void Thread::changeState(State from, const State to) {
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			if (!_state.compare_exchange_strong(from, to)) {
+				return;
+			}
+		}
+		_stateChanged.notify_all();
 	}
 
 	void Thread::terminateThread() {
@@ -166,23 +181,25 @@ namespace base {
 		for (;;) {
 			switch (_state) {
 				case State::Starting:
-					_state = State::Started;
+					changeState(State::Starting, State::Started);
 					break;
 				case State::Started:
 					if (!_threadExecuteFunction()) {
-						_state = State::Stopping;
+						changeState(State::Started, State::Stopping);
 					}
 					break;
 				case State::Pausing:
-					_state = State::Paused;
+					changeState(State::Pausing, State::Paused);
 					break;
-				case State::Paused:
-					// Do nothing here, just wait
-					std::this_thread::sleep_for(std::chrono::milliseconds(150));
+				case State::Paused: {
+						// Do nothing here, just wait until restarted or stopped
+						std::unique_lock<std::mutex> lock(_stateMutex);
+						_stateChanged.wait(lock, [this] { return _state != State::Paused; });
+					}
 					break;
 				case State::Stopping:
-					_state = State::Stopped;
-					break;
+					setState(State::Stopped);
+					return;
 				case State::Stopped:
 					return;
 				default:
@@ -22,7 +22,9 @@
 
 #include <string>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 
 #include <pthread.h>
 
@@ -70,7 +72,7 @@ class Thread {
 		void stopThread();
 
 		/// Pause the running thread, it will not call 'threadExecuteFunction'
-		/// but will enter a sleep (150ms) loop
+		/// but will wait until it is restarted or stopped
 		void pauseThread();
 
 		///
@@ -124,7 +126,17 @@ class Thread {
 			Pausing,
 			Paused
 		};
+
+		/// Set the new state and wake up the ones waiting on a state change
+		void setState(State state);
+
+		/// Change the state from @a from into @a to, but only if it was not
+		/// changed by another thread in the meantime
+		void changeState(State from, State to);
+
 		std::atomic<State> _state;
+		std::mutex _stateMutex;
+		std::condition_variable _stateChanged;
 
 		pthread_t        _thread;
 		std::string      _name;
@@ -68,15 +68,12 @@ namespace base {
 
 	void ThreadBase::stopThread() {
 		_run = false;
-		size_t timeout = 0u;
-		while (!_exit) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-			++timeout;
-			if (timeout > 50u) {
-				cancelThread();
-				SI_LOG_DEBUG("%s: Thread did not stop within timeout?  !!TIMEOUT!!", _name.c_str());
-				break;
-			}
+		wakeUpThread();
+		std::unique_lock<std::mutex> lock(_exitMutex);
+		if (!_exited.wait_for(lock, std::chrono::seconds(5), [this] { return _exit.load(); })) {
+			lock.unlock();
+			cancelThread();
+			SI_LOG_DEBUG("%s: Thread did not stop within timeout?  !!TIMEOUT!!", _name.c_str());
 		}
 	}
 
@@ -145,7 +142,11 @@ namespace base {
 		prctl(PR_SET_NAME, _name.c_str(), 0, 0, 0);
 #endif
 		threadEntry();
-		_exit = true;
+		{
+			std::unique_lock<std::mutex> lock(_exitMutex);
+			_exit = true;
+		}
+		_exited.notify_all();
 	}
 
 } // namespace base
@@ -23,6 +23,8 @@
 #include <pthread.h>
 #include <string>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace base {
 
@@ -111,6 +113,11 @@ namespace base {
 			/// thread entry, do not leave this function
 			virtual void threadEntry() = 0;
 
+			/// Called by @c stopThread after @c running became false. A thread
+			/// that waits on something else than a short timeout should be
+			/// woken up here, so it stops without delay
+			virtual void wakeUpThread() {}
+
 		private:
 			static void * threadEntryFunc(void *arg) {(static_cast<ThreadBase *>(arg))->threadEntryBase(); return nullptr;}
 
@@ -123,6 +130,8 @@ namespace base {
 			std::atomic_bool _run;
 			std::atomic_bool _exit;
 			std::string      _name;
+			std::mutex       _exitMutex;
+			std::condition_variable _exited;
 	};
 
 } // namespace base
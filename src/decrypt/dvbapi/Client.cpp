@@ -77,6 +77,8 @@ namespace dvbapi {
 		_rewritePMT(false),
 		_serverPort(15011),
 		_adapterOffset(0),
+		_batchFlushTimeout(100),
+		_batchFlushes(0),
 		_serverIPAddr("127.0.0.1"),
 		_serverName("Not connected"),
 		_streamManager(streamManager) {
@@ -186,6 +188,26 @@ namespace dvbapi {
 					}
 				}
 			}
+			flushExpiredBatch(streamID, *frontend);
+		}
+	}
+
+	void Client::flushExpiredBatch(const int streamID) {
+		const input::dvb::SpFrontendDecryptInterface frontend = _streamManager.getFrontendDecryptInterface(streamID);
+		if (frontend != nullptr) {
+			flushExpiredBatch(streamID, *frontend);
+		}
+	}
+
+	void Client::flushExpiredBatch(const int streamID, input::dvb::FrontendDecryptInterface &frontend) {
+		// On low bitrate services a batch fills slowly and holds back all
+		// buffers behind it, so do not let it wait longer than the timeout
+		const int timeout = _batchFlushTimeout;
+		const int countBatch = frontend.getBatchCount();
+		if (timeout > 0 && countBatch > 0 && frontend.getBatchAge() >= static_cast<unsigned int>(timeout)) {
+			SI_LOG_DEBUG("Stream: %d, Batch flush timeout, decrypting batch size %d", streamID, countBatch);
+			frontend.decryptBatch(false);
+			++_batchFlushes;
 		}
 	}
 
@@ -546,6 +568,9 @@ namespace dvbapi {
 		if (findXMLElement(xml, "RewritePMT.value", element)) {
 			_rewritePMT = (element == "true") ? true : false;
 		}
+		if (findXMLElement(xml, "BatchFlushTimeout.value", element)) {
+			_batchFlushTimeout = std::stoi(element.c_str());
+		}
 	}
 
 	void Client::addToXML(std::string &xml) const {
@@ -556,6 +581,8 @@ namespace dvbapi {
 		ADD_XML_IP_INPUT(xml, "OSCamIP", _serverIPAddr);
 		ADD_XML_NUMBER_INPUT(xml, "OSCamPORT", _serverPort.load(), 0, 65535);
 		ADD_XML_NUMBER_INPUT(xml, "AdapterOffset", _adapterOffset.load(), 0, 128);
+		ADD_XML_NUMBER_INPUT(xml, "BatchFlushTimeout", _batchFlushTimeout.load(), 0, 1000);
+		ADD_XML_ELEMENT(xml, "BatchFlushes", _batchFlushes.load());
 		ADD_XML_ELEMENT(xml, "OSCamServerName", _serverName);
 	}
 
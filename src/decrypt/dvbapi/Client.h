@@ -26,6 +26,7 @@
 #include <socket/SocketClient.h>
 
 #include <atomic>
+#include <cstdint>
 #include <string>
 
 FW_DECL_NS0(StreamManager);
@@ -78,6 +79,10 @@ class Client :
 		///
 		void decrypt(int streamID, mpegts::PacketBuffer &buffer);
 
+		/// Decrypt the partial batch of this stream when its oldest TS packet
+		/// waited longer than the batch flush timeout
+		void flushExpiredBatch(int streamID);
+
 		///
 		bool stopDecrypt(int streamID);
 
@@ -89,6 +94,9 @@ class Client :
 			const std::string &ipAddr,
 			int port);
 
+		///
+		void flushExpiredBatch(int streamID, input::dvb::FrontendDecryptInterface &frontend);
+
 		///
 		void sendClientInfo();
 
@@ -110,6 +118,8 @@ class Client :
 		std::atomic_bool _rewritePMT;
 		std::atomic<int> _serverPort;
 		std::atomic<int> _adapterOffset;
+		std::atomic<int> _batchFlushTimeout;    /// ms, 0 = only decrypt full batches
+		std::atomic<uint64_t> _batchFlushes;
 		std::string      _serverIPAddr;
 		std::string      _serverName;
 
@@ -21,6 +21,7 @@
 
 #include <Utils.h>
 #include <Unused.h>
+#include <StringConverter.h>
 
 extern "C" {
 	#include <dvbcsa/dvbcsa.h>
@@ -29,6 +30,11 @@ extern "C" {
 namespace decrypt {
 namespace dvbapi {
 
+	constexpr std::size_t ClientProperties::DECRYPT_LATENCY_BUCKETS;
+
+	/// Upper limits (ms) of the decrypt latency buckets, last bucket is the rest
+	static const unsigned int DECRYPT_LATENCY_LIMIT[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
 	// ===========================================================================
 	// -- Constructors and destructor --------------------------------------------
 	// ===========================================================================
@@ -39,6 +45,11 @@ namespace dvbapi {
 		_ts = new dvbcsa_bs_batch_s[_batchSize + 1];
 		_batchCount = 0;
 		_parity = 0;
+		static_assert(N_ELEMENTS(DECRYPT_LATENCY_LIMIT) + 1 == DECRYPT_LATENCY_BUCKETS,
+			"Decrypt latency limits do not match the buckets");
+		for (std::size_t i = 0; i < DECRYPT_LATENCY_BUCKETS; ++i) {
+			_decryptLatency[i] = 0;
+		}
 	}
 
 	ClientProperties::~ClientProperties() {
@@ -61,6 +72,9 @@ namespace dvbapi {
 
 	void ClientProperties::setBatchData(unsigned char *ptr, int len,
 		int parity, unsigned char *originalPtr) {
+		if (_batchCount == 0) {
+			_batchStart = std::chrono::steady_clock::now();
+		}
 		_batch[_batchCount].data = ptr;
 		_batch[_batchCount].len  = len;
 		_ts[_batchCount].data = originalPtr;
@@ -69,9 +83,16 @@ namespace dvbapi {
 	}
 
 	void ClientProperties::decryptBatch(bool final) {
+		const unsigned int latency = getBatchAge();
+		std::size_t bucket = 0;
+		while (bucket < N_ELEMENTS(DECRYPT_LATENCY_LIMIT) && latency >= DECRYPT_LATENCY_LIMIT[bucket]) {
+			++bucket;
+		}
+		++_decryptLatency[bucket];
+
+		// terminate batch buffer
+		setBatchData(nullptr, 0, _parity, nullptr);
 		if (_keys.get(_parity) != nullptr) {
-			// terminate batch buffer
-			setBatchData(nullptr, 0, _parity, nullptr);
 			// decrypt it
 			dvbcsa_bs_decrypt(_keys.get(_parity), _batch, 184);
 
@@ -102,6 +123,46 @@ namespace dvbapi {
 		_batchCount = 0;
 	}
 
+	unsigned int ClientProperties::getBatchAge() const {
+		if (_batchCount == 0) {
+			return 0;
+		}
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - _batchStart).count();
+	}
+
+	std::string ClientProperties::getDecryptLatencyPercentiles() const {
+		uint64_t count[DECRYPT_LATENCY_BUCKETS];
+		uint64_t total = 0;
+		for (std::size_t i = 0; i < DECRYPT_LATENCY_BUCKETS; ++i) {
+			count[i] = _decryptLatency[i];
+			total += count[i];
+		}
+		if (total == 0) {
+			return "-";
+		}
+		std::string percentiles;
+		static const unsigned int PERCENTILE[] = { 50, 90, 99 };
+		for (std::size_t p = 0; p < N_ELEMENTS(PERCENTILE); ++p) {
+			uint64_t sum = 0;
+			std::size_t bucket = 0;
+			for (; bucket < DECRYPT_LATENCY_BUCKETS - 1; ++bucket) {
+				sum += count[bucket];
+				if (sum * 100 >= total * PERCENTILE[p]) {
+					break;
+				}
+			}
+			if (bucket < N_ELEMENTS(DECRYPT_LATENCY_LIMIT)) {
+				percentiles += StringConverter::stringFormat("p%1: &lt;%2ms, ", PERCENTILE[p], DECRYPT_LATENCY_LIMIT[bucket]);
+			} else {
+				percentiles += StringConverter::stringFormat("p%1: &gt;=%2ms, ", PERCENTILE[p],
+					DECRYPT_LATENCY_LIMIT[N_ELEMENTS(DECRYPT_LATENCY_LIMIT) - 1]);
+			}
+		}
+		percentiles += StringConverter::stringFormat("batches: %1", total);
+		return percentiles;
+	}
+
 	void ClientProperties::setECMInfo(
 		int UNUSED(pid),
 		int UNUSED(serviceID),
@@ -26,6 +26,11 @@
 #include <decrypt/dvbapi/Filter.h>
 #include <decrypt/dvbapi/Keys.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
 FW_DECL_NS0(dvbcsa_bs_batch_s);
 
 namespace decrypt {
@@ -75,6 +80,13 @@ namespace dvbapi {
 			/// on failure it will make a NULL TS Packet and clear scramble flag
 			void decryptBatch(bool final);
 
+			/// Get the age of the oldest TS packet waiting in this decrypt batch
+			/// @return the age in ms, or 0 when the batch is empty
+			unsigned int getBatchAge() const;
+
+			/// Get the percentiles of the time TS packets waited in a decrypt batch
+			std::string getDecryptLatencyPercentiles() const;
+
 			/// Set the 'next' key for the requested parity
 			void setKey(const unsigned char *cw, int parity, int index) {
 				_keys.set(cw, parity, index);
@@ -129,6 +141,9 @@ namespace dvbapi {
 			int _batchSize;
 			int _batchCount;
 			int _parity;
+			std::chrono::steady_clock::time_point _batchStart;
+			static constexpr std::size_t DECRYPT_LATENCY_BUCKETS = 11;
+			std::atomic<uint64_t> _decryptLatency[DECRYPT_LATENCY_BUCKETS]; /// age of oldest packet per batch
 			Keys _keys;
 			Filter _oscamFilter;
 
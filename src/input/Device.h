@@ -28,6 +28,9 @@
 
 #include <string>
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 FW_DECL_NS1(mpegts, PacketBuffer);
 
 FW_DECL_SP_NS1(input, Device);
@@ -43,9 +46,15 @@ namespace input {
 			// =======================================================================
 			//  -- Constructors and destructor ---------------------------------------
 			// =======================================================================
-			Device(int streamID) : _streamID(streamID) {}
-
-			virtual ~Device() {}
+			Device(int streamID) :
+				_streamID(streamID),
+				_fd_wake(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+			virtual ~Device() {
+				if (_fd_wake != -1) {
+					::close(_fd_wake);
+				}
+			}
 
 			// =======================================================================
 			//  -- Other member functions --------------------------------------------
@@ -65,10 +74,24 @@ namespace input {
 			/// Check if there is data to be red from this device
 			virtual bool isDataAvailable() = 0;
 
+			/// Wake up a thread waiting in @c isDataAvailable, so it sees a
+			/// change of the streaming state at once instead of after the poll
+			/// timeout. The device should watch @c _fd_wake while waiting
+			void wakeUp() {
+				::eventfd_write(_fd_wake, 1);
+			}
+
 			/// Read the available data from this device
 			/// @param buffer
 			virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) = 0;
 
+			/// Get the file descriptor that becomes readable when there is data
+			/// available, so it can be watched by an @c InputReactor
+			/// @return the file descriptor or -1 if this device can not be watched
+			virtual int getInputFileDescriptor() const {
+				return -1;
+			}
+
 			/// Check the capability of this device
 			/// @param system
 			virtual bool capableOf(input::InputSystem system) const = 0;
@@ -85,6 +108,12 @@ namespace input {
 			///
 			virtual bool hasDeviceDataChanged() const = 0;
 
+			/// Check if this device had a signal lock with the last call to
+			/// @c monitorSignal. Devices without a signal are always locked
+			virtual bool hasLock() const {
+				return true;
+			}
+
 			/// Parse the input/request string from client.
 			///   For example:
 			///   rtsp://ip.of.your.box/?fe=3&freq=170&sr=6900&msys=dvbc&mtype=256qam&fec=35&addpids=0,1,16,17
@@ -98,6 +127,24 @@ namespace input {
 			/// Teardown/Stop this device
 			virtual bool teardown() = 0;
 
+			/// Stop this device, but keep it tuned to the current transponder
+			/// when the device supports it (warm standby)
+			virtual bool standby() {
+				return teardown();
+			}
+
+			/// Get the transponder key (see @c WarmStandby) this device is
+			/// still tuned to in standby, or an empty string if not in standby
+			virtual std::string getStandbyKey() const {
+				return "";
+			}
+
+			/// Get the transponder key (see @c WarmStandby) this device is
+			/// tuned to for streaming, or an empty string if not tuned
+			virtual std::string getTransponderKey() const {
+				return "";
+			}
+
 			///
 			virtual std::string attributeDescribeString() const = 0;
 
@@ -128,6 +175,15 @@ namespace input {
 
 			mpegts::Filter _filter;
 
+			/// Readable after @c wakeUp, read it with @c clearWakeUp
+			int _fd_wake;
+
+			/// Clear the wake up, after @c _fd_wake became readable
+			void clearWakeUp() {
+				eventfd_t value;
+				::eventfd_read(_fd_wake, &value);
+			}
+
 	};
 
 } // namespace input
@@ -0,0 +1,302 @@
+/* InputReactor.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <input/InputReactor.h>
+
+#include <Log.h>
+#include <Utils.h>
+#include <StringConverter.h>
+#include <base/ThreadBase.h>
+
+#include <sys/epoll.h>
+
+namespace input {
+
+	constexpr std::size_t InputReactor::MAX_WORKERS;
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	InputReactor::InputReactor() :
+		_enabled(false),
+		_workers(0),
+		_dispatches(0) {}
+
+	InputReactor::~InputReactor() {
+		stopWorkers();
+		for (HandlerMap::iterator it = _handler.begin(); it != _handler.end(); ++it) {
+			DELETE(it->second);
+		}
+	}
+
+	// =======================================================================
+	//  -- base::XMLSupport --------------------------------------------------
+	// =======================================================================
+
+	void InputReactor::addToXML(std::string &xml) const {
+		std::unique_lock<std::mutex> lock(_mutex);
+		ADD_XML_CHECKBOX(xml, "enable", (_enabled ? "true" : "false"));
+		ADD_XML_NUMBER_INPUT(xml, "workers", _workers, 0, MAX_WORKERS);
+		ADD_XML_ELEMENT(xml, "workersRunning", _shard.size());
+		ADD_XML_ELEMENT(xml, "devices", _handler.size());
+		ADD_XML_ELEMENT(xml, "dispatches", _dispatches.load());
+	}
+
+	void InputReactor::fromXML(const std::string &xml) {
+		std::vector<Shard> shard;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			std::string element;
+			if (findXMLElement(xml, "enable.value", element)) {
+				_enabled = (element == "true") ? true : false;
+			}
+			if (findXMLElement(xml, "workers.value", element)) {
+				const std::size_t workers = std::stoi(element);
+				_workers = (workers <= MAX_WORKERS) ? workers : 0;
+			}
+			// When idle, stop the workers so a new configuration is used
+			// with the next device that is added
+			if (_handler.empty()) {
+				shard.swap(_shard);
+			}
+		}
+		for (Shard &s : shard) {
+			s.thread->terminateThread();
+			CLOSE_FD(s.fd_epoll);
+		}
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	bool InputReactor::isEnabled() const {
+		std::unique_lock<std::mutex> lock(_mutex);
+		return _enabled;
+	}
+
+	bool InputReactor::add(const int fd, FunctionInputReady inputReady) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (!_enabled || fd == -1 || !startWorkers()) {
+			return false;
+		}
+		if (_handler.find(fd) != _handler.end()) {
+			SI_LOG_ERROR("InputReactor: fd %d already added", fd);
+			return false;
+		}
+		// Find the least busy shard
+		std::size_t index = 0;
+		for (std::size_t i = 1; i < _shard.size(); ++i) {
+			if (_shard[i].handlers < _shard[index].handlers) {
+				index = i;
+			}
+		}
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLONESHOT;
+		event.data.u64 = 0;
+		event.data.fd = fd;
+		if (::epoll_ctl(_shard[index].fd_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+			PERROR("InputReactor: EPOLL_CTL_ADD fd %d", fd);
+			return false;
+		}
+		Handler *handler = new Handler;
+		handler->fd = fd;
+		handler->shard = index;
+		handler->inputReady = inputReady;
+		handler->busy = false;
+		handler->removed = false;
+		handler->waiting = false;
+		handler->resume = false;
+		_handler[fd] = handler;
+		++_shard[index].handlers;
+		SI_LOG_DEBUG("InputReactor: Added fd %d to worker %zu", fd, index);
+		return true;
+	}
+
+	void InputReactor::remove(const int fd) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		HandlerMap::iterator it = _handler.find(fd);
+		if (it == _handler.end()) {
+			return;
+		}
+		Handler *handler = it->second;
+		handler->removed = true;
+		// fd might be closed already, then it is removed from epoll by the kernel
+		::epoll_ctl(_shard[handler->shard].fd_epoll, EPOLL_CTL_DEL, fd, nullptr);
+
+		// wait until the worker is finished with this handler
+		_idle.wait(lock, [handler] { return !handler->busy; });
+
+		--_shard[handler->shard].handlers;
+		_handler.erase(it);
+		DELETE(handler);
+		SI_LOG_DEBUG("InputReactor: Removed fd %d", fd);
+	}
+
+	void InputReactor::resume(const int fd) {
+		std::unique_lock<std::mutex> lock(_mutex);
+		HandlerMap::iterator it = _handler.find(fd);
+		if (it == _handler.end() || it->second->removed) {
+			return;
+		}
+		Handler *handler = it->second;
+		if (handler->busy) {
+			// the worker will re-arm it when finished
+			handler->resume = true;
+		} else if (handler->waiting) {
+			handler->waiting = false;
+			rearm(fd, _shard[handler->shard].fd_epoll);
+		}
+	}
+
+	bool InputReactor::startWorkers() {
+		if (!_shard.empty()) {
+			return true;
+		}
+		std::size_t workers = (_workers == 0) ?
+			base::ThreadBase::getNumberOfProcessorsOnline() : _workers;
+		if (workers == 0 || workers > MAX_WORKERS) {
+			workers = 1;
+		}
+		for (std::size_t i = 0; i < workers; ++i) {
+			Shard shard;
+			shard.handlers = 0;
+			shard.fd_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+			if (shard.fd_epoll == -1) {
+				PERROR("InputReactor: epoll_create1");
+				break;
+			}
+			const int fd_epoll = shard.fd_epoll;
+			shard.thread.reset(new base::Thread(
+				StringConverter::stringFormat("InputReactor%1", i),
+				[this, i, fd_epoll] { return dispatch(i, fd_epoll); }));
+			if (!shard.thread->startThread()) {
+				SI_LOG_ERROR("InputReactor: Unable to start worker %zu", i);
+				CLOSE_FD(shard.fd_epoll);
+				break;
+			}
+			shard.thread->setPriority(base::Thread::Priority::AboveNormal);
+			_shard.push_back(std::move(shard));
+		}
+		SI_LOG_INFO("InputReactor: Started %zu worker(s)", _shard.size());
+		return !_shard.empty();
+	}
+
+	void InputReactor::stopWorkers() {
+		for (Shard &shard : _shard) {
+			shard.thread->terminateThread();
+			CLOSE_FD(shard.fd_epoll);
+		}
+		_shard.clear();
+	}
+
+	bool InputReactor::dispatch(const std::size_t shard, const int fd_epoll) {
+		int timeout;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			timeout = getDispatchTimeout(shard);
+		}
+		struct epoll_event events[16];
+		const int n = ::epoll_wait(fd_epoll, events, N_ELEMENTS(events), timeout);
+		if (n < 0) {
+			if (errno != EINTR) {
+				PERROR("InputReactor: epoll_wait");
+			}
+			return true;
+		}
+		for (int i = 0; i < n; ++i) {
+			const int fd = events[i].data.fd;
+			Handler *handler = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				HandlerMap::iterator it = _handler.find(fd);
+				if (it != _handler.end() && !it->second->removed && it->second->shard == shard) {
+					handler = it->second;
+					handler->busy = true;
+					handler->resume = false;
+				}
+			}
+			if (handler == nullptr) {
+				continue;
+			}
+			const std::chrono::microseconds wait = handler->inputReady();
+			++_dispatches;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				handler->busy = false;
+				if (!handler->removed) {
+					if (wait.count() <= 0 || handler->resume) {
+						rearm(fd, fd_epoll);
+					} else {
+						// The fd is still readable, so do not watch it until the
+						// consumer can take input again
+						handler->waiting = true;
+						handler->resumeTime = std::chrono::steady_clock::now() + wait;
+					}
+				}
+			}
+			_idle.notify_all();
+		}
+		std::unique_lock<std::mutex> lock(_mutex);
+		rearmWaitingHandlers(shard, fd_epoll);
+		return true;
+	}
+
+	void InputReactor::rearm(const int fd, const int fd_epoll) {
+		// we use one-shot so only one worker handles this fd
+		struct epoll_event event;
+		event.events = EPOLLIN | EPOLLONESHOT;
+		event.data.u64 = 0;
+		event.data.fd = fd;
+		if (::epoll_ctl(fd_epoll, EPOLL_CTL_MOD, fd, &event) != 0) {
+			PERROR("InputReactor: EPOLL_CTL_MOD fd %d", fd);
+		}
+	}
+
+	int InputReactor::getDispatchTimeout(const std::size_t shard) const {
+		int timeout = 100;
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		for (HandlerMap::const_iterator it = _handler.begin(); it != _handler.end(); ++it) {
+			const Handler *handler = it->second;
+			if (handler->shard != shard || !handler->waiting) {
+				continue;
+			}
+			// round up, else we wake up just too early
+			const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+				handler->resumeTime - now + std::chrono::microseconds(999)).count();
+			if (wait < timeout) {
+				timeout = (wait > 0) ? wait : 0;
+			}
+		}
+		return timeout;
+	}
+
+	void InputReactor::rearmWaitingHandlers(const std::size_t shard, const int fd_epoll) {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		for (HandlerMap::iterator it = _handler.begin(); it != _handler.end(); ++it) {
+			Handler *handler = it->second;
+			if (handler->shard == shard && handler->waiting && !handler->removed && handler->resumeTime <= now) {
+				handler->waiting = false;
+				rearm(handler->fd, fd_epoll);
+			}
+		}
+	}
+
+} // namespace input
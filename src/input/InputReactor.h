@@ -0,0 +1,157 @@
+/* InputReactor.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef INPUT_INPUTREACTOR_H_INCLUDE
+#define INPUT_INPUTREACTOR_H_INCLUDE INPUT_INPUTREACTOR_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/Thread.h>
+#include <base/XMLSupport.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+FW_DECL_SP_NS1(input, InputReactor);
+
+namespace input {
+
+	/// The class @c InputReactor watches the file descriptors of all input
+	/// devices (DVR, Streamer sockets) with a small set of epoll instances and
+	/// dispatches the ready devices to a few worker threads. The amount of
+	/// workers scales with the amount of processors, not with the devices.
+	class InputReactor :
+		public base::XMLSupport {
+		public:
+
+			/// Called from a worker thread when the registered fd is readable.
+			/// It returns the time to wait before the fd is watched again, 0 to
+			/// watch it at once. A busy consumer that can not take more input
+			/// should wait, a readable fd would wake up the worker right away
+			using FunctionInputReady = std::function<std::chrono::microseconds()>;
+
+			// =======================================================================
+			//  -- Constructors and destructor ---------------------------------------
+			// =======================================================================
+
+			InputReactor();
+
+			virtual ~InputReactor();
+
+			// =======================================================================
+			// -- base::XMLSupport ---------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			virtual void addToXML(std::string &xml) const override;
+
+			virtual void fromXML(const std::string &xml) override;
+
+			// =======================================================================
+			//  -- Other member functions --------------------------------------------
+			// =======================================================================
+
+		public:
+
+			/// Check if the reactor should be used for streaming
+			bool isEnabled() const;
+
+			/// Watch @a fd and call @a inputReady when it is readable. Only one
+			/// worker at a time will call @a inputReady for this fd
+			/// @return true if the fd is watched, false if the caller should
+			/// fall back to its own streaming thread
+			bool add(int fd, FunctionInputReady inputReady);
+
+			/// Stop watching @a fd. When a worker is busy with this fd, this
+			/// function will wait until it is finished
+			void remove(int fd);
+
+			/// Watch @a fd again, before the wait its input ready function asked
+			/// for is over. For instance when its consumer can take input again
+			void resume(int fd);
+
+		private:
+
+			/// Start the worker threads, if not already running
+			bool startWorkers();
+
+			/// Stop all worker threads
+			void stopWorkers();
+
+			/// Thread execute function of one worker
+			bool dispatch(std::size_t shard, int fd_epoll);
+
+			/// Watch @a fd again with @a fd_epoll, it is added with EPOLLONESHOT
+			void rearm(int fd, int fd_epoll);
+
+			/// Get the epoll timeout (ms) of @a shard, so the waiting handlers
+			/// are watched again in time. The lock should be held
+			int getDispatchTimeout(std::size_t shard) const;
+
+			/// Watch the handlers of @a shard again that waited long enough,
+			/// the lock should be held
+			void rearmWaitingHandlers(std::size_t shard, int fd_epoll);
+
+			// =======================================================================
+			// -- Data members -------------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			static constexpr std::size_t MAX_WORKERS = 64;
+
+		private:
+
+			struct Handler {
+				int fd;
+				std::size_t shard;
+				FunctionInputReady inputReady;
+				bool busy;
+				bool removed;
+				bool waiting;               /// not watched until resumeTime
+				bool resume;                /// resume() was called while busy
+				std::chrono::steady_clock::time_point resumeTime;
+			};
+			using HandlerMap = std::map<int, Handler *>;
+
+			struct Shard {
+				int fd_epoll;
+				std::size_t handlers;
+				std::unique_ptr<base::Thread> thread;
+			};
+
+			bool _enabled;
+			std::size_t _workers;             /// configured workers, 0 = processors online
+			std::vector<Shard> _shard;
+			HandlerMap _handler;
+			mutable std::mutex _mutex;
+			std::condition_variable _idle;
+			std::atomic<uint64_t> _dispatches;
+	};
+
+} // namespace input
+
+#endif // INPUT_INPUTREACTOR_H_INCLUDE
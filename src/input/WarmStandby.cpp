@@ -0,0 +1,252 @@
+/* WarmStandby.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <input/WarmStandby.h>
+
+#include <Log.h>
+#include <Utils.h>
+#include <StringConverter.h>
+
+#include <algorithm>
+
+#include <linux/dvb/frontend.h>
+
+namespace input {
+
+	constexpr std::size_t WarmStandby::DEFAULT_HISTORY_SIZE;
+	constexpr std::size_t WarmStandby::MAX_HISTORY_SIZE;
+
+	/// Each new request lowers the weight of the older requests with this factor
+	static constexpr double HISTORY_DECAY = 0.95;
+
+	/// Time before the same transponder is pre-tuned again
+	static constexpr std::chrono::seconds PRE_TUNE_RETRY_TIME(60);
+
+	/// The request parameters that are needed to tune, the rest (PIDs) is not
+	/// part of the history
+	static const char *TUNE_PARAMETERS[] = {
+		"freq=", "msys=", "sr=", "pol=", "src=", "plts=", "ro=", "fec=", "mtype=",
+		"specinv=", "bw=", "tmode=", "gi=", "plp=", "t2id=", "sm="
+	};
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	WarmStandby::WarmStandby() :
+		_enabled(false),
+		_historySize(DEFAULT_HISTORY_SIZE),
+		_requests(0),
+		_hits(0),
+		_misses(0),
+		_preTunes(0),
+		_preTuneFails(0) {}
+
+	WarmStandby::~WarmStandby() {}
+
+	// =======================================================================
+	//  -- base::XMLSupport --------------------------------------------------
+	// =======================================================================
+
+	void WarmStandby::addToXML(std::string &xml) const {
+		base::MutexLock lock(_xmlMutex);
+		ADD_XML_CHECKBOX(xml, "enable", (_enabled ? "true" : "false"));
+		ADD_XML_NUMBER_INPUT(xml, "historysize", _historySize, 1, MAX_HISTORY_SIZE);
+		ADD_XML_ELEMENT(xml, "transponders", _history.size());
+		ADD_XML_ELEMENT(xml, "requests", _requests);
+		ADD_XML_ELEMENT(xml, "hits", _hits);
+		ADD_XML_ELEMENT(xml, "misses", _misses);
+		const uint64_t sessions = _hits + _misses;
+		ADD_XML_ELEMENT(xml, "hitrate", (sessions > 0) ? ((_hits * 100) / sessions) : 0);
+		ADD_XML_ELEMENT(xml, "pretunes", _preTunes);
+		ADD_XML_ELEMENT(xml, "pretunefails", _preTuneFails);
+	}
+
+	void WarmStandby::fromXML(const std::string &xml) {
+		base::MutexLock lock(_xmlMutex);
+		std::string element;
+		if (findXMLElement(xml, "enable.value", element)) {
+			_enabled = (element == "true") ? true : false;
+		}
+		if (findXMLElement(xml, "historysize.value", element)) {
+			const std::size_t size = std::stoi(element);
+			_historySize = (size > 0 && size <= MAX_HISTORY_SIZE) ? size : DEFAULT_HISTORY_SIZE;
+		}
+	}
+
+	// =======================================================================
+	//  -- Static member functions -------------------------------------------
+	// =======================================================================
+
+	std::string WarmStandby::makeTransponderKey(const input::InputSystem msys,
+			const uint32_t freq, const char pol, const int src, const int srate,
+			const int modtype, const int plp, const int t2id) {
+		return StringConverter::stringFormat("%1:%2:%3:%4:%5:%6:%7:%8",
+			StringConverter::delsys_to_string(msys), freq, pol, src, srate,
+			StringConverter::modtype_to_sting(modtype), plp, t2id);
+	}
+
+	std::string WarmStandby::getTransponderKey(const std::string &msg, const std::string &method) {
+		const double freq = StringConverter::getDoubleParameter(msg, method, "freq=");
+		if (freq == -1.0) {
+			return "";
+		}
+		// Use the same defaults as FrontendData::initialize()
+		std::string strVal;
+		char pol = 'h';
+		if (StringConverter::getStringParameter(msg, method, "pol=", strVal) && !strVal.empty()) {
+			pol = strVal[0];
+		}
+		const int src = StringConverter::getIntParameter(msg, method, "src=");
+		const int sr = StringConverter::getIntParameter(msg, method, "sr=");
+		const input::InputSystem msys = StringConverter::getMSYSParameter(msg, method);
+		// Same modulation as FrontendData::parseStreamString(), without
+		// 'mtype' guess one according to 'msys'
+		int modtype = QAM_64;
+		if (StringConverter::getStringParameter(msg, method, "mtype=", strVal)) {
+			if (strVal == "8psk") {
+				modtype = PSK_8;
+			} else if (strVal == "qpsk") {
+				modtype = QPSK;
+			} else if (strVal == "16qam") {
+				modtype = QAM_16;
+			} else if (strVal == "256qam") {
+				modtype = QAM_256;
+			}
+		} else if (msys == input::InputSystem::DVBS) {
+			modtype = QPSK;
+		} else if (msys == input::InputSystem::DVBS2) {
+			modtype = PSK_8;
+		} else if (msys == input::InputSystem::DVBT || msys == input::InputSystem::DVBT2 ||
+		           msys == input::InputSystem::DVBC) {
+			modtype = QAM_AUTO;
+		}
+		const int plp = StringConverter::getIntParameter(msg, method, "plp=");
+		const int t2id = StringConverter::getIntParameter(msg, method, "t2id=");
+		return makeTransponderKey(msys, static_cast<uint32_t>(freq * 1000.0), pol,
+			(src != -1) ? src : 1, (sr != -1) ? sr * 1000 : 0, modtype,
+			(plp != -1) ? plp : 0, (t2id != -1) ? t2id : 0);
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	bool WarmStandby::isEnabled() const {
+		base::MutexLock lock(_xmlMutex);
+		return _enabled;
+	}
+
+	void WarmStandby::addRequest(const std::string &msg, const std::string &method) {
+		const std::string key = getTransponderKey(msg, method);
+		if (key.empty()) {
+			return;
+		}
+		std::string query;
+		for (std::size_t i = 0; i < N_ELEMENTS(TUNE_PARAMETERS); ++i) {
+			std::string value;
+			if (StringConverter::getStringParameter(msg, method, TUNE_PARAMETERS[i], value)) {
+				if (!query.empty()) {
+					query += "&";
+				}
+				query += TUNE_PARAMETERS[i] + value;
+			}
+		}
+		base::MutexLock lock(_xmlMutex);
+		++_requests;
+		// Lower the weight of older requests, so recent zaps count more
+		for (EntryMap::iterator it = _history.begin(); it != _history.end(); ++it) {
+			it->second.weight *= HISTORY_DECAY;
+		}
+		EntryMap::iterator it = _history.find(key);
+		if (it == _history.end()) {
+			// History full, then forget the least likely one
+			if (_history.size() >= _historySize) {
+				EntryMap::iterator least = std::min_element(_history.begin(), _history.end(),
+					[](const EntryMap::value_type &a, const EntryMap::value_type &b) {
+						return a.second.weight < b.second.weight;
+					});
+				_history.erase(least);
+			}
+			Entry entry;
+			entry.weight = 0.0;
+			entry.preTuned = false;
+			it = _history.insert(EntryMap::value_type(key, entry)).first;
+		}
+		it->second.weight += 1.0;
+		it->second.query = query;
+		it->second.msys = StringConverter::getMSYSParameter(msg, method);
+	}
+
+	WarmStandby::TransponderVector WarmStandby::getMostLikely(const std::size_t max) const {
+		std::vector<std::pair<double, Transponder>> likely;
+		{
+			base::MutexLock lock(_xmlMutex);
+			for (EntryMap::const_iterator it = _history.begin(); it != _history.end(); ++it) {
+				Transponder transponder;
+				transponder.key = it->first;
+				transponder.query = it->second.query;
+				transponder.msys = it->second.msys;
+				likely.push_back(std::make_pair(it->second.weight, transponder));
+			}
+		}
+		std::sort(likely.begin(), likely.end(),
+			[](const std::pair<double, Transponder> &a, const std::pair<double, Transponder> &b) {
+				return a.first > b.first;
+			});
+		TransponderVector transponders;
+		for (std::size_t i = 0; i < likely.size() && i < max; ++i) {
+			transponders.push_back(likely[i].second);
+		}
+		return transponders;
+	}
+
+	bool WarmStandby::mayPreTune(const std::string &key) const {
+		base::MutexLock lock(_xmlMutex);
+		EntryMap::const_iterator it = _history.find(key);
+		if (it == _history.end()) {
+			return false;
+		}
+		return !it->second.preTuned || Clock::now() - it->second.lastPreTune >= PRE_TUNE_RETRY_TIME;
+	}
+
+	void WarmStandby::setPreTuned(const std::string &key, const bool locked) {
+		base::MutexLock lock(_xmlMutex);
+		++_preTunes;
+		if (!locked) {
+			++_preTuneFails;
+		}
+		EntryMap::iterator it = _history.find(key);
+		if (it != _history.end()) {
+			it->second.preTuned = true;
+			it->second.lastPreTune = Clock::now();
+		}
+	}
+
+	void WarmStandby::addHit() {
+		base::MutexLock lock(_xmlMutex);
+		++_hits;
+	}
+
+	void WarmStandby::addMiss() {
+		base::MutexLock lock(_xmlMutex);
+		++_misses;
+	}
+
+} // namespace input
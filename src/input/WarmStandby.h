@@ -0,0 +1,152 @@
+/* WarmStandby.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef INPUT_WARMSTANDBY_H_INCLUDE
+#define INPUT_WARMSTANDBY_H_INCLUDE INPUT_WARMSTANDBY_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/XMLSupport.h>
+#include <input/InputSystem.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+FW_DECL_SP_NS1(input, WarmStandby);
+
+namespace input {
+
+	/// The class @c WarmStandby keeps a frequency weighted history of the
+	/// requested transponders. With it enabled, idle tuners stay tuned to
+	/// their last transponder, or get pre-tuned to the transponders that are
+	/// most likely requested next, so a new session can skip tuning
+	class WarmStandby :
+		public base::XMLSupport {
+		public:
+
+			/// A transponder from the history
+			struct Transponder {
+				std::string key;              /// see @c makeTransponderKey
+				std::string query;            /// tuning parameters of the request
+				input::InputSystem msys;      /// requested delivery system
+			};
+			using TransponderVector = std::vector<Transponder>;
+
+			// =======================================================================
+			//  -- Constructors and destructor ---------------------------------------
+			// =======================================================================
+
+			WarmStandby();
+
+			virtual ~WarmStandby();
+
+			// =======================================================================
+			// -- base::XMLSupport ---------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			virtual void addToXML(std::string &xml) const override;
+
+			virtual void fromXML(const std::string &xml) override;
+
+			// =======================================================================
+			//  -- Static member functions -------------------------------------------
+			// =======================================================================
+
+		public:
+
+			/// Make the key that identifies a transponder. Besides the frequency
+			/// it includes everything that selects a different TS on it, like
+			/// the modulation and the DVB-T2 PLP and T2 system ID
+			/// @param modtype specifies the modulation as @c fe_modulation
+			static std::string makeTransponderKey(input::InputSystem msys,
+				uint32_t freq, char pol, int src, int srate, int modtype, int plp, int t2id);
+
+			/// Get the transponder key of the requested tuning parameters
+			/// @return the key or an empty string when no frequency is requested
+			static std::string getTransponderKey(const std::string &msg, const std::string &method);
+
+			// =======================================================================
+			//  -- Other member functions --------------------------------------------
+			// =======================================================================
+
+		public:
+
+			/// Check if idle tuners should be kept in standby
+			bool isEnabled() const;
+
+			/// Add the requested transponder to the history
+			void addRequest(const std::string &msg, const std::string &method);
+
+			/// Get the transponders that are most likely requested next
+			/// @param max specifies the maximum amount of transponders to return
+			TransponderVector getMostLikely(std::size_t max) const;
+
+			/// Check if the transponder with @a key may be pre-tuned, which is
+			/// not the case when it was pre-tuned recently
+			bool mayPreTune(const std::string &key) const;
+
+			/// Mark that the transponder with @a key was pre-tuned
+			void setPreTuned(const std::string &key, bool locked);
+
+			/// A new session found a tuner in standby on the requested transponder
+			void addHit();
+
+			/// A new session did not find a tuner in standby for its transponder
+			void addMiss();
+
+			// =======================================================================
+			// -- Data members -------------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			static constexpr std::size_t DEFAULT_HISTORY_SIZE = 32;
+			static constexpr std::size_t MAX_HISTORY_SIZE = 256;
+
+		private:
+
+			using Clock = std::chrono::steady_clock;
+
+			struct Entry {
+				double weight;
+				std::string query;
+				input::InputSystem msys;
+				Clock::time_point lastPreTune;
+				bool preTuned;
+			};
+			using EntryMap = std::map<std::string, Entry>;
+
+			bool _enabled;
+			std::size_t _historySize;
+			EntryMap _history;
+			uint64_t _requests;
+			uint64_t _hits;
+			uint64_t _misses;
+			uint64_t _preTunes;
+			uint64_t _preTuneFails;
+	};
+
+} // namespace input
+
+#endif // INPUT_WARMSTANDBY_H_INCLUDE
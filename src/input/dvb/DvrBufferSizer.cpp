@@ -0,0 +1,170 @@
+/* DvrBufferSizer.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <input/dvb/DvrBufferSizer.h>
+
+namespace input {
+namespace dvb {
+
+	constexpr unsigned int DvrBufferSizer::MIN_SIZE;
+	constexpr unsigned int DvrBufferSizer::START_SIZE;
+	constexpr unsigned int DvrBufferSizer::MIN_LAG_TIME_MS;
+	constexpr unsigned int DvrBufferSizer::MAX_LAG_TIME_MS;
+
+	/// Time without overflow before the buffer may shrink again
+	static constexpr std::chrono::seconds STABLE_TIME(60);
+	/// Time of one bitrate measurement
+	static constexpr std::chrono::seconds MEASURE_TIME(1);
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	DvrBufferSizer::DvrBufferSizer() :
+		_adaptive(false),
+		_maxSize(0),
+		_size(0),
+		_wantedSize(0),
+		_overflows(0),
+		_bytesLost(0),
+		_bitrate(0),
+		_lagMs(0),
+		_overflowPending(false),
+		_windowBytes(0),
+		_windowLagMs(0),
+		_peakLagMs(0),
+		_lagTimeMs(MIN_LAG_TIME_MS * 2) {}
+
+	DvrBufferSizer::~DvrBufferSizer() {}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void DvrBufferSizer::start(const unsigned int size, const unsigned int maxSize, const bool adaptive) {
+		const Clock::time_point now = Clock::now();
+		_adaptive = adaptive;
+		_maxSize = maxSize;
+		_size = size;
+		_wantedSize = size;
+		_overflowPending = false;
+		_windowBytes = 0;
+		_windowLagMs = 0;
+		_peakLagMs = 0;
+		_lagMs = 0;
+		_windowStart = now;
+		_lastRead = now;
+		_lastOverflow = now;
+		_lastChange = now;
+	}
+
+	void DvrBufferSizer::addBytes(const std::size_t bytes) {
+		const Clock::time_point now = Clock::now();
+		const unsigned int lagMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - _lastRead).count();
+		_lastRead = now;
+		// A longer gap means the reader was stopped on purpose, not lagging
+		if (lagMs > _windowLagMs && lagMs <= MAX_LAG_TIME_MS) {
+			_windowLagMs = lagMs;
+		}
+		_windowBytes += bytes;
+	}
+
+	void DvrBufferSizer::addOverflow() {
+		++_overflows;
+		_bytesLost += _size;
+		_overflowPending = true;
+	}
+
+	unsigned int DvrBufferSizer::checkSize() {
+		const Clock::time_point now = Clock::now();
+		const bool overflow = _overflowPending.exchange(false);
+		if (!overflow && now - _windowStart < MEASURE_TIME) {
+			return 0;
+		}
+		// Update the bitrate measurement
+		const uint64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - _windowStart).count();
+		if (elapsedMs >= 100) {
+			_bitrate = (_windowBytes * 1000) / elapsedMs;
+			_lagMs = _windowLagMs;
+			if (_windowLagMs > _peakLagMs) {
+				_peakLagMs = _windowLagMs;
+			}
+			_windowBytes = 0;
+			_windowLagMs = 0;
+			_windowStart = now;
+		}
+		if (!_adaptive) {
+			return 0;
+		}
+		// The reader should be able to lag at least twice the longest time
+		// between two reads, that we measured since the last change
+		const unsigned int measuredLagMs = (_peakLagMs * 2 <= MAX_LAG_TIME_MS) ? _peakLagMs * 2 : MAX_LAG_TIME_MS;
+		const uint64_t measuredSize = (_bitrate * measuredLagMs) / 1000;
+		if (_lagTimeMs < measuredLagMs) {
+			_lagTimeMs = measuredLagMs;
+		}
+		const unsigned int size = _size;
+		const unsigned int wantedSize = _wantedSize;
+		uint64_t newSize = wantedSize;
+		if (overflow) {
+			// Reader is lagging more than expected, so allow more lag and
+			// grow at least twice the current size
+			_lastOverflow = now;
+			_lastChange = now;
+			_peakLagMs = 0;
+			_lagTimeMs = (_lagTimeMs * 2 <= MAX_LAG_TIME_MS) ? _lagTimeMs * 2 : MAX_LAG_TIME_MS;
+			newSize = (_bitrate * _lagTimeMs) / 1000;
+			if (newSize < size * 2ull) {
+				newSize = size * 2ull;
+			}
+		} else if (measuredSize > wantedSize) {
+			// Reader is lagging more than the buffer can hold, so grow at the
+			// next open, before it overflows
+			_lastChange = now;
+			_peakLagMs = 0;
+			newSize = measuredSize;
+		} else if (now - _lastOverflow >= STABLE_TIME && now - _lastChange >= STABLE_TIME) {
+			// Stable for some time, so allow less lag and shrink when we
+			// need only half of the current size
+			_lastChange = now;
+			_peakLagMs = 0;
+			_lagTimeMs = (_lagTimeMs / 2 >= MIN_LAG_TIME_MS) ? _lagTimeMs / 2 : MIN_LAG_TIME_MS;
+			if (_lagTimeMs < measuredLagMs) {
+				_lagTimeMs = measuredLagMs;
+			}
+			const uint64_t needed = (_bitrate * _lagTimeMs) / 1000;
+			if (needed * 2 <= wantedSize) {
+				newSize = needed;
+			}
+		}
+		// Round up to whole MBytes and keep it in range
+		newSize = ((newSize + MIN_SIZE - 1) / MIN_SIZE) * MIN_SIZE;
+		if (newSize > _maxSize) {
+			newSize = _maxSize;
+		}
+		if (newSize < MIN_SIZE) {
+			newSize = MIN_SIZE;
+		}
+		_wantedSize = static_cast<unsigned int>(newSize);
+		// The data is lost already after an overflow, so only then resize now
+		return (overflow && newSize != size) ? static_cast<unsigned int>(newSize) : 0;
+	}
+
+} // namespace dvb
+} // namespace input
@@ -0,0 +1,153 @@
+/* DvrBufferSizer.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef INPUT_DVB_DVRBUFFERSIZER_H_INCLUDE
+#define INPUT_DVB_DVRBUFFERSIZER_H_INCLUDE INPUT_DVB_DVRBUFFERSIZER_H_INCLUDE
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace input {
+namespace dvb {
+
+	/// The class @c DvrBufferSizer keeps track of the DVR buffer overflows,
+	/// the transponder bitrate and the consumer lag. The consumer lag is the
+	/// longest time between two DVR reads, so the time the kernel had to
+	/// buffer the data. In adaptive mode it calculates the DVR buffer size
+	/// needed, from the bitrate and the time the reader may lag behind. This
+	/// lag time is at least twice the measured lag, on each overflow it is
+	/// doubled, after a stable period it is slowly decreased again.
+	/// Resizing the DVR buffer drops the data in it, so the live buffer is
+	/// only resized after an overflow. Other changes are kept as the wanted
+	/// size, that is applied when the DVR is opened again.
+	class DvrBufferSizer {
+		public:
+
+			// ================================================================
+			//  -- Constructors and destructor --------------------------------
+			// ================================================================
+			DvrBufferSizer();
+
+			virtual ~DvrBufferSizer();
+
+			// ================================================================
+			//  -- Other member functions -------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Start measuring for a newly opened DVR
+			/// @param size specifies the current DVR buffer size in Bytes
+			/// @param maxSize specifies the maximum DVR buffer size in Bytes
+			/// @param adaptive specifies if the buffer size should be adapted
+			void start(unsigned int size, unsigned int maxSize, bool adaptive);
+
+			/// Get the last used DVR buffer size in Bytes, 0 if unknown
+			unsigned int getSize() const {
+				return _size;
+			}
+
+			/// Set the DVR buffer size in Bytes that is applied now
+			void setSize(unsigned int size) {
+				_size = size;
+			}
+
+			/// Get the DVR buffer size in Bytes to use when the DVR is opened
+			/// again, 0 if unknown
+			unsigned int getWantedSize() const {
+				return _wantedSize;
+			}
+
+			/// Account the Bytes read from DVR, call this for each read
+			void addBytes(std::size_t bytes);
+
+			/// Account a DVR buffer overflow (read returned EOVERFLOW). The
+			/// kernel dropped the complete DVR buffer, so that is what we
+			/// count as lost
+			void addOverflow();
+
+			/// Check if the DVR buffer should be resized. Call this regularly
+			/// from the reading thread. Only after an overflow the new size is
+			/// returned, otherwise it is kept for the next open, see
+			/// @c getWantedSize
+			/// @return the new DVR buffer size in Bytes, or 0 when the current
+			/// size should be kept
+			unsigned int checkSize();
+
+			/// Get the amount of DVR buffer overflows
+			uint64_t getOverflows() const {
+				return _overflows;
+			}
+
+			/// Get the estimated amount of Bytes lost by DVR buffer overflows
+			uint64_t getBytesLost() const {
+				return _bytesLost;
+			}
+
+			/// Get the measured transponder bitrate in Bytes per second
+			uint64_t getBitrate() const {
+				return _bitrate;
+			}
+
+			/// Get the measured consumer lag in ms, the longest time between
+			/// two DVR reads in the last measurement
+			unsigned int getLagMs() const {
+				return _lagMs;
+			}
+
+			// ================================================================
+			//  -- Data members -----------------------------------------------
+			// ================================================================
+
+		public:
+
+			static constexpr unsigned int MIN_SIZE        = 1024 * 1024;
+			static constexpr unsigned int START_SIZE      = 4 * 1024 * 1024;
+			static constexpr unsigned int MIN_LAG_TIME_MS = 500;
+			static constexpr unsigned int MAX_LAG_TIME_MS = 8000;
+
+		private:
+
+			using Clock = std::chrono::steady_clock;
+
+			bool _adaptive;
+			unsigned int _maxSize;
+			std::atomic<unsigned int> _size;
+			std::atomic<unsigned int> _wantedSize; /// size for the next open
+			std::atomic<uint64_t> _overflows;
+			std::atomic<uint64_t> _bytesLost;
+			std::atomic<uint64_t> _bitrate;
+			std::atomic<unsigned int> _lagMs;
+			std::atomic<bool> _overflowPending;
+			std::size_t _windowBytes;
+			unsigned int _windowLagMs;
+			unsigned int _peakLagMs; /// highest measured lag since last change
+			unsigned int _lagTimeMs;
+			Clock::time_point _windowStart;
+			Clock::time_point _lastRead;
+			Clock::time_point _lastOverflow;
+			Clock::time_point _lastChange;
+	};
+
+} // namespace dvb
+} // namespace input
+
+#endif // INPUT_DVB_DVRBUFFERSIZER_H_INCLUDE
@@ -0,0 +1,117 @@
+/* DvrReader.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <input/dvb/DvrReader.h>
+
+#include <Log.h>
+#include <Utils.h>
+#include <mpegts/PacketBuffer.h>
+
+#include <cstring>
+
+#include <unistd.h>
+
+namespace input {
+namespace dvb {
+
+	static_assert(DvrReader::STAGING_BLOCK_SIZE % mpegts::PacketBuffer::TS_PACKET_SIZE == 0,
+		"Staging block should be a multiple of TS packets");
+	static_assert(DvrReader::STAGING_BLOCK_SIZE % DvrReader::STAGING_ALIGNMENT == 0,
+		"Staging block should be a multiple of the alignment");
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	DvrReader::DvrReader() :
+		_buffer(nullptr),
+		_size(0),
+		_readIndex(0),
+		_fillIndex(0),
+		_readCalls(0),
+		_readBytes(0) {}
+
+	DvrReader::~DvrReader() {
+		release();
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void DvrReader::allocate(const std::size_t sizeKB) {
+		const std::size_t blocks = ((sizeKB * 1024) + STAGING_BLOCK_SIZE - 1) / STAGING_BLOCK_SIZE;
+		const std::size_t size = blocks * STAGING_BLOCK_SIZE;
+		if (size == _size) {
+			flush();
+			return;
+		}
+		release();
+		if (size == 0) {
+			return;
+		}
+		void *ptr = nullptr;
+		if (::posix_memalign(&ptr, STAGING_ALIGNMENT, size) != 0) {
+			SI_LOG_ERROR("Unable to allocate DVR staging buffer of %zu Bytes", size);
+			return;
+		}
+		_buffer = static_cast<unsigned char *>(ptr);
+		_size = size;
+	}
+
+	void DvrReader::release() {
+		FREE_PTR(_buffer);
+		_size = 0;
+		flush();
+	}
+
+	ssize_t DvrReader::fill(const int fd) {
+		if (_buffer == nullptr || getAmountOfBytesStaged() > 0) {
+			return 0;
+		}
+		flush();
+		const ssize_t bytes = ::read(fd, _buffer, _size);
+		if (bytes > 0) {
+			_fillIndex = bytes;
+			addReadStatistics(bytes);
+		}
+		return bytes;
+	}
+
+	std::size_t DvrReader::copyTo(mpegts::PacketBuffer &buffer) {
+		std::size_t size = buffer.getAmountOfBytesToWrite();
+		const std::size_t staged = getAmountOfBytesStaged();
+		if (size > staged) {
+			size = staged;
+		}
+		if (size > 0) {
+			std::memcpy(buffer.getWriteBufferPtr(), &_buffer[_readIndex], size);
+			buffer.addAmountOfBytesWritten(size);
+			_readIndex += size;
+		}
+		return size;
+	}
+
+	uint64_t DvrReader::getBytesPerRead() const {
+		const uint64_t calls = _readCalls;
+		return (calls > 0) ? (_readBytes / calls) : 0;
+	}
+
+} // namespace dvb
+} // namespace input
@@ -0,0 +1,138 @@
+/* DvrReader.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef INPUT_DVB_DVRREADER_H_INCLUDE
+#define INPUT_DVB_DVRREADER_H_INCLUDE INPUT_DVB_DVRREADER_H_INCLUDE
+
+#include <FwDecl.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/types.h>
+
+FW_DECL_NS1(mpegts, PacketBuffer);
+
+namespace input {
+namespace dvb {
+
+	/// The class @c DvrReader reads big chunks from the DVR into an aligned
+	/// staging buffer, from which many @c PacketBuffer can be filled without
+	/// doing a syscall for each of them
+	class DvrReader {
+		public:
+
+			// ================================================================
+			//  -- Constructors and destructor --------------------------------
+			// ================================================================
+			DvrReader();
+
+			virtual ~DvrReader();
+
+			// ================================================================
+			//  -- Other member functions -------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Allocate the staging buffer, the size will be rounded up to a
+			/// multiple of TS packets and pages. A size of 0 disables bulk reading
+			/// @param sizeKB specifies the wanted staging size in KBytes
+			void allocate(std::size_t sizeKB);
+
+			/// Free the staging buffer and drop all staged data
+			void release();
+
+			/// Drop all staged data, but keep the staging buffer
+			void flush() {
+				_readIndex = 0;
+				_fillIndex = 0;
+			}
+
+			/// Check if bulk reading is enabled (staging buffer allocated)
+			bool isEnabled() const {
+				return _buffer != nullptr;
+			}
+
+			/// Get the amount of bytes still staged
+			std::size_t getAmountOfBytesStaged() const {
+				return _fillIndex - _readIndex;
+			}
+
+			/// Fill the staging buffer with one read from @a fd, but only when
+			/// all previous staged data was consumed
+			/// @return the amount of bytes read, 0 when nothing needed to be
+			/// read, or -1 on error (see errno)
+			ssize_t fill(int fd);
+
+			/// Copy as much staged data into @a buffer as it can take
+			/// @return the amount of bytes copied
+			std::size_t copyTo(mpegts::PacketBuffer &buffer);
+
+			/// Get the amount of read syscalls done on the DVR
+			uint64_t getReadCalls() const {
+				return _readCalls;
+			}
+
+			/// Get the amount of bytes read with these syscalls
+			uint64_t getReadBytes() const {
+				return _readBytes;
+			}
+
+			/// Get the average amount of bytes read per read syscall
+			uint64_t getBytesPerRead() const;
+
+			/// Account a read syscall that was done outside this reader
+			void addReadStatistics(std::size_t bytes) {
+				++_readCalls;
+				_readBytes += bytes;
+			}
+
+			/// Reset the read statistics
+			void resetStatistics() {
+				_readCalls = 0;
+				_readBytes = 0;
+			}
+
+			// ================================================================
+			//  -- Data members -----------------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Staging size is a multiple of this: a multiple of TS packets
+			/// that is also a multiple of 4 KBytes pages
+			static constexpr std::size_t STAGING_BLOCK_SIZE = 188 * 1024;
+			static constexpr std::size_t STAGING_ALIGNMENT  = 4096;
+
+		private:
+
+			unsigned char *_buffer;
+			std::size_t _size;
+			std::size_t _readIndex;
+			std::size_t _fillIndex;
+			std::atomic<uint64_t> _readCalls;
+			std::atomic<uint64_t> _readBytes;
+	};
+
+} // namespace dvb
+} // namespace input
+
+#endif // INPUT_DVB_DVRREADER_H_INCLUDE
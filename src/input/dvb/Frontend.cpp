@@ -24,6 +24,7 @@
 #include <Stream.h>
 #include <StringConverter.h>
 #include <mpegts/PacketBuffer.h>
+#include <input/WarmStandby.h>
 #include <input/dvb/FrontendData.h>
 #include <input/dvb/delivery/DVBC.h>
 #include <input/dvb/delivery/DVBS.h>
@@ -31,6 +32,8 @@
 #include <input/dvb/delivery/DiSEqc.h>
 
 #include <chrono>
+#include <cinttypes>
+#include <cstring>
 #include <thread>
 
 #include <stdio.h>
@@ -49,6 +52,16 @@ namespace dvb {
 
 	const unsigned int Frontend::DEFAULT_DVR_BUFFER_SIZE = 18;
 	const unsigned int Frontend::MAX_DVR_BUFFER_SIZE     = 18 * 10;
+	const unsigned int Frontend::DEFAULT_DVR_BULK_READ_SIZE = 2 * 1024;
+	const unsigned int Frontend::MAX_DVR_BULK_READ_SIZE     = 16 * 1024;
+	const unsigned int Frontend::MIN_LOCK_TIMEOUT     = 100;
+	const unsigned int Frontend::DEFAULT_LOCK_TIMEOUT = 1500;
+	const unsigned int Frontend::MAX_LOCK_TIMEOUT     = 10000;
+	const unsigned int Frontend::MAX_HW_PID_LIMIT     = mpegts::PidTable::ALL_PIDS;
+
+	/// Upper limits (ms) of the tune-to-lock histogram buckets, the bucket after
+	/// the last limit is for everything slower and the last bucket is 'no lock'
+	static const long TUNE_TO_LOCK_LIMIT[] = { 50, 100, 200, 500, 1000, 2000 };
 
 	// =======================================================================
 	// -- Constructors and destructor ----------------------------------------
@@ -64,6 +77,15 @@ namespace dvb {
 		_tuned(false),
 		_fd_fe(-1),
 		_fd_dvr(-1),
+		_fd_dmx(-1),
+		_dmxPidCount(0),
+		_dmxAddPidSupported(true),
+		_pidUpdateTimeUs(0),
+		_fd_dmx_all(-1),
+		_softwarePidFilter(false),
+		_hwPidLimit(0),
+		_hwPidFailCount(0),
+		_softwarePidDropped(0),
 		_path_to_fe(fe),
 		_path_to_dvr(dvr),
 		_path_to_dmx(dmx),
@@ -73,7 +95,16 @@ namespace dvb {
 		_dvbt2(0),
 		_dvbc(0),
 		_dvbc2(0),
-		_dvrBufferSizeMB(DEFAULT_DVR_BUFFER_SIZE) {
+		_dvrBufferSizeMB(DEFAULT_DVR_BUFFER_SIZE),
+		_dvrBufferAdaptive(false),
+		_dvrBulkReadSizeKB(DEFAULT_DVR_BULK_READ_SIZE),
+		_lockTimeoutMs(DEFAULT_LOCK_TIMEOUT),
+		_lastTuneToLockMs(0) {
+		static_assert(N_ELEMENTS(TUNE_TO_LOCK_LIMIT) + 2 == TUNE_TO_LOCK_BUCKETS,
+			"Tune-to-lock limits do not match buckets");
+		for (std::size_t i = 0; i < TUNE_TO_LOCK_BUCKETS; ++i) {
+			_tuneToLock[i] = 0;
+		}
 		snprintf(_fe_info.name, sizeof(_fe_info.name), "Not Set");
 		setupFrontend();
 	}
@@ -189,7 +220,34 @@ namespace dvb {
 			ADD_XML_ELEMENT(xml, "symbol", StringConverter::stringFormat("%1 symbols/s to %2 symbols/s", _fe_info.symbol_rate_min, _fe_info.symbol_rate_max));
 
 			ADD_XML_NUMBER_INPUT(xml, "dvrbuffer", _dvrBufferSizeMB, 0, MAX_DVR_BUFFER_SIZE);
+			ADD_XML_CHECKBOX(xml, "dvrbufferadaptive", (_dvrBufferAdaptive ? "true" : "false"));
+			ADD_XML_NUMBER_INPUT(xml, "dvrbulkread", _dvrBulkReadSizeKB, 0, MAX_DVR_BULK_READ_SIZE);
+			ADD_XML_NUMBER_INPUT(xml, "locktimeout", _lockTimeoutMs, MIN_LOCK_TIMEOUT, MAX_LOCK_TIMEOUT);
+			ADD_XML_NUMBER_INPUT(xml, "hwpidlimit", _hwPidLimit, 0, MAX_HW_PID_LIMIT);
+		}
+		{
+			base::MutexLock lock(_mutex);
+			if (_softwarePidFilter) {
+				ADD_XML_ELEMENT(xml, "pidfiltermode", "Software (all PIDs demux)");
+			} else {
+				ADD_XML_ELEMENT(xml, "pidfiltermode", _dmxAddPidSupported ? "Shared demux (DMX_ADD_PID)" : "Demux per PID");
+			}
+			ADD_XML_ELEMENT(xml, "hwpidfailcount", _hwPidFailCount);
+			ADD_XML_ELEMENT(xml, "softwarepiddropped", _softwarePidDropped.load());
+			ADD_XML_ELEMENT(xml, "pidupdatetime", _pidUpdateTimeUs);
+			ADD_XML_ELEMENT(xml, "lasttunetolock", _lastTuneToLockMs);
+			ADD_XML_ELEMENT(xml, "tunetolock", getTuneToLockHistogram());
 		}
+		ADD_XML_ELEMENT(xml, "dvrreadcalls", _dvrReader.getReadCalls());
+		ADD_XML_ELEMENT(xml, "dvrbytesperread", _dvrReader.getBytesPerRead());
+		ADD_XML_ELEMENT(xml, "dvrbuffersize", _dvrBufferSizer.getSize());
+		ADD_XML_ELEMENT(xml, "dvrbitrate", (_dvrBufferSizer.getBitrate() * 8) / 1000);
+		ADD_XML_ELEMENT(xml, "dvrlag", _dvrBufferSizer.getLagMs());
+		ADD_XML_ELEMENT(xml, "dvroverflows", _dvrBufferSizer.getOverflows());
+		ADD_XML_ELEMENT(xml, "dvroverflowloss", _dvrBufferSizer.getBytesLost());
+#ifdef LIBDVBCSA
+		ADD_XML_ELEMENT(xml, "decryptlatency", _dvbapiData.getDecryptLatencyPercentiles());
+#endif
 
 		// Channel
 		_frontendData.addToXML(xml);
@@ -222,6 +280,23 @@ namespace dvb {
 					newSize : DEFAULT_DVR_BUFFER_SIZE;
 
 			}
+			if (findXMLElement(xml, "dvrbufferadaptive.value", element)) {
+				_dvrBufferAdaptive = (element == "true") ? true : false;
+			}
+			if (findXMLElement(xml, "dvrbulkread.value", element)) {
+				const unsigned int newSize = atoi(element.c_str());
+				_dvrBulkReadSizeKB = (newSize <= MAX_DVR_BULK_READ_SIZE) ?
+					newSize : DEFAULT_DVR_BULK_READ_SIZE;
+			}
+			if (findXMLElement(xml, "locktimeout.value", element)) {
+				const unsigned int timeout = atoi(element.c_str());
+				_lockTimeoutMs = (timeout >= MIN_LOCK_TIMEOUT && timeout <= MAX_LOCK_TIMEOUT) ?
+					timeout : DEFAULT_LOCK_TIMEOUT;
+			}
+			if (findXMLElement(xml, "hwpidlimit.value", element)) {
+				const unsigned int limit = atoi(element.c_str());
+				_hwPidLimit = (limit <= MAX_HW_PID_LIMIT) ? limit : 0;
+			}
 		}
 		for (size_t i = 0u; i < _deliverySystem.size(); ++i) {
 			const std::string deliverySystem = StringConverter::stringFormat("deliverySystem%1", i);
@@ -252,12 +327,22 @@ namespace dvb {
 	}
 
 	bool Frontend::isDataAvailable() {
-		pollfd pfd[1];
+		// Still data staged from a previous bulk read, then no need to poll
+		if (_dvrReader.getAmountOfBytesStaged() > 0) {
+			return true;
+		}
+		pollfd pfd[2];
 		pfd[0].fd = _fd_dvr;
 		pfd[0].events = POLLIN;
 		pfd[0].revents = 0;
-		const int pollRet = ::poll(pfd, 1, 180);
+		pfd[1].fd = _fd_wake;
+		pfd[1].events = POLLIN;
+		pfd[1].revents = 0;
+		const int pollRet = ::poll(pfd, 2, 180);
 		if (pollRet > 0) {
+			if (pfd[1].revents & POLLIN) {
+				clearWakeUp();
+			}
 			return pfd[0].revents & POLLIN;
 		} else if (pollRet < 0) {
 			PERROR("Error during polling frontend for data");
@@ -268,33 +353,123 @@ namespace dvb {
 	}
 
 	bool Frontend::readFullTSPacket(mpegts::PacketBuffer &buffer) {
-		// try read maximum amount of bytes from DVR
-		const int bytes = ::read(_fd_dvr, buffer.getWriteBufferPtr(), buffer.getAmountOfBytesToWrite());
-		if (bytes > 0) {
-			buffer.addAmountOfBytesWritten(bytes);
-			const bool full = buffer.full();
-			if (full) {
-				const std::size_t size = buffer.getNumberOfTSPackets();
-				for (std::size_t i = 0; i < size; ++i) {
-					const unsigned char *ptr = buffer.getTSPacketPtr(i);
-					// sync byte then check cc
-					if (ptr[0] == 0x47) {
-						// get PID and CC from TS
-						const uint16_t pid = ((ptr[1] & 0x1f) << 8) | ptr[2];
-						const uint8_t  cc  =   ptr[3] & 0x0f;
-						_frontendData.addPIDData(pid, cc);
-
-						getFilter().addData(_streamID, ptr);
-					}
+		mpegts::TSPacketHeader header[mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS];
+		if (_dvrReader.isEnabled()) {
+			// bulk mode: only read from DVR when all staged data is consumed
+			const ssize_t bytes = _dvrReader.fill(_fd_dvr);
+			if (bytes < 0) {
+				handleDVRReadError();
+				return false;
+			}
+			if (bytes > 0) {
+				_dvrBufferSizer.addBytes(bytes);
+			}
+			adaptDVRBufferSize();
+			if (_dvrReader.copyTo(buffer) == 0) {
+				return false;
+			}
+			// Keep filling from the staged data while the software PID filter
+			// drops packets, so we do not poll for data that is already here
+			while (_softwarePidFilter && buffer.full() && !filterSoftwarePIDs(buffer, header)) {
+				if (_dvrReader.copyTo(buffer) == 0) {
+					return false;
 				}
 			}
-			return full;
-		} else if (bytes < 0) {
-			PERROR("Frontend::readFullTSPacket");
+		} else {
+			// try read maximum amount of bytes from DVR
+			const int bytes = ::read(_fd_dvr, buffer.getWriteBufferPtr(), buffer.getAmountOfBytesToWrite());
+			if (bytes > 0) {
+				buffer.addAmountOfBytesWritten(bytes);
+				_dvrReader.addReadStatistics(bytes);
+				_dvrBufferSizer.addBytes(bytes);
+				adaptDVRBufferSize();
+			} else {
+				if (bytes < 0) {
+					handleDVRReadError();
+				}
+				return false;
+			}
+		}
+		const bool full = buffer.full() &&
+			(!_softwarePidFilter || filterSoftwarePIDs(buffer, header));
+		if (full) {
+			const std::size_t size = buffer.getNumberOfTSPackets();
+			// The software PID filter did decode the headers already
+			if (!_softwarePidFilter) {
+				mpegts::TSHeaderParser::parse(buffer.getTSReadBufferPtr(), size, header);
+			}
+			// Packets kept from a previous fill, before some were dropped,
+			// are accounted already
+			for (std::size_t i = buffer.getAccountedTSPackets(); i < size; ++i) {
+				// sync byte then check cc
+				if (header[i].isSynced()) {
+					_frontendData.addPIDData(header[i].pid, header[i].cc);
+
+					getFilter().addData(_streamID, buffer.getTSPacketPtr(i), header[i]);
+				}
+			}
+			buffer.setAccountedTSPackets(size);
 		}
+		return full;
+	}
+
+	bool Frontend::filterSoftwarePIDs(mpegts::PacketBuffer &buffer, mpegts::TSPacketHeader *header) {
+		const std::size_t size = buffer.getNumberOfTSPackets();
+		mpegts::TSHeaderParser::parse(buffer.getTSReadBufferPtr(), size, header);
+		const std::size_t accounted = buffer.getAccountedTSPackets();
+		std::size_t keep = 0;
+		std::size_t keepAccounted = 0;
+		for (std::size_t i = 0; i < size; ++i) {
+			const unsigned char *ptr = buffer.getTSPacketPtr(i);
+			// Packets without sync byte are kept, so the buffer can be synced again
+			const bool pass = !header[i].isSynced() || _pidFilter.isSet(header[i].pid);
+			if (pass) {
+				if (keep != i) {
+					std::memcpy(buffer.getTSPacketPtr(keep), ptr, mpegts::PacketBuffer::TS_PACKET_SIZE);
+				}
+				keepAccounted += (i < accounted) ? 1 : 0;
+				++keep;
+			}
+		}
+		if (keep == size) {
+			return true;
+		}
+		_softwarePidDropped += size - keep;
+		buffer.truncateToTSPackets(keep);
+		buffer.setAccountedTSPackets(keepAccounted);
 		return false;
 	}
 
+	void Frontend::handleDVRReadError() {
+		if (errno == EOVERFLOW) {
+			// The kernel dropped the DVR buffer, because we did not read fast enough
+			_dvrBufferSizer.addOverflow();
+			SI_LOG_ERROR("Stream: %d, DVR buffer overflow, data lost (overflows: %" PRIu64 ", about %" PRIu64 " Bytes lost)",
+				_streamID, _dvrBufferSizer.getOverflows(), _dvrBufferSizer.getBytesLost());
+			adaptDVRBufferSize();
+		} else if (errno != EAGAIN) {
+			PERROR("Frontend::readFullTSPacket");
+		}
+	}
+
+	void Frontend::adaptDVRBufferSize() {
+		const unsigned int size = _dvrBufferSizer.checkSize();
+		if (size == 0) {
+			return;
+		}
+		if (::ioctl(_fd_dvr, DMX_SET_BUFFER_SIZE, size) != 0) {
+			PERROR("DVR - DMX_SET_BUFFER_SIZE failed");
+			return;
+		}
+		SI_LOG_INFO("Stream: %d, Adapted DVR buffer size from %u to %u Bytes (bitrate %" PRIu64 " Bytes/s, lag %u ms)",
+			_streamID, _dvrBufferSizer.getSize(), size, _dvrBufferSizer.getBitrate(), _dvrBufferSizer.getLagMs());
+		_dvrBufferSizer.setSize(size);
+	}
+
+	int Frontend::getInputFileDescriptor() const {
+		return _fd_dvr;
+	}
+
 	bool Frontend::capableOf(const input::InputSystem system) const {
 		for (input::dvb::delivery::SystemVector::const_iterator it = _deliverySystem.begin();
 		     it != _deliverySystem.end();
@@ -358,6 +533,10 @@ namespace dvb {
 		return _frontendData.hasDeviceDataChanged();
 	}
 
+	bool Frontend::hasLock() const {
+		return _frontendData.hasLock() == 1;
+	}
+
 	void Frontend::parseStreamString(const std::string &msg1, const std::string &method) {
 		SI_LOG_INFO("Stream: %d, Parsing transport parameters...", _streamID);
 
@@ -375,16 +554,26 @@ namespace dvb {
 		// Setup, tune and set PID Filters
 		if (_frontendData.hasDeviceDataChanged()) {
 			_frontendData.resetDeviceDataChanged();
-			_tuned = false;
-			closeFE();
-			closeDVR();
-			// After close wait a moment before opening it again
-			std::this_thread::sleep_for(std::chrono::milliseconds(150));
+			std::string standbyKey;
+			{
+				base::MutexLock lock(_mutex);
+				standbyKey.swap(_standbyKey);
+			}
+			if (!standbyKey.empty() && standbyKey == getRequestedTransponderKey() && isLocked()) {
+				SI_LOG_INFO("Stream: %d, Frontend still tuned to %s from standby, skip tuning",
+					_streamID, standbyKey.c_str());
+			} else {
+				_tuned = false;
+				// Keep the FE open, so the LNB stays powered and the DiSEqc
+				// state of the last tune is still valid
+				closeDVR();
+			}
 		}
 
+		// No pause between the attempts: setupAndTune() itself waits on
+		// frontend events and on lock, within the lock timeout
 		std::size_t timeout = 0;
 		while (!setupAndTune()) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(150));
 			++timeout;
 			if (timeout > 3) {
 				return false;
@@ -398,18 +587,45 @@ namespace dvb {
 
 	bool Frontend::teardown() {
 		// Close active PIDs
-		for (std::size_t i = 0u; i < mpegts::PidTable::MAX_PIDS; ++i) {
-			closePid(i);
-		}
+		closeAllPidFilters();
 		_tuned = false;
 		closeFE();
 		closeDVR();
+		_dvrReader.release();
+		_frontendData.setMonitorData(static_cast<fe_status_t>(0), 0, 0, 0, 0);
+		_frontendData.initialize();
+		_transform.resetTransformFlag();
+		{
+			base::MutexLock lock(_mutex);
+			_standbyKey.clear();
+		}
+		return true;
+	}
+
+	bool Frontend::standby() {
+		if (!_tuned || _fd_fe == -1) {
+			return teardown();
+		}
+		const std::string key = getRequestedTransponderKey();
+		// Close active PIDs and DVR, but keep the FE tuned
+		closeAllPidFilters();
+		closeDVR();
 		_frontendData.setMonitorData(static_cast<fe_status_t>(0), 0, 0, 0, 0);
 		_frontendData.initialize();
 		_transform.resetTransformFlag();
+		{
+			base::MutexLock lock(_mutex);
+			_standbyKey = key;
+		}
+		SI_LOG_INFO("Stream: %d, Frontend in standby, staying tuned to %s", _streamID, key.c_str());
 		return true;
 	}
 
+	std::string Frontend::getStandbyKey() const {
+		base::MutexLock lock(_mutex);
+		return _standbyKey;
+	}
+
 	std::string Frontend::attributeDescribeString() const {
 		const DeviceData &data = _transform.transformDeviceData(_frontendData);
 		return data.attributeDescribeString(_streamID);
@@ -601,6 +817,16 @@ namespace dvb {
 			SI_LOG_INFO("Stream: %d, Closing %s fd: %d", _streamID, _path_to_fe.c_str(), _fd_fe);
 			CLOSE_FD(_fd_fe);
 		}
+		// Closing the FE might power down the LNB
+		invalidateDeliverySystemState();
+	}
+
+	void Frontend::invalidateDeliverySystemState() {
+		for (input::dvb::delivery::SystemVector::iterator it = _deliverySystem.begin();
+		     it != _deliverySystem.end();
+		     ++it) {
+			(*it)->invalidateCachedState();
+		}
 	}
 
 	int Frontend::openDMX(const std::string &path) const {
@@ -624,6 +850,7 @@ namespace dvb {
 			SI_LOG_INFO("Stream: %d, Closing %s fd: %d", _streamID, _path_to_dvr.c_str(), _fd_dvr);
 			CLOSE_FD(_fd_dvr);
 		}
+		_dvrReader.flush();
 	}
 
 	bool Frontend::setDMXFilter(const int fd, const uint16_t pid) {
@@ -661,34 +888,39 @@ namespace dvb {
 				_fd_fe = openFE(_path_to_fe, false);
 				SI_LOG_INFO("Stream: %d, Opened %s fd: %d", _streamID, _path_to_fe.c_str(), _fd_fe);
 			}
-			// try tuning
+			unsigned int lockTimeoutMs;
+			{
+				base::MutexLock lock(_xmlMutex);
+				lockTimeoutMs = _lockTimeoutMs;
+			}
+			const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			const std::chrono::steady_clock::time_point deadline =
+				begin + std::chrono::milliseconds(lockTimeoutMs);
+			// try tuning, retries and lock have to fit in the lock timeout
 			std::size_t timeout = 0;
 			while (!tune()) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(450));
+				const long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+					deadline - std::chrono::steady_clock::now()).count();
 				++timeout;
-				if (timeout > 3) {
+				if (timeout > 3 || remaining <= 0) {
 					return false;
 				}
+				waitOnFrontendEvent((remaining < 100) ? remaining : 100);
 			}
+			const long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now()).count();
 			SI_LOG_INFO("Stream: %d, Waiting on lock...", _streamID);
+			_tuned = waitOnLock((remaining > 0) ? remaining : 0);
 
-			// check if frontend is locked, if not try a few times
-			timeout = 0;
-			while (timeout < 4) {
-				fe_status_t status = FE_TIMEDOUT;
-				// first read status
-				if (::ioctl(_fd_fe, FE_READ_STATUS, &status) == 0) {
-					if (status & FE_HAS_LOCK) {
-						// We are tuned now
-						_tuned = true;
-						SI_LOG_INFO("Stream: %d, Tuned and locked (FE status 0x%X)", _streamID, status);
-						break;
-					} else {
-						SI_LOG_INFO("Stream: %d, Not locked yet   (FE status 0x%X)...", _streamID, status);
-					}
-				}
-				std::this_thread::sleep_for(std::chrono::milliseconds(150));
-				++timeout;
+			const long timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - begin).count();
+			addTuneToLockTime(timeMs, _tuned);
+			if (_tuned) {
+				SI_LOG_INFO("Stream: %d, Tuned and locked in %ld ms", _streamID, timeMs);
+			} else {
+				SI_LOG_INFO("Stream: %d, Not locked within %u ms", _streamID, lockTimeoutMs);
+				// Maybe the switch missed something, so send everything next time
+				invalidateDeliverySystemState();
 			}
 		}
 		// Check if we have already a DVR open and are tuned
@@ -706,46 +938,277 @@ namespace dvb {
 
 			{
 				base::MutexLock lock(_mutex);
-				if (_dvrBufferSizeMB > 0u) {
-					const unsigned int size = _dvrBufferSizeMB * 1024u * 1024u;
+				const unsigned int maxSize = _dvrBufferSizeMB * 1024u * 1024u;
+				const bool adaptive = _dvrBufferAdaptive && maxSize > 0u;
+				// In adaptive mode continue with the size the previous tune wanted
+				unsigned int size = maxSize;
+				if (adaptive) {
+					size = _dvrBufferSizer.getWantedSize();
+					if (size == 0u) {
+						size = DvrBufferSizer::START_SIZE;
+					}
+					if (size > maxSize) {
+						size = maxSize;
+					}
+				}
+				if (size > 0u) {
 					if (::ioctl(_fd_dvr, DMX_SET_BUFFER_SIZE, size) != 0) {
 						PERROR("DVR - DMX_SET_BUFFER_SIZE failed");
 					} else {
-						SI_LOG_INFO("Stream: %d, Set DVR buffer size to %d Bytes", _streamID, size);
+						SI_LOG_INFO("Stream: %d, Set DVR buffer size to %d Bytes%s", _streamID, size,
+							adaptive ? " (adaptive)" : "");
 					}
 				}
+				_dvrBufferSizer.start(size, maxSize, adaptive);
+				_dvrReader.allocate(_dvrBulkReadSizeKB);
+				_dvrReader.resetStatistics();
+				if (_dvrReader.isEnabled()) {
+					SI_LOG_INFO("Stream: %d, Using DVR bulk read of %lu KBytes", _streamID, _dvrBulkReadSizeKB);
+				}
 			}
 		}
 		return (_fd_dvr != -1) && _tuned;
 	}
 
+	bool Frontend::isLocked() const {
+		fe_status_t status = FE_TIMEDOUT;
+		return ::ioctl(_fd_fe, FE_READ_STATUS, &status) == 0 && (status & FE_HAS_LOCK);
+	}
+
+	std::string Frontend::getTransponderKey() const {
+		return _tuned ? getRequestedTransponderKey() : "";
+	}
+
+	std::string Frontend::getRequestedTransponderKey() const {
+		return input::WarmStandby::makeTransponderKey(
+			_frontendData.getDeliverySystem(),
+			_frontendData.getFrequency(),
+			_frontendData.getPolarizationChar(),
+			_frontendData.getDiSEqcSource(),
+			_frontendData.getSymbolRate(),
+			_frontendData.getModulationType(),
+			_frontendData.getUniqueIDPlp(),
+			_frontendData.getUniqueIDT2());
+	}
+
+	bool Frontend::waitOnLock(const unsigned int timeoutMs) {
+		const std::chrono::steady_clock::time_point deadline =
+			std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+		for (;;) {
+			fe_status_t status = FE_TIMEDOUT;
+			if (::ioctl(_fd_fe, FE_READ_STATUS, &status) == 0 && (status & FE_HAS_LOCK)) {
+				SI_LOG_DEBUG("Stream: %d, Locked (FE status 0x%X)", _streamID, status);
+				return true;
+			}
+			const long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+				deadline - std::chrono::steady_clock::now()).count();
+			if (remaining <= 0) {
+				SI_LOG_DEBUG("Stream: %d, Not locked (FE status 0x%X)", _streamID, status);
+				return false;
+			}
+			// Wait on a frontend event, but not all drivers send one for
+			// every status change, so also check the status now and then
+			pollfd pfd[1];
+			pfd[0].fd = _fd_fe;
+			pfd[0].events = POLLPRI;
+			pfd[0].revents = 0;
+			const int pollRet = ::poll(pfd, 1, (remaining < 100) ? remaining : 100);
+			if (pollRet > 0 && (pfd[0].revents & POLLPRI)) {
+				struct dvb_frontend_event event;
+				while (::ioctl(_fd_fe, FE_GET_EVENT, &event) == 0) {
+					if (event.status & FE_HAS_LOCK) {
+						SI_LOG_DEBUG("Stream: %d, Locked on event (FE status 0x%X)", _streamID, event.status);
+						return true;
+					}
+				}
+			} else if (pollRet < 0 && errno != EINTR) {
+				PERROR("Error during polling frontend for events");
+				return false;
+			}
+		}
+	}
+
+	void Frontend::waitOnFrontendEvent(const int timeoutMs) {
+		pollfd pfd[1];
+		pfd[0].fd = _fd_fe;
+		pfd[0].events = POLLPRI;
+		pfd[0].revents = 0;
+		if (::poll(pfd, 1, timeoutMs) > 0 && (pfd[0].revents & POLLPRI)) {
+			// Drain the events, waitOnLock checks the status again
+			struct dvb_frontend_event event;
+			while (::ioctl(_fd_fe, FE_GET_EVENT, &event) == 0) {}
+		}
+	}
+
+	void Frontend::addTuneToLockTime(const long timeMs, const bool locked) {
+		base::MutexLock lock(_mutex);
+		std::size_t bucket = TUNE_TO_LOCK_BUCKETS - 1;
+		if (locked) {
+			_lastTuneToLockMs = timeMs;
+			for (bucket = 0; bucket < N_ELEMENTS(TUNE_TO_LOCK_LIMIT); ++bucket) {
+				if (timeMs < TUNE_TO_LOCK_LIMIT[bucket]) {
+					break;
+				}
+			}
+		}
+		++_tuneToLock[bucket];
+	}
+
+	std::string Frontend::getTuneToLockHistogram() const {
+		base::MutexLock lock(_mutex);
+		std::string histogram;
+		for (std::size_t i = 0; i < N_ELEMENTS(TUNE_TO_LOCK_LIMIT); ++i) {
+			histogram += StringConverter::stringFormat("&lt;%1ms: %2, ", TUNE_TO_LOCK_LIMIT[i], _tuneToLock[i]);
+		}
+		histogram += StringConverter::stringFormat("&gt;=%1ms: %2, no lock: %3",
+			TUNE_TO_LOCK_LIMIT[N_ELEMENTS(TUNE_TO_LOCK_LIMIT) - 1],
+			_tuneToLock[TUNE_TO_LOCK_BUCKETS - 2], _tuneToLock[TUNE_TO_LOCK_BUCKETS - 1]);
+		return histogram;
+	}
+
 	bool Frontend::openPid(const int pid) {
 		if (_frontendData.getDMXFileDescriptor(pid) == -1) {
-			const int fd = openDMX(_path_to_dmx);
-			_frontendData.setDMXFileDescriptor(pid, fd);
-			std::size_t timeout = 0;
-			while (setDMXFilter(_frontendData.getDMXFileDescriptor(pid), pid) != 1) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(350));
-				++timeout;
-				if (timeout > 3) {
+			// Try the shared demux first, 'all PIDs' always gets its own demux
+			if (_dmxAddPidSupported && pid != mpegts::PidTable::ALL_PIDS) {
+				if (addPidToSharedDMX(pid)) {
+					return true;
+				} else if (_dmxAddPidSupported) {
 					return false;
 				}
 			}
+			// Do not retry here, when the hardware runs out of filters we
+			// switch to the software PID filter instead
+			int fd = openDMX(_path_to_dmx);
+			if (fd == -1) {
+				return false;
+			}
+			if (!setDMXFilter(fd, pid)) {
+				CLOSE_FD(fd);
+				return false;
+			}
+			_frontendData.setDMXFileDescriptor(pid, fd);
 			SI_LOG_DEBUG("Stream: %d, Set filter PID: %04d - fd: %03d%s",
-					_streamID, pid, _frontendData.getDMXFileDescriptor(pid),
-					getFilter().isMarkedAsPMT(pid) ? " - PMT" : "");
+					_streamID, pid, fd, getFilter().isMarkedAsPMT(pid) ? " - PMT" : "");
 		}
 		return true;
 	}
 
+	bool Frontend::addPidToSharedDMX(const int pid) {
+		if (_fd_dmx == -1) {
+			_fd_dmx = openDMX(_path_to_dmx);
+			if (_fd_dmx == -1) {
+				return false;
+			}
+			if (!setDMXFilter(_fd_dmx, pid)) {
+				CLOSE_FD(_fd_dmx);
+				return false;
+			}
+		} else {
+			uint16_t dmxPid = pid;
+			if (::ioctl(_fd_dmx, DMX_ADD_PID, &dmxPid) != 0) {
+				if (errno == ENOTTY || errno == EINVAL) {
+					SI_LOG_INFO("Stream: %d, DMX_ADD_PID not supported, using an demux per PID", _streamID);
+					_dmxAddPidSupported = false;
+					// The first PID is the only one on the shared demux, so it
+					// keeps it as its own per PID demux
+					_fd_dmx = -1;
+					_dmxPidCount = 0;
+				} else {
+					PERROR("DMX_ADD_PID");
+				}
+				return false;
+			}
+		}
+		_frontendData.setDMXFileDescriptor(pid, _fd_dmx);
+		++_dmxPidCount;
+		SI_LOG_DEBUG("Stream: %d, Add filter PID: %04d - fd: %03d%s",
+				_streamID, pid, _fd_dmx, getFilter().isMarkedAsPMT(pid) ? " - PMT" : "");
+		return true;
+	}
+
+	void Frontend::closeSharedDMX() {
+		if (_fd_dmx != -1) {
+			if (::ioctl(_fd_dmx, DMX_STOP) != 0) {
+				PERROR("DMX_STOP");
+			}
+			CLOSE_FD(_fd_dmx);
+		}
+		_dmxPidCount = 0;
+	}
+
+	void Frontend::closeAllPidFilters() {
+		base::MutexLock lock(_mutex);
+		for (std::size_t i = 0u; i < mpegts::PidTable::MAX_PIDS; ++i) {
+			closePid(i);
+		}
+		closeSharedDMX();
+		if (_fd_dmx_all != -1) {
+			if (::ioctl(_fd_dmx_all, DMX_STOP) != 0) {
+				PERROR("DMX_STOP");
+			}
+			CLOSE_FD(_fd_dmx_all);
+		}
+		_softwarePidFilter = false;
+	}
+
+	std::size_t Frontend::getRequestedPIDCount() const {
+		std::size_t count = 0;
+		for (std::size_t i = 0u; i < mpegts::PidTable::ALL_PIDS; ++i) {
+			if (_frontendData.isPIDUsed(i)) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	bool Frontend::updateSoftwarePidFilter() {
+		if (_fd_dmx_all == -1) {
+			// Switching over, so free all hardware PID filters first
+			for (std::size_t i = 0u; i < mpegts::PidTable::MAX_PIDS; ++i) {
+				closePid(i);
+			}
+			closeSharedDMX();
+			_fd_dmx_all = openDMX(_path_to_dmx);
+			if (_fd_dmx_all == -1) {
+				return false;
+			}
+			if (!setDMXFilter(_fd_dmx_all, mpegts::PidTable::ALL_PIDS)) {
+				CLOSE_FD(_fd_dmx_all);
+				return false;
+			}
+			SI_LOG_INFO("Stream: %d, Switched to software PID filter - fd: %03d", _streamID, _fd_dmx_all);
+		}
+		for (std::size_t i = 0u; i < mpegts::PidTable::ALL_PIDS; ++i) {
+			_pidFilter.set(i, _frontendData.isPIDUsed(i));
+		}
+		_softwarePidFilter = true;
+		return true;
+	}
+
 	void Frontend::closePid(const int pid) {
-		if (_frontendData.getDMXFileDescriptor(pid) != -1) {
+		const int fd = _frontendData.getDMXFileDescriptor(pid);
+		if (fd != -1) {
 			SI_LOG_DEBUG("Stream: %d, Remove filter PID: %04d - fd: %03d - Packet Count: %d",
-					_streamID, pid, _frontendData.getDMXFileDescriptor(pid), _frontendData.getPacketCounter(pid));
-			if (::ioctl(_frontendData.getDMXFileDescriptor(pid), DMX_STOP) != 0) {
-				PERROR("DMX_STOP");
+					_streamID, pid, fd, _frontendData.getPacketCounter(pid));
+			if (fd == _fd_dmx && _dmxPidCount > 1) {
+				uint16_t dmxPid = pid;
+				if (::ioctl(_fd_dmx, DMX_REMOVE_PID, &dmxPid) != 0) {
+					PERROR("DMX_REMOVE_PID");
+				}
+				_frontendData.resetDMXFileDescriptor(pid);
+				--_dmxPidCount;
+			} else {
+				// Also the last PID of the shared demux, the filter it was
+				// setup with can not always be removed with DMX_REMOVE_PID
+				if (fd == _fd_dmx) {
+					_fd_dmx = -1;
+					_dmxPidCount = 0;
+				}
+				if (::ioctl(fd, DMX_STOP) != 0) {
+					PERROR("DMX_STOP");
+				}
+				_frontendData.closeDMXFileDescriptor(pid);
 			}
-			_frontendData.closeDMXFileDescriptor(pid);
 		}
 	}
 
@@ -755,21 +1218,59 @@ namespace dvb {
 			if (isTuned()) {
 				_frontendData.resetPIDTableChanged();
 				SI_LOG_INFO("Stream: %d, Updating PID filters...", _streamID);
-				// Check should we close PIDs first
-				for (std::size_t i = 0u; i < mpegts::PidTable::MAX_PIDS; ++i) {
-					if (_frontendData.shouldPIDClose(i)) {
-						closePid(i);
+				const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+				// Use the software PID filter when there are more PIDs requested
+				// than the hardware can handle (configured or found out)
+				const std::size_t count = getRequestedPIDCount();
+				const bool overLimit = (_hwPidLimit > 0 && count > _hwPidLimit) ||
+					(_hwPidFailCount > 0 && count >= _hwPidFailCount);
+				if (overLimit && !_frontendData.isPIDUsed(mpegts::PidTable::ALL_PIDS)) {
+					const bool ok = updateSoftwarePidFilter();
+					_pidUpdateTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+						std::chrono::steady_clock::now() - begin).count();
+					SI_LOG_INFO("Stream: %d, Updating PID filters (Software filter with %zu PIDs in %ld us)",
+						_streamID, count, _pidUpdateTimeUs);
+					return ok;
+				}
+				if (_fd_dmx_all != -1) {
+					// Back to the hardware PID filters, the PID table has no open
+					// filters now, so the difference below opens all of them
+					if (::ioctl(_fd_dmx_all, DMX_STOP) != 0) {
+						PERROR("DMX_STOP");
 					}
+					CLOSE_FD(_fd_dmx_all);
+					_softwarePidFilter = false;
+					SI_LOG_INFO("Stream: %d, Switched back to hardware PID filters", _streamID);
+				}
+
+				// Only apply the difference with the current PID filters
+				std::vector<int> toClose;
+				std::vector<int> toOpen;
+				_frontendData.getPIDChanges(toClose, toOpen);
+
+				// Close PIDs first
+				for (const int pid : toClose) {
+					closePid(pid);
 				}
-				// Check which PID should be openend (again)
-				for (std::size_t i = 0u; i < mpegts::PidTable::MAX_PIDS; ++i) {
-					if (_frontendData.isPIDUsed(i)) {
-						// Check if we have no DMX for this PID, then open one
-						if (!openPid(i)) {
+				// Open the new PIDs
+				for (const int pid : toOpen) {
+					if (!openPid(pid)) {
+						if (pid == mpegts::PidTable::ALL_PIDS) {
 							return false;
 						}
+						// Hardware ran out of PID filters, remember this limit
+						// and let the software PID filter take over
+						_hwPidFailCount = count;
+						SI_LOG_INFO("Stream: %d, Unable to set filter PID: %04d with %zu PIDs requested, using software PID filter",
+							_streamID, pid, count);
+						return updateSoftwarePidFilter();
 					}
 				}
+				_pidUpdateTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - begin).count();
+				SI_LOG_INFO("Stream: %d, Updating PID filters (Closed %zu, Opened %zu in %ld us)",
+					_streamID, toClose.size(), toOpen.size(), _pidUpdateTimeUs);
 			} else {
 				SI_LOG_INFO("Stream: %d, Update PID filters requested, but frontend not tuned!",
 							_streamID);
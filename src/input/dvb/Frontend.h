@@ -25,11 +25,16 @@
 #include <input/Transformation.h>
 #include <input/dvb/delivery/System.h>
 #include <input/dvb/FrontendData.h>
+#include <input/dvb/DvrBufferSizer.h>
+#include <input/dvb/DvrReader.h>
+#include <mpegts/PidFilter.h>
+#include <mpegts/TSHeaderParser.h>
 #ifdef LIBDVBCSA
 #include <input/dvb/FrontendDecryptInterface.h>
 #include <decrypt/dvbapi/ClientProperties.h>
 #endif
 
+#include <atomic>
 #include <vector>
 #include <string>
 
@@ -59,6 +64,12 @@ class Frontend :
 
 		static const unsigned int DEFAULT_DVR_BUFFER_SIZE;
 		static const unsigned int MAX_DVR_BUFFER_SIZE;
+		static const unsigned int DEFAULT_DVR_BULK_READ_SIZE;
+		static const unsigned int MAX_DVR_BULK_READ_SIZE;
+		static const unsigned int MIN_LOCK_TIMEOUT;
+		static const unsigned int DEFAULT_LOCK_TIMEOUT;
+		static const unsigned int MAX_LOCK_TIMEOUT;
+		static const unsigned int MAX_HW_PID_LIMIT;
 
 		// =======================================================================
 		//  -- Constructors and destructor ---------------------------------------
@@ -113,6 +124,8 @@ class Frontend :
 
 		virtual void decryptBatch(bool final) override;
 
+		virtual unsigned int getBatchAge() const override;
+
 		virtual void setBatchData(unsigned char *ptr, int len, int parity, unsigned char *originalPtr) override;
 
 		virtual const dvbcsa_bs_key_s *getKey(int parity) const override;
@@ -163,6 +176,8 @@ class Frontend :
 
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) override;
 
+		virtual int getInputFileDescriptor() const override;
+
 		virtual bool capableOf(InputSystem system) const override;
 
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const override;
@@ -171,12 +186,20 @@ class Frontend :
 
 		virtual bool hasDeviceDataChanged() const override;
 
+		virtual bool hasLock() const override;
+
 		virtual void parseStreamString(const std::string &msg, const std::string &method) override;
 
 		virtual bool update() override;
 
 		virtual bool teardown() override;
 
+		virtual bool standby() override;
+
+		virtual std::string getStandbyKey() const override;
+
+		virtual std::string getTransponderKey() const override;
+
 		virtual std::string attributeDescribeString() const override;
 
 		// =======================================================================
@@ -193,12 +216,21 @@ class Frontend :
 		///
 		void closeFE();
 
+		/// Let all delivery systems forget their cached device state
+		void invalidateDeliverySystemState();
+
 		///
 		int openDVR(const std::string &path) const;
 
 		///
 		void closeDVR();
 
+		/// Account a failed DVR read, EOVERFLOW means data was lost
+		void handleDVRReadError();
+
+		/// Apply the new DVR buffer size when the adaptive mode asks for it
+		void adaptDVRBufferSize();
+
 		///
 		int openDMX(const std::string &path) const;
 
@@ -218,12 +250,60 @@ class Frontend :
 		///
 		bool setupAndTune();
 
+		/// Wait until the frontend reports a lock, by waiting on frontend
+		/// events, or until the timeout expired
+		/// @param timeoutMs specifies the maximum time to wait on lock
+		/// @return true if the frontend has a lock
+		bool waitOnLock(unsigned int timeoutMs);
+
+		/// Wait until the frontend sends an event, so a tune that failed because
+		/// the driver was still busy can be retried, or until the timeout expired
+		/// @param timeoutMs specifies the maximum time to wait on an event
+		void waitOnFrontendEvent(int timeoutMs);
+
+		/// Check if the frontend has a lock right now
+		bool isLocked() const;
+
+		/// Get the key of the transponder in the current frontend data
+		/// (see @c WarmStandby)
+		std::string getRequestedTransponderKey() const;
+
+		/// Add the measured tune-to-lock time to the histogram
+		void addTuneToLockTime(long timeMs, bool locked);
+
+		/// Get the tune-to-lock histogram as string
+		std::string getTuneToLockHistogram() const;
+
 		///
 		void closePid(int pid);
 
 		///
 		bool openPid(int pid);
 
+		/// Add PID to the shared demux with DMX_ADD_PID, the first PID
+		/// will setup the shared demux
+		bool addPidToSharedDMX(int pid);
+
+		/// Close the shared demux, all PIDs should be removed already
+		void closeSharedDMX();
+
+		/// Close all PID filters, hardware and software
+		void closeAllPidFilters();
+
+		/// Get the amount of requested PIDs, without 'all PIDs'
+		std::size_t getRequestedPIDCount() const;
+
+		/// Open the 'all PIDs' demux, if not already open, and make the
+		/// software PID filter pass the requested PIDs
+		bool updateSoftwarePidFilter();
+
+		/// Drop the TS packets from the full @a buffer that did not pass the
+		/// software PID filter, by moving the wanted packets to the front
+		/// @param header will get the decoded headers of the TS packets, they
+		/// are only valid for the buffer when it is still full
+		/// @return true if the buffer is still full
+		bool filterSoftwarePIDs(mpegts::PacketBuffer &buffer, mpegts::TSPacketHeader *header);
+
 		// =======================================================================
 		// -- Data members -------------------------------------------------------
 		// =======================================================================
@@ -232,6 +312,17 @@ class Frontend :
 		bool _tuned;
 		int _fd_fe;
 		int _fd_dvr;
+		int _fd_dmx;               /// shared demux for all PIDs (DMX_ADD_PID)
+		std::size_t _dmxPidCount;  /// PIDs on the shared demux
+		bool _dmxAddPidSupported;  /// false if we need an demux per PID
+		long _pidUpdateTimeUs;     /// time of last PID filter update
+		int _fd_dmx_all;           /// 'all PIDs' demux for the software PID filter
+		std::atomic<bool> _softwarePidFilter;
+		mpegts::PidFilter _pidFilter;   /// PIDs passing the software PID filter
+		std::size_t _hwPidLimit;        /// 0 = only switch when hardware fails
+		std::size_t _hwPidFailCount;    /// PID count the hardware failed on
+		std::atomic<uint64_t> _softwarePidDropped;
+		std::string _standbyKey;   /// transponder we stay tuned to in standby
 		std::string _path_to_fe;
 		std::string _path_to_dvr;
 		std::string _path_to_dmx;
@@ -250,7 +341,16 @@ class Frontend :
 		std::size_t _dvbc;
 		std::size_t _dvbc2;
 
-		unsigned long _dvrBufferSizeMB;
+		unsigned long _dvrBufferSizeMB;  /// in adaptive mode the maximum size
+		bool _dvrBufferAdaptive;
+		unsigned long _dvrBulkReadSizeKB;
+		unsigned int _lockTimeoutMs;
+
+		static constexpr std::size_t TUNE_TO_LOCK_BUCKETS = 8;
+		unsigned long _tuneToLock[TUNE_TO_LOCK_BUCKETS]; /// last bucket is 'no lock'
+		long _lastTuneToLockMs;
+		input::dvb::DvrReader _dvrReader;
+		input::dvb::DvrBufferSizer _dvrBufferSizer;
 };
 
 } // namespace dvb
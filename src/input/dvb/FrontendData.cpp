@@ -451,7 +451,6 @@ namespace dvb {
 	}
 
 	void FrontendData::addPIDData(const int pid, const uint8_t cc) {
-		base::MutexLock lock(_mutex);
 		_pidTable.addPIDData(pid, cc);
 	}
 
@@ -465,6 +464,16 @@ namespace dvb {
 		_pidTable.closeDMXFileDescriptor(pid);
 	}
 
+	void FrontendData::resetDMXFileDescriptor(const int pid) {
+		base::MutexLock lock(_mutex);
+		_pidTable.resetDMXFileDescriptor(pid);
+	}
+
+	void FrontendData::getPIDChanges(std::vector<int> &toClose, std::vector<int> &toOpen) {
+		base::MutexLock lock(_mutex);
+		_pidTable.getPIDChanges(toClose, toOpen);
+	}
+
 	void FrontendData::resetPIDTableChanged() {
 		base::MutexLock lock(_mutex);
 		_pidTable.resetPIDTableChanged();
@@ -491,7 +500,6 @@ namespace dvb {
 	}
 
 	uint32_t FrontendData::getPacketCounter(const int pid) const {
-		base::MutexLock lock(_mutex);
 		return _pidTable.getPacketCounter(pid);
 	}
 
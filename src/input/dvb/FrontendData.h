@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 namespace input {
 namespace dvb {
@@ -86,19 +87,27 @@ namespace dvb {
 			/// Close DMX file descriptor and reset data, but keep used flag
 			void closeDMXFileDescriptor(int pid);
 
+			/// Reset DMX file descriptor and data without closing it, but keep used flag
+			void resetDMXFileDescriptor(int pid);
+
+			/// @see mpegts::PidTable::getPIDChanges
+			void getPIDChanges(std::vector<int> &toClose, std::vector<int> &toOpen);
+
 			/// Reset 'PID has changed' flag
 			void resetPIDTableChanged();
 
 			/// Check the 'PID has changed' flag
 			bool hasPIDTableChanged() const;
 
-			/// Get the amount of packet that were received of this pid
+			/// Get the amount of packet that were received of this pid,
+			/// without taking the lock
 			uint32_t getPacketCounter(int pid) const;
 
 			/// Get the CSV of all the requested PID
 			std::string getPidCSV() const;
 
-			/// Set the continuity counter for pid
+			/// Set the continuity counter for pid. Only the thread reading the
+			/// frontend should call this, it does not take the lock
 			void addPIDData(int pid, uint8_t cc);
 
 			/// Set pid used or not
@@ -61,6 +61,9 @@ namespace dvb {
 			///
 			virtual void decryptBatch(bool final) = 0;
 
+			/// Get the age in ms of the oldest TS packet waiting in the decrypt batch
+			virtual unsigned int getBatchAge() const = 0;
+
 			///
 			virtual void setBatchData(unsigned char *ptr, int len, int parity, unsigned char *originalPtr) = 0;
 
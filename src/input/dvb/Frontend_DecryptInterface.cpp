@@ -44,6 +44,10 @@ namespace dvb {
 		return _dvbapiData.decryptBatch(final);
 	}
 
+	unsigned int Frontend::getBatchAge() const {
+		return _dvbapiData.getBatchAge();
+	}
+
 	void Frontend::setBatchData(unsigned char *ptr, int len, int parity, unsigned char *originalPtr) {
 		_dvbapiData.setBatchData(ptr, len, parity, originalPtr);
 	}
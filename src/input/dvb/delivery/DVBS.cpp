@@ -125,6 +125,13 @@ namespace delivery {
 		return true;
 	}
 
+	void DVBS::invalidateCachedState() {
+		base::MutexLock lock(_xmlMutex);
+		if (_diseqc) {
+			_diseqc->invalidateState();
+		}
+	}
+
 	// =======================================================================
 	//  -- Other member functions --------------------------------------------
 	// =======================================================================
@@ -70,6 +70,8 @@ namespace delivery {
 				       system == input::InputSystem::DVBS;
 			}
 
+			virtual void invalidateCachedState() override;
+
 			// =======================================================================
 			// -- Other member functions ---------------------------------------------
 			// =======================================================================
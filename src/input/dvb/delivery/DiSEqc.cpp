@@ -32,8 +32,16 @@ namespace delivery {
 	// =======================================================================
 	//  -- Constructors and destructor ---------------------------------------
 	// =======================================================================
+	constexpr unsigned int DiSEqc::DEFAULT_RESEND_IDLE_TIME;
+	constexpr unsigned int DiSEqc::MAX_RESEND_IDLE_TIME;
+
 	DiSEqc::DiSEqc() :
-		_diseqcRepeat(2) {}
+		_diseqcRepeat(2),
+		_resendIdleTime(DEFAULT_RESEND_IDLE_TIME),
+		_stateValid(false),
+		_sentFull(0),
+		_sentPartial(0),
+		_skipped(0) {}
 
 	DiSEqc::~DiSEqc() {}
 
@@ -48,6 +56,10 @@ namespace delivery {
 		}
 
 		ADD_XML_NUMBER_INPUT(xml, "diseqc_repeat", _diseqcRepeat, 1, 10);
+		ADD_XML_NUMBER_INPUT(xml, "diseqc_resend_idle", _resendIdleTime, 0, MAX_RESEND_IDLE_TIME);
+		ADD_XML_ELEMENT(xml, "diseqc_sent_full", _sentFull);
+		ADD_XML_ELEMENT(xml, "diseqc_sent_partial", _sentPartial);
+		ADD_XML_ELEMENT(xml, "diseqc_skipped", _skipped);
 	}
 
 	void DiSEqc::fromXML(const std::string &xml) {
@@ -63,6 +75,39 @@ namespace delivery {
 		if (findXMLElement(xml, "diseqc_repeat.value", element)) {
 			_diseqcRepeat = std::stoi(element);
 		}
+		if (findXMLElement(xml, "diseqc_resend_idle.value", element)) {
+			const unsigned int idle = std::stoi(element);
+			_resendIdleTime = (idle <= MAX_RESEND_IDLE_TIME) ? idle : DEFAULT_RESEND_IDLE_TIME;
+		}
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void DiSEqc::invalidateState() {
+		base::MutexLock lock(_xmlMutex);
+		_stateValid = false;
+	}
+
+	bool DiSEqc::getCachedState(State &state) const {
+		base::MutexLock lock(_xmlMutex);
+		if (!_stateValid || _resendIdleTime == 0) {
+			return false;
+		}
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - _stateTime >= std::chrono::seconds(_resendIdleTime)) {
+			return false;
+		}
+		state = _state;
+		return true;
+	}
+
+	void DiSEqc::setCachedState(const State &state) {
+		base::MutexLock lock(_xmlMutex);
+		_state = state;
+		_stateValid = true;
+		_stateTime = std::chrono::steady_clock::now();
 	}
 
 } // namespace delivery
@@ -23,6 +23,9 @@
 #include <base/XMLSupport.h>
 #include <input/dvb/delivery/Lnb.h>
 
+#include <chrono>
+#include <cstdint>
+
 namespace input {
 namespace dvb {
 namespace delivery {
@@ -59,18 +62,67 @@ namespace delivery {
 			virtual bool sendDiseqc(int feFD, int streamID, uint32_t &freq,
 				int src, Lnb::Polarization pol) = 0;
 
+			/// Forget the cached switch/LNB state, so the next @c sendDiseqc
+			/// will send the complete sequence again (e.g. after a lock failure
+			/// or when the frontend was closed and the LNB lost its power)
+			void invalidateState();
+
+		protected:
+
+			/// The switch/LNB state that was applied with the last @c sendDiseqc
+			struct State {
+				int src;
+				Lnb::Polarization pol;
+				bool hiband;
+				uint32_t freq;    // Only used by Unicable/Jess, the requested IF
+			};
+
+			/// Get the cached switch/LNB state
+			/// @param state will be set to the cached state
+			/// @return true if the cached state is valid and not idle for too
+			/// long, otherwise a full sequence should be send
+			bool getCachedState(State &state) const;
+
+			/// Set the switch/LNB state that is applied now
+			void setCachedState(const State &state);
+
+			/// Count the kind of sequence that was send, for statistics
+			void addSentFull() {
+				base::MutexLock lock(_xmlMutex);
+				++_sentFull;
+			}
+			void addSentPartial() {
+				base::MutexLock lock(_xmlMutex);
+				++_sentPartial;
+			}
+			void addSkipped() {
+				base::MutexLock lock(_xmlMutex);
+				++_skipped;
+			}
 
 			// =======================================================================
 			// -- Data members -------------------------------------------------------
 			// =======================================================================
 		public:
 			static constexpr size_t MAX_LNB = 4;
+			static constexpr unsigned int DEFAULT_RESEND_IDLE_TIME = 60;
+			static constexpr unsigned int MAX_RESEND_IDLE_TIME = 3600;
 
 		protected:
 
 			unsigned int _diseqcRepeat;
 			Lnb _lnb[MAX_LNB];    // LNB properties
 
+		private:
+
+			unsigned int _resendIdleTime;    // in seconds, 0 = always send complete sequence
+			bool _stateValid;
+			State _state;
+			std::chrono::steady_clock::time_point _stateTime;
+			uint64_t _sentFull;
+			uint64_t _sentPartial;
+			uint64_t _skipped;
+
 	};
 
 } // namespace delivery
@@ -108,14 +108,32 @@ namespace delivery {
 		             (hiband ? 4 : 0) | ((t >> 8) & 0x03) );
 		cmd.msg[4] = (t & 0xff);
 
-		if (ioctl(feFD, FE_SET_VOLTAGE, SEC_VOLTAGE_13) == -1) {
-			PERROR("FE_SET_VOLTAGE failed");
+		// The command carries the frequency, so it is only skipped when the
+		// complete request is the same. When the LNB is still powered and idle
+		// (13V, no tone) after the previous command, skip the preparation
+		const State state = { src, pol, hiband, t };
+		State cached;
+		const bool valid = getCachedState(cached);
+		if (valid && cached.src == src && cached.pol == pol &&
+		    cached.hiband == hiband && cached.freq == t) {
+			SI_LOG_DEBUG("Stream: %d, DiSEqC state unchanged, skipping", streamID);
+			addSkipped();
+			setCachedState(state);
+			return true;
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
-		if (ioctl(feFD, FE_SET_TONE, SEC_TONE_OFF) == -1) {
-			PERROR("FE_SET_TONE failed");
+		if (!valid) {
+			if (ioctl(feFD, FE_SET_VOLTAGE, SEC_VOLTAGE_13) == -1) {
+				PERROR("FE_SET_VOLTAGE failed");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			if (ioctl(feFD, FE_SET_TONE, SEC_TONE_OFF) == -1) {
+				PERROR("FE_SET_TONE failed");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			addSentFull();
+		} else {
+			addSentPartial();
 		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(50));
 		for (size_t i = 0; i < _diseqcRepeat; ++i) {
 			SI_LOG_INFO("Stream: %d, Sending DiSEqC [%02x] [%02x] [%02x] [%02x] [%02x]", streamID, cmd.msg[0],
 					cmd.msg[1], cmd.msg[2], cmd.msg[3], cmd.msg[4]);
@@ -132,6 +150,7 @@ namespace delivery {
 			}
 			std::this_thread::sleep_for(std::chrono::milliseconds(150));
 		}
+		setCachedState(state);
 		return true;
 	}
 
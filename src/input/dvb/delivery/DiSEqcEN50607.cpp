@@ -81,14 +81,6 @@ namespace delivery {
 
 	bool DiSEqcEN50607::sendDiseqc(int feFD, int streamID, uint32_t &freq,
                 int src, Lnb::Polarization pol) {
-		if (ioctl(feFD, FE_SET_VOLTAGE, SEC_VOLTAGE_13) == -1) {
-			PERROR("FE_SET_VOLTAGE failed");
-		}
-		if (ioctl(feFD, FE_SET_TONE, SEC_TONE_OFF) == -1) {
-			PERROR("FE_SET_TONE failed");
-		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(900));
-
 		return sendDiseqcJess(feFD, streamID, freq, src, pol);
 	}
 
@@ -115,6 +107,32 @@ namespace delivery {
 		cmd.msg[2] = (t & 0xff);
 		cmd.msg[3] = (((src << 2) & 0x0f) | ((pol == Lnb::Polarization::Vertical) ? 0 : 2) | (hiband ? 1 : 0));
 
+		// The command carries the frequency, so it is only skipped when the
+		// complete request is the same. When the LNB is still powered and idle
+		// (13V, no tone) after the previous command, skip the long power-up wait
+		const State state = { src, pol, hiband, t };
+		State cached;
+		const bool valid = getCachedState(cached);
+		if (valid && cached.src == src && cached.pol == pol &&
+		    cached.hiband == hiband && cached.freq == t) {
+			SI_LOG_DEBUG("Stream: %d, DiSEqC state unchanged, skipping", streamID);
+			addSkipped();
+			setCachedState(state);
+			return true;
+		}
+		if (!valid) {
+			if (ioctl(feFD, FE_SET_VOLTAGE, SEC_VOLTAGE_13) == -1) {
+				PERROR("FE_SET_VOLTAGE failed");
+			}
+			if (ioctl(feFD, FE_SET_TONE, SEC_TONE_OFF) == -1) {
+				PERROR("FE_SET_TONE failed");
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(900));
+			addSentFull();
+		} else {
+			addSentPartial();
+		}
+
 		for (size_t i = 0; i < _diseqcRepeat; ++i) {
 			std::this_thread::sleep_for(std::chrono::milliseconds(300));
 			SI_LOG_INFO("Stream: %d, Sending DiSEqC [%02x] [%02x] [%02x] [%02x] [%02x]", streamID, cmd.msg[0],
@@ -131,6 +149,7 @@ namespace delivery {
 				PERROR("FE_SET_VOLTAGE failed");
 			}
 		}
+		setCachedState(state);
 		return true;
 	}
 
@@ -37,7 +37,8 @@ namespace delivery {
 	//  -- Constructors and destructor ---------------------------------------
 	// =======================================================================
 	DiSEqcSwitch::DiSEqcSwitch() :
-		DiSEqc() {}
+		DiSEqc(),
+		_toneVoltageSwitch(false) {}
 
 	DiSEqcSwitch::~DiSEqcSwitch() {}
 
@@ -48,6 +49,7 @@ namespace delivery {
 	void DiSEqcSwitch::addToXML(std::string &xml) const {
 		{
 			base::MutexLock lock(_xmlMutex);
+			ADD_XML_CHECKBOX(xml, "diseqc_tone_voltage_switch", (_toneVoltageSwitch ? "true" : "false"));
 		}
 		DiSEqc::addToXML(xml);
 	}
@@ -55,6 +57,10 @@ namespace delivery {
 	void DiSEqcSwitch::fromXML(const std::string &xml) {
 		{
 			base::MutexLock lock(_xmlMutex);
+			std::string element;
+			if (findXMLElement(xml, "diseqc_tone_voltage_switch.value", element)) {
+				_toneVoltageSwitch = (element == "true") ? true : false;
+			}
 		}
 		DiSEqc::fromXML(xml);
 	}
@@ -87,11 +93,56 @@ namespace delivery {
 		cmd.msg[3] =
 		  0xf0 | (((src << 2) & 0x0f) | ((pol == Lnb::Polarization::Vertical) ? 0 : 2) | (hiband ? 1 : 0));
 
+		const fe_sec_voltage_t voltage = (pol == Lnb::Polarization::Vertical) ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18;
+		const fe_sec_tone_mode_t tone = hiband ? SEC_TONE_ON : SEC_TONE_OFF;
+		const State state = { src, pol, hiband, 0 };
+
+		bool toneVoltageSwitch;
+		{
+			base::MutexLock lock(_xmlMutex);
+			toneVoltageSwitch = _toneVoltageSwitch;
+		}
+
+		// Same switch position as the last tune, then only change the LNB
+		// voltage and/or tone when needed. A switch that selects polarisation
+		// and band by the committed command gets the full sequence again
+		State cached;
+		if (getCachedState(cached) && cached.src == src &&
+			(toneVoltageSwitch || (cached.pol == pol && cached.hiband == hiband))) {
+			if (cached.pol == pol && cached.hiband == hiband) {
+				SI_LOG_DEBUG("Stream: %d, DiSEqC state unchanged, skipping", streamID);
+				addSkipped();
+			} else {
+				SI_LOG_INFO("Stream: %d, DiSEqC position unchanged, only setting%s%s", streamID,
+					(cached.pol != pol) ? " voltage" : "", (cached.hiband != hiband) ? " tone" : "");
+				if (cached.pol != pol && ioctl(feFD, FE_SET_VOLTAGE, voltage) == -1) {
+					PERROR("FE_SET_VOLTAGE failed");
+					invalidateState();
+					return false;
+				}
+				if (cached.hiband != hiband && ioctl(feFD, FE_SET_TONE, tone) == -1) {
+					PERROR("FE_SET_TONE failed");
+					invalidateState();
+					return false;
+				}
+				// Let the LNB and switch settle, like after the full sequence
+				std::this_thread::sleep_for(std::chrono::milliseconds(15));
+				addSentPartial();
+			}
+			setCachedState(state);
+			return true;
+		}
+
 		SI_LOG_INFO("Stream: %d, Sending DiSEqC [%02x] [%02x] [%02x] [%02x]", streamID, cmd.msg[0],
 				cmd.msg[1], cmd.msg[2], cmd.msg[3]);
 
-		return diseqcSwitch(feFD, (pol == Lnb::Polarization::Vertical) ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18,
-				cmd, hiband ? SEC_TONE_ON : SEC_TONE_OFF, (src % 2) ? SEC_MINI_B : SEC_MINI_A);
+		if (!diseqcSwitch(feFD, voltage, cmd, tone, (src % 2) ? SEC_MINI_B : SEC_MINI_A)) {
+			invalidateState();
+			return false;
+		}
+		addSentFull();
+		setCachedState(state);
+		return true;
 	}
 
 	// =======================================================================
@@ -76,6 +76,10 @@ namespace delivery {
 			// =======================================================================
 
 		private:
+
+			/// The switch selects polarisation and band only by LNB voltage and
+			/// tone, not by the bits of the committed command
+			bool _toneVoltageSwitch;
 	};
 
 } // namespace delivery
@@ -62,6 +62,10 @@ namespace delivery {
 			///
 			virtual bool isCapableOf(input::InputSystem system) const = 0;
 
+			/// Forget any cached device state (like the DiSEqc switch position),
+			/// so the next tune will set up everything again
+			virtual void invalidateCachedState() {}
+
 			// =======================================================================
 			// -- Data members -------------------------------------------------------
 			// =======================================================================
@@ -24,9 +24,11 @@
 #include <Stream.h>
 #include <StringConverter.h>
 #include <mpegts/PacketBuffer.h>
+#include <mpegts/TSHeaderParser.h>
 
 #include <chrono>
-#include <thread>
+
+#include <poll.h>
 
 namespace input {
 namespace file {
@@ -100,16 +102,27 @@ namespace file {
 
 			const long interval = _pcrDelta - std::chrono::duration_cast<std::chrono::microseconds>(_t1 - _t2).count();
 			if (interval > 0) {
-				std::this_thread::sleep_for(std::chrono::microseconds(interval));
+				waitOrWakeUp(interval);
 			}
 			_t1 = std::chrono::steady_clock::now();
 			_pcrDelta = 0;
 		} else {
-			std::this_thread::sleep_for(std::chrono::microseconds(1000));
+			waitOrWakeUp(1000);
 		}
 		return true;
 	}
 
+	void TSReader::waitOrWakeUp(const long timeUs) {
+		pollfd pfd[1];
+		pfd[0].fd = _fd_wake;
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		const struct timespec timeout = { timeUs / 1000000, (timeUs % 1000000) * 1000 };
+		if (::ppoll(pfd, 1, &timeout, nullptr) > 0 && (pfd[0].revents & POLLIN)) {
+			clearWakeUp();
+		}
+	}
+
 	bool TSReader::readFullTSPacket(mpegts::PacketBuffer &buffer) {
 		if (_file.is_open()) {
 			const auto size = buffer.getAmountOfBytesToWrite();
@@ -119,19 +132,21 @@ namespace file {
 
 			if (buffer.full()) {
 				const std::size_t size = buffer.getNumberOfTSPackets();
-				for (std::size_t i = 0; i < size; ++i) {
+				mpegts::TSPacketHeader header[mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS];
+				mpegts::TSHeaderParser::parse(buffer.getTSReadBufferPtr(), size, header);
+				// Packets kept from a previous fill, before some were dropped,
+				// are accounted already
+				for (std::size_t i = buffer.getAccountedTSPackets(); i < size; ++i) {
 					// Get TS packet from the buffer
 					const unsigned char *data = buffer.getTSPacketPtr(i);
 
 					// Check is this the beginning of the TS and no Transport error indicator
-					if (data[0] == 0x47 && (data[1] & 0x80) != 0x80) {
+					if (header[i].isValid()) {
 						// Add data to Filter
-						getFilter().addData(_streamID, data);
+						getFilter().addData(_streamID, data, header[i]);
 
-						// get PID from TS
-						const uint16_t pid = ((data[1] & 0x1f) << 8) | data[2];
 						const uint16_t pcrPID = getFilter().getPMTData().getPCRPid();
-						if (pid == pcrPID && (data[3] & 0x20) == 0x20 && (data[5] & 0x10) == 0x10) {
+						if (header[i].pid == pcrPID && header[i].hasAdaptationField() && (data[5] & 0x10) == 0x10) {
 							// Check for 'adaptation field flag' and 'PCR field present'
 
 							//        4           3          2          1          0
@@ -160,6 +175,7 @@ namespace file {
 						}
 					}
 				}
+				buffer.setAccountedTSPackets(size);
 			}
 			return buffer.full();
 		}
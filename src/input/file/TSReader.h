@@ -116,6 +116,9 @@ class TSReader :
 
 	protected:
 
+		/// Wait @a timeUs micro seconds, or until woken up (see @c wakeUp)
+		void waitOrWakeUp(long timeUs);
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
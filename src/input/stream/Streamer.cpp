@@ -40,6 +40,9 @@ namespace stream {
 		_pfd[0].events  = 0;
 		_pfd[0].revents = 0;
 		_pfd[0].fd      = -1;
+		_pfd[1].events  = POLLIN;
+		_pfd[1].revents = 0;
+		_pfd[1].fd      = _fd_wake;
 	}
 
 	Streamer::~Streamer() {}
@@ -89,9 +92,12 @@ namespace stream {
 	}
 
 	bool Streamer::isDataAvailable() {
-		// call poll with a timeout of 500 ms
-		const int pollRet = poll(_pfd, 1, 500);
+		// call poll with a timeout of 500 ms, or until woken up
+		const int pollRet = poll(_pfd, 2, 500);
 		if (pollRet > 0) {
+			if (_pfd[1].revents & POLLIN) {
+				clearWakeUp();
+			}
 			return _pfd[0].revents != 0;
 		}
 		return false;
@@ -107,7 +113,7 @@ namespace stream {
 			if (readSize > 0) {
 				buffer.addAmountOfBytesWritten(readSize);
 				buffer.trySyncing();
-			} else {
+			} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
 				PERROR("_udpMultiListen");
 			}
 			return buffer.full();
@@ -115,6 +121,10 @@ namespace stream {
 		return false;
 	}
 
+	int Streamer::getInputFileDescriptor() const {
+		return _udpMultiListen.getFD();
+	}
+
 	bool Streamer::capableOf(const input::InputSystem system) const {
 		return system == input::InputSystem::STREAMER;
 	}
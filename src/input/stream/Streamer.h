@@ -95,6 +95,8 @@ class Streamer :
 
 		virtual bool readFullTSPacket(mpegts::PacketBuffer &buffer) override;
 
+		virtual int getInputFileDescriptor() const override;
+
 		virtual bool capableOf(input::InputSystem msys) const override;
 
 		virtual bool capableToTransform(const std::string &msg, const std::string &method) const override;
@@ -124,7 +126,7 @@ class Streamer :
 	private:
 		std::string _bindIPAddress;
 		std::string _uri;
-		pollfd _pfd[1];
+		pollfd _pfd[2];             /// input and wake up
 		SocketClient _udpMultiListen;
 		std::string _multiAddr;
 		int _port;
@@ -30,7 +30,9 @@
 
 namespace mpegts {
 
-	Filter::Filter() {}
+	Filter::Filter() :
+		_pmtPid(-1),
+		_otherProgramSeen(false) {}
 
 	Filter::~Filter() {}
 
@@ -39,10 +41,41 @@ namespace mpegts {
 		_pat.clear();
 		_pmt.clear();
 		_sdt.clear();
+		_pmtPid = -1;
+		_otherProgramSeen = false;
 	}
 
-	void Filter::addData(const int streamID, const unsigned char *ptr) {
-		const uint16_t pid = ((ptr[1] & 0x1f) << 8) | ptr[2];
+	Filter::Priority Filter::getPriority(const int pid) const {
+		// PAT, CAT and the PMT of each program are needed whatever the stream
+		// types of the PMT say
+		if (pid == 0 || pid == 1 || _pat.isMarkedAsPMT(pid)) {
+			return Priority::High;
+		}
+		if (!_pmt.isParsed()) {
+			return Priority::High;
+		}
+		if (pid == _pmt.getPCRPid()) {
+			return Priority::High;
+		}
+		switch (_pmt.getStreamKind(pid)) {
+			case PMT::StreamKind::Video:
+			case PMT::StreamKind::ECM:
+				return Priority::High;
+			case PMT::StreamKind::Audio:
+				return Priority::Medium;
+			case PMT::StreamKind::Subtitle:
+			case PMT::StreamKind::Data:
+				return Priority::Low;
+			case PMT::StreamKind::Unknown:
+			default:
+				break;
+		}
+		return _otherProgramSeen ? Priority::Medium : Priority::Low;
+	}
+
+	void Filter::addData(const int streamID, const unsigned char *ptr,
+			const TSPacketHeader &header) {
+		const uint16_t pid = header.pid;
 		if (pid == 0) {
 			if (!_pat.isCollected()) {
 				// collect PAT data
@@ -54,6 +87,9 @@ namespace mpegts {
 				}
 			}
 		} else if (_pat.isMarkedAsPMT(pid)) {
+			if (_pmt.isCollected() && pid != _pmtPid) {
+				_otherProgramSeen = true;
+			}
 			if (!_pmt.isCollected()) {
 #ifdef ADDDVBCA
 				{
@@ -71,6 +107,7 @@ namespace mpegts {
 				// Did we finish collecting PMT
 				if (_pmt.isCollected()) {
 					_pmt.parse(streamID);
+					_pmtPid = pid;
 				}
 			}
 		} else if (pid == 17) {
@@ -23,6 +23,7 @@
 #include <mpegts/PAT.h>
 #include <mpegts/PMT.h>
 #include <mpegts/SDT.h>
+#include <mpegts/TSHeaderParser.h>
 
 namespace mpegts {
 
@@ -30,6 +31,14 @@ namespace mpegts {
 	class Filter {
 		public:
 
+			/// The priority of a PID, when packets have to be dropped because of
+			/// congestion, the lowest priority is dropped first
+			enum class Priority {
+				High,    /// PAT, PMT, PCR, ECM and video
+				Medium,  /// audio
+				Low      /// subtitles, teletext, EPG and all other PIDs (see @c getPriority)
+			};
+
 			// ================================================================
 			//  -- Constructors and destructor --------------------------------
 			// ================================================================
@@ -43,12 +52,21 @@ namespace mpegts {
 
 		public:
 
-			///
-			void addData(int streamID, const unsigned char *ptr);
+			/// Collect the tables from the TS packet @a ptr
+			/// @param header specifies the decoded header of this TS packet
+			void addData(int streamID, const unsigned char *ptr, const TSPacketHeader &header);
 
 			///
 			void clear(int streamID);
 
+			/// Get the priority of @a pid, with the stream types of the PMT. As
+			/// long as the PMT is not parsed all PIDs have high priority. Only
+			/// the PMT of one program is parsed, so when the stream carries the
+			/// PMT of more programs (like with 'pids=all') the PIDs not in the
+			/// parsed PMT get medium instead of low priority, as they may be
+			/// the video or audio of another program
+			Priority getPriority(int pid) const;
+
 			///
 			bool isMarkedAsPMT(int pid) const {
 				return _pat.isMarkedAsPMT(pid);
@@ -93,6 +111,8 @@ namespace mpegts {
 			mpegts::PMT _pmt;
 			mpegts::SDT _sdt;
 			mpegts::PAT _pat;
+			int _pmtPid;                /// PID of the parsed PMT, -1 if none
+			bool _otherProgramSeen;     /// PMT of another program seen
 
 	};
 
@@ -20,6 +20,8 @@
 #include <mpegts/PMT.h>
 #include <Log.h>
 
+#include <cstring>
+
 namespace mpegts {
 
 	// ========================================================================
@@ -30,7 +32,10 @@ namespace mpegts {
 		_programNumber(0),
 		_pcrPID(0),
 		_prgLength(0),
-		_send(false) {}
+		_send(false),
+		_parsed(false) {
+		std::memset(_streamKind, 0, sizeof(_streamKind));
+	}
 
 	PMT::~PMT() {}
 
@@ -44,6 +49,8 @@ namespace mpegts {
 		_prgLength = 0;
 		_send = false;
 		_progInfo.clear();
+		_parsed = false;
+		std::memset(_streamKind, 0, sizeof(_streamKind));
 		TableData::clear();
 	}
 
@@ -76,6 +83,7 @@ namespace mpegts {
 						const int ecmpid = ((_progInfo[i + 4u] & 0x1F) << 8u) | _progInfo[i + 5u];
 						SI_LOG_INFO("Stream: %d, PMT - CAID: 0x%04X  ECM-PID: %04d  ES-Length: %03d",
 									streamID, caid, ecmpid, subLength);
+						_streamKind[ecmpid] = static_cast<uint8_t>(StreamKind::ECM);
 					}
 					i += subLength + 2u;
 				}
@@ -93,6 +101,8 @@ namespace mpegts {
 
 				SI_LOG_INFO("Stream: %d, PMT - Stream Type: %02d  ES PID: %04d  ES-Length: %03d",
 							streamID, streamType, elementaryPID, esInfoLength);
+				_streamKind[elementaryPID] = static_cast<uint8_t>(
+					classifyStream(streamType, &ptr[i + 5u], esInfoLength));
 				for (std::size_t j = 0u; j < esInfoLength; ) {
 					const std::size_t subLength = ptr[j + i + 6u];
 					// Check for Conditional access system and EMM/ECM PID
@@ -104,6 +114,7 @@ namespace mpegts {
 									streamID, caid, ecmpid, provid, subLength);
 
 						_progInfo.append(&ptr[j + i + 5u], subLength + 2u);
+						_streamKind[ecmpid] = static_cast<uint8_t>(StreamKind::ECM);
 					}
 					// Goto next ES Info
 					j += subLength + 2u;
@@ -111,6 +122,51 @@ namespace mpegts {
 				// Goto next ES entry
 				i += esInfoLength + 5u;
 			}
+			_parsed = true;
+		}
+	}
+
+	PMT::StreamKind PMT::classifyStream(const int streamType, const unsigned char *esInfo,
+			const std::size_t esInfoLength) {
+		switch (streamType) {
+			case 0x01: // MPEG-1 video
+			case 0x02: // MPEG-2 video
+			case 0x10: // MPEG-4 video
+			case 0x1B: // H.264
+			case 0x20: // H.264 MVC
+			case 0x24: // HEVC
+			case 0x42: // AVS
+			case 0xD1: // Dirac
+			case 0xEA: // VC-1
+				return StreamKind::Video;
+			case 0x03: // MPEG-1 audio
+			case 0x04: // MPEG-2 audio
+			case 0x0F: // AAC ADTS
+			case 0x11: // AAC LATM
+			case 0x1C: // MPEG-4 audio
+			case 0x81: // AC-3 (ATSC)
+			case 0x87: // E-AC-3 (ATSC)
+				return StreamKind::Audio;
+			case 0x06: // PES private data, see the descriptors
+				for (std::size_t j = 0u; j + 1u < esInfoLength; ) {
+					switch (esInfo[j]) {
+						case 0x56: // teletext
+						case 0x59: // subtitling
+							return StreamKind::Subtitle;
+						case 0x6A: // AC-3
+						case 0x7A: // E-AC-3
+						case 0x7B: // DTS
+						case 0x7C: // AAC
+						case 0x7F: // extension (AC-4, DTS-HD)
+							return StreamKind::Audio;
+						default:
+							break;
+					}
+					j += esInfo[j + 1u] + 2u;
+				}
+				return StreamKind::Data;
+			default:
+				return StreamKind::Data;
 		}
 	}
 
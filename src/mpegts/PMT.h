@@ -30,6 +30,16 @@ namespace mpegts {
 		public TableData {
 		public:
 
+			/// The kind of elementary stream of a PID, as found in the PMT
+			enum class StreamKind : uint8_t {
+				Unknown,
+				Video,
+				Audio,
+				Subtitle,  /// subtitles and teletext
+				Data,
+				ECM
+			};
+
 			// ================================================================
 			// -- Constructors and destructor ---------------------------------
 			// ================================================================
@@ -63,6 +73,17 @@ namespace mpegts {
 				return _pcrPID;
 			}
 
+			/// Check if the stream kinds of this PMT are known
+			bool isParsed() const {
+				return _parsed;
+			}
+
+			/// Get the kind of elementary stream @a pid carries, as found with
+			/// the stream type and descriptors of this PMT
+			StreamKind getStreamKind(int pid) const {
+				return static_cast<StreamKind>(_streamKind[pid & 0x1fff]);
+			}
+
 			bool isReadySend() const {
 				if (isCollected() && !_send) {
 					_send = true;
@@ -71,7 +92,12 @@ namespace mpegts {
 				return false;
 			}
 
-		public:
+		private:
+
+			/// Get the kind of elementary stream from the PMT @a streamType
+			/// and the descriptor tags of its ES info
+			static StreamKind classifyStream(int streamType, const unsigned char *esInfo,
+				std::size_t esInfoLength);
 
 			// ================================================================
 			//  -- Data members -----------------------------------------------
@@ -79,11 +105,15 @@ namespace mpegts {
 
 		private:
 
+			static constexpr std::size_t MAX_PIDS = 8192;
+
 			mpegts::TSData _progInfo;
 			uint16_t _programNumber;
 			int _pcrPID;
 			std::size_t _prgLength;
 			mutable bool _send;
+			bool _parsed;
+			uint8_t _streamKind[MAX_PIDS];
 	};
 
 } // namespace mpegts
@@ -19,6 +19,8 @@
 */
 #include <mpegts/PacketBuffer.h>
 
+#include <mpegts/TSHeaderParser.h>
+
 #include <cassert>
 #include <cstring>
 #include <climits>
@@ -26,16 +28,85 @@
 namespace mpegts {
 
 	static_assert(PacketBuffer::MTU_MAX_TS_PACKET_SIZE < PacketBuffer::MTU, "TS Packet size bigger then MTU");
+	static_assert(PacketBuffer::RTP_HEADER_LEN + (PacketBuffer::TS_PACKET_SIZE *
+		PacketBuffer::MAX_NUMBER_OF_TS_PACKETS) <= 0xffff, "TS Packets do not fit in an RTP/TCP frame");
 	static_assert(CHAR_BIT == 8, "Error CHAR_BIT != 8");
 
+	constexpr size_t PacketBuffer::NUMBER_OF_TS_PACKETS;
+	constexpr size_t PacketBuffer::JUMBO_NUMBER_OF_TS_PACKETS;
+	constexpr size_t PacketBuffer::MIN_NUMBER_OF_TS_PACKETS;
+	constexpr size_t PacketBuffer::MAX_NUMBER_OF_TS_PACKETS;
+
 	PacketBuffer::PacketBuffer() :
+			_storage(RTP_HEADER_LEN + MTU_MAX_TS_PACKET_SIZE, 0),
+			_buffer(_storage.data()),
+			_size(_storage.size()),
+			_capacity(0),
+			_numberOfTSPackets(NUMBER_OF_TS_PACKETS),
 			_writeIndex(0),
+			_accountedTSPackets(0),
 			_initialized(false),
-			_decryptPending(false) {}
+			_decryptPending(false),
+			_references(0) {}
 
 	PacketBuffer::~PacketBuffer() {}
 
-	void PacketBuffer::initialize(const uint32_t ssrc, const long timestamp) {
+	PacketBuffer::PacketBuffer(const PacketBuffer &other) :
+			_storage(other._buffer, other._buffer + other._size),
+			_buffer(_storage.data()),
+			_size(other._size),
+			_capacity(0),
+			_numberOfTSPackets(other._numberOfTSPackets),
+			_writeIndex(other._writeIndex),
+			_accountedTSPackets(other._accountedTSPackets),
+			_initialized(other._initialized),
+			_decryptPending(other._decryptPending),
+			_references(other._references) {}
+
+	PacketBuffer &PacketBuffer::operator=(const PacketBuffer &other) {
+		if (this != &other) {
+			if (_capacity == 0 || other._numberOfTSPackets > _capacity) {
+				_storage.assign(other._buffer, other._buffer + other._size);
+				_buffer = _storage.data();
+				_capacity = 0;
+			} else {
+				std::memcpy(_buffer, other._buffer, other._size);
+			}
+			_size = other._size;
+			_numberOfTSPackets = other._numberOfTSPackets;
+			_writeIndex = other._writeIndex;
+			_accountedTSPackets = other._accountedTSPackets;
+			_initialized = other._initialized;
+			_decryptPending = other._decryptPending;
+			_references = other._references;
+		}
+		return *this;
+	}
+
+	void PacketBuffer::useStorage(unsigned char *storage, const std::size_t numberOfTSPackets) {
+		std::vector<unsigned char>().swap(_storage);
+		_buffer = storage;
+		_capacity = getValidNumberOfTSPackets(numberOfTSPackets);
+		_numberOfTSPackets = _capacity;
+		_size = RTP_HEADER_LEN + (_capacity * TS_PACKET_SIZE);
+		_writeIndex = RTP_HEADER_LEN;
+		_accountedTSPackets = 0;
+	}
+
+	void PacketBuffer::initialize(const uint32_t ssrc, const long timestamp,
+			std::size_t numberOfTSPackets) {
+		numberOfTSPackets = getValidNumberOfTSPackets(numberOfTSPackets);
+		if (_capacity != 0) {
+			if (numberOfTSPackets > _capacity) {
+				numberOfTSPackets = _capacity;
+			}
+		} else {
+			_storage.resize(RTP_HEADER_LEN + (numberOfTSPackets * TS_PACKET_SIZE));
+			_buffer = _storage.data();
+		}
+		_numberOfTSPackets = numberOfTSPackets;
+		_size = RTP_HEADER_LEN + (numberOfTSPackets * TS_PACKET_SIZE);
+
 		// initialize RTP header
 		_buffer[0]  = 0x80;                         // version: 2, padding: 0, extension: 0, CSRC: 0
 		_buffer[1]  = 33;                           // marker: 0, payload type: 33 (MP2T)
@@ -53,19 +124,30 @@ namespace mpegts {
 		_initialized = true;
 	}
 
+	void PacketBuffer::fillUpWithNullPackets() {
+		while (_writeIndex + TS_PACKET_SIZE <= _size) {
+			unsigned char *ts = &_buffer[_writeIndex];
+			ts[0] = 0x47;
+			ts[1] = (TSPacketHeader::NULL_PID >> 8) & 0x1f;
+			ts[2] = TSPacketHeader::NULL_PID & 0xff;
+			ts[3] = 0x10;
+			std::memset(ts + 4, 0xff, TS_PACKET_SIZE - 4);
+			_writeIndex += TS_PACKET_SIZE;
+		}
+	}
+
 	bool PacketBuffer::trySyncing() {
 		if (!isSynced()) {
-			for (size_t i = RTP_HEADER_LEN; i < MTU_MAX_TS_PACKET_SIZE + RTP_HEADER_LEN - (TS_PACKET_SIZE * 2); ++i) {
-				const unsigned char *cData = _buffer + i;
-				if (cData[TS_PACKET_SIZE * 0] == 0x47 &&
-					cData[TS_PACKET_SIZE * 1] == 0x47 &&
-					cData[TS_PACKET_SIZE * 2] == 0x47) {
-					// found sync, now move it to begin of buffer
-					const size_t cpySize = (MTU_MAX_TS_PACKET_SIZE + RTP_HEADER_LEN) - i;
-					_writeIndex = _writeIndex - (i - RTP_HEADER_LEN);
-					std::memmove(_buffer + RTP_HEADER_LEN, cData, cpySize);
-					return true;
-				}
+			const size_t size = _size - RTP_HEADER_LEN;
+			const size_t offset = TSHeaderParser::findSync(&_buffer[RTP_HEADER_LEN], size);
+			if (offset < size) {
+				// found sync, now move it to begin of buffer
+				const size_t i = offset + RTP_HEADER_LEN;
+				const size_t cpySize = _size - i;
+				_writeIndex = _writeIndex - (i - RTP_HEADER_LEN);
+				_accountedTSPackets = 0;
+				std::memmove(&_buffer[RTP_HEADER_LEN], &_buffer[i], cpySize);
+				return true;
 			}
 			// did not find a sync, so flush buffer
 			reset();
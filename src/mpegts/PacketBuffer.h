@@ -22,9 +22,14 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 
 namespace mpegts {
 
+	/// The class @c PacketBuffer is one RTP header followed by a number of TS
+	/// packets. The amount of TS packets is set with @c initialize, so each
+	/// output type can use its own size (MTU, jumbo frames or bulk TCP). The
+	/// data is in its own storage, or in storage given with @c useStorage
 	class PacketBuffer {
 		public:
 			// =======================================================================
@@ -33,17 +38,34 @@ namespace mpegts {
 			PacketBuffer();
 			virtual ~PacketBuffer();
 
+			/// A copy always has its own storage
+			PacketBuffer(const PacketBuffer &other);
+
+			PacketBuffer &operator=(const PacketBuffer &other);
+
 			// =======================================================================
 			// Other functions
 			// =======================================================================
 
 			/// Initialize this TS packet
-			void initialize(uint32_t ssrc, long timestamp);
+			/// @param numberOfTSPackets specifies the amount of TS packets this
+			/// buffer can hold, between MIN_ and MAX_NUMBER_OF_TS_PACKETS
+			void initialize(uint32_t ssrc, long timestamp,
+				std::size_t numberOfTSPackets = NUMBER_OF_TS_PACKETS);
+
+			/// Use @a storage instead of the own storage, it should stay valid
+			/// as long as this buffer is used. The amount of TS packets is then
+			/// limited to what fits in it
+			/// @param storage specifies the storage for the RTP header and
+			/// @a numberOfTSPackets TS packets
+			void useStorage(unsigned char *storage, std::size_t numberOfTSPackets);
 
 			/// Reset this TS packet
 			void reset() {
 				_decryptPending = false;
 				_writeIndex = RTP_HEADER_LEN;
+				_accountedTSPackets = 0;
+				_references = 0;
 			}
 
 			/// Check if these packets are in sync
@@ -56,20 +78,30 @@ namespace mpegts {
 			/// try to sync this buffer
 			bool trySyncing();
 
+			/// Fill the rest of the buffer with null (stuffing) packets, so a
+			/// partly filled buffer can be send as a whole
+			void fillUpWithNullPackets();
+
+			/// Limit @a numberOfTSPackets between MIN_ and MAX_NUMBER_OF_TS_PACKETS
+			static constexpr std::size_t getValidNumberOfTSPackets(std::size_t numberOfTSPackets) {
+				return (numberOfTSPackets < MIN_NUMBER_OF_TS_PACKETS) ? MIN_NUMBER_OF_TS_PACKETS :
+					(numberOfTSPackets > MAX_NUMBER_OF_TS_PACKETS) ? MAX_NUMBER_OF_TS_PACKETS : numberOfTSPackets;
+			}
+
 			/// This function will return the number of TS Packets that are
 			/// in this TS Packet
-			static constexpr std::size_t getNumberOfTSPackets() {
-				return NUMBER_OF_TS_PACKETS;
+			std::size_t getNumberOfTSPackets() const {
+				return _numberOfTSPackets;
 			}
 
 			/// get the amount of data that can be written to this TS packet
-			static constexpr std::size_t getBufferSize() {
-				return MTU_MAX_TS_PACKET_SIZE;
+			std::size_t getBufferSize() const {
+				return _numberOfTSPackets * TS_PACKET_SIZE;
 			}
 
 			/// This will return the amount of bytes that (still) need to be written
 			std::size_t getAmountOfBytesToWrite() const {
-				return (MTU_MAX_TS_PACKET_SIZE + RTP_HEADER_LEN) - _writeIndex;
+				return _size - _writeIndex;
 			}
 
 			/// Add the amount of bytes written. So increment write index
@@ -78,9 +110,38 @@ namespace mpegts {
 				_writeIndex += index;
 			}
 
+			/// Drop all TS packets from @a packetNumber on, so they will be
+			/// written again
+			/// @param packetNumber a value from 0 up until NUMBER_OF_TS_PACKETS
+			void truncateToTSPackets(std::size_t packetNumber) {
+				_writeIndex = (packetNumber * TS_PACKET_SIZE) + RTP_HEADER_LEN;
+				if (_accountedTSPackets > packetNumber) {
+					_accountedTSPackets = packetNumber;
+				}
+			}
+
+			/// Get the amount of TS packets, from the begin, that are already
+			/// given to the PID statistics and filter. When packets are dropped
+			/// and the buffer is filled again, only the packets after these
+			/// should be given, else they are counted twice
+			std::size_t getAccountedTSPackets() const {
+				return _accountedTSPackets;
+			}
+
+			/// Set the amount of TS packets already given to the PID statistics
+			/// and filter (see @c getAccountedTSPackets)
+			void setAccountedTSPackets(std::size_t packets) {
+				_accountedTSPackets = packets;
+			}
+
 			/// Check if we have written all the buffer
 			bool full() const {
-				return (MTU_MAX_TS_PACKET_SIZE + RTP_HEADER_LEN) == _writeIndex;
+				return _size == _writeIndex;
+			}
+
+			/// Check if no TS packet is written in the buffer
+			bool empty() const {
+				return _writeIndex == RTP_HEADER_LEN;
 			}
 
 			/// Get the write buffer pointer for this TS packet
@@ -109,6 +170,24 @@ namespace mpegts {
 				return &_buffer[index];
 			}
 
+			/// Set the amount of clients that still have to send this buffer,
+			/// used when one buffer is send to more clients without copying it
+			void setReferences(std::size_t references) {
+				_references = references;
+			}
+
+			/// Get the amount of clients that still have to send this buffer
+			std::size_t getReferences() const {
+				return _references;
+			}
+
+			/// One client did send this buffer (or will not send it anymore)
+			void releaseReference() {
+				if (_references > 0) {
+					--_references;
+				}
+			}
+
 			/// Set the decrypt pending flag, so we should check scramble flag if this
 			/// buffer is ready for sending
 			void setDecryptPending() {
@@ -121,7 +200,7 @@ namespace mpegts {
 				// can only be ready when buffer is full, so start from there
 				bool ready = full();
 				if (_decryptPending && ready) {
-					for (std::size_t i = 0; i < NUMBER_OF_TS_PACKETS; ++i) {
+					for (std::size_t i = 0; i < _numberOfTSPackets; ++i) {
 						const unsigned char *ts = getTSPacketPtr(i);
 						ready &= ((ts[3] & 0x80) != 0x80);
 					}
@@ -137,14 +216,27 @@ namespace mpegts {
 			static constexpr size_t MTU                    = 1500;
 			static constexpr size_t RTP_HEADER_LEN         =   12;
 			static constexpr size_t TS_PACKET_SIZE         =  188;
+			/// Default amount of TS packets, fits in an Ethernet MTU
 			static constexpr size_t NUMBER_OF_TS_PACKETS   =    7;
 			static constexpr size_t MTU_MAX_TS_PACKET_SIZE = TS_PACKET_SIZE * NUMBER_OF_TS_PACKETS;
+			/// Amount of TS packets that fits in a jumbo frame (MTU 9000)
+			static constexpr size_t JUMBO_NUMBER_OF_TS_PACKETS = 47;
+			/// Needed to check the sync of a buffer
+			static constexpr size_t MIN_NUMBER_OF_TS_PACKETS =    3;
+			/// The length of an interleaved RTP/TCP frame is 16 bits
+			static constexpr size_t MAX_NUMBER_OF_TS_PACKETS =  348;
 
 		protected:
-			unsigned char _buffer[MTU];
+			std::vector<unsigned char> _storage; /// own storage, empty when using external storage
+			unsigned char *_buffer;
+			std::size_t   _size;                 /// bytes in use, RTP header and TS packets
+			std::size_t   _capacity;             /// TS packets that fit in external storage, 0 = own storage
+			std::size_t   _numberOfTSPackets;
 			std::size_t   _writeIndex;
+			std::size_t   _accountedTSPackets;
 			bool          _initialized;
 			bool          _decryptPending;
+			std::size_t   _references;
 
 	};
 
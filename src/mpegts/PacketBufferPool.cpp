@@ -0,0 +1,187 @@
+/* PacketBufferPool.cpp
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <mpegts/PacketBufferPool.h>
+
+#include <Log.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace mpegts {
+
+	constexpr std::size_t PacketBufferPool::SLAB_BUFFERS;
+	constexpr std::size_t PacketBufferPool::RESERVE_BUFFERS;
+	constexpr std::size_t PacketBufferPool::CACHE_LINE_SIZE;
+	constexpr std::size_t PacketBufferPool::DEFAULT_MEMORY_LIMIT_MB;
+	constexpr std::size_t PacketBufferPool::MAX_MEMORY_LIMIT_MB;
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	PacketBufferPool::PacketBufferPool() :
+		_memoryLimitMB(DEFAULT_MEMORY_LIMIT_MB),
+		_bytes(0),
+		_buffers(0),
+		_inUse(0),
+		_inUseHighWater(0),
+		_bytesHighWater(0),
+		_allocationFailures(0),
+		_slabsFreed(0) {}
+
+	PacketBufferPool::~PacketBufferPool() {}
+
+	// =======================================================================
+	//  -- base::XMLSupport --------------------------------------------------
+	// =======================================================================
+
+	void PacketBufferPool::addToXML(std::string &xml) const {
+		base::MutexLock lock(_xmlMutex);
+		ADD_XML_NUMBER_INPUT(xml, "memorylimit", _memoryLimitMB, 0, MAX_MEMORY_LIMIT_MB);
+		ADD_XML_ELEMENT(xml, "memory", _bytes / 1024);
+		ADD_XML_ELEMENT(xml, "memoryhighwater", _bytesHighWater / 1024);
+		ADD_XML_ELEMENT(xml, "buffers", _buffers);
+		ADD_XML_ELEMENT(xml, "inuse", _inUse);
+		ADD_XML_ELEMENT(xml, "inusehighwater", _inUseHighWater);
+		ADD_XML_ELEMENT(xml, "allocationfailures", _allocationFailures);
+		ADD_XML_ELEMENT(xml, "slabs", _slab.size());
+		ADD_XML_ELEMENT(xml, "slabsfreed", _slabsFreed);
+	}
+
+	void PacketBufferPool::fromXML(const std::string &xml) {
+		base::MutexLock lock(_xmlMutex);
+		std::string element;
+		if (findXMLElement(xml, "memorylimit.value", element)) {
+			const std::size_t limit = std::stoi(element);
+			_memoryLimitMB = (limit <= MAX_MEMORY_LIMIT_MB) ? limit : DEFAULT_MEMORY_LIMIT_MB;
+		}
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void PacketBufferPool::allocate(std::size_t numberOfTSPackets, const std::size_t minCount,
+			const std::size_t wantedCount, BufferVector &buffers) {
+		base::MutexLock lock(_xmlMutex);
+		numberOfTSPackets = PacketBuffer::getValidNumberOfTSPackets(numberOfTSPackets);
+		BufferVector &free = _free[numberOfTSPackets];
+		const std::size_t slabBytes = getSlabBytes(numberOfTSPackets);
+		const std::size_t limit = _memoryLimitMB * 1024 * 1024;
+		while (buffers.size() < wantedCount) {
+			if (free.empty()) {
+				if (buffers.size() >= minCount && limit != 0 && _bytes + slabBytes > limit) {
+					_allocationFailures += wantedCount - buffers.size();
+					SI_LOG_DEBUG("PacketBufferPool: Memory limit reached, giving %zu of %zu buffers",
+						buffers.size(), wantedCount);
+					break;
+				}
+				addSlab(numberOfTSPackets);
+			}
+			buffers.push_back(free.back());
+			free.pop_back();
+			--findSlab(buffers.back()).free;
+		}
+		_inUse += buffers.size();
+		if (_inUse > _inUseHighWater) {
+			_inUseHighWater = _inUse;
+		}
+	}
+
+	void PacketBufferPool::release(BufferVector &buffers) {
+		base::MutexLock lock(_xmlMutex);
+		std::size_t idleSize = 0;
+		for (PacketBuffer *buffer : buffers) {
+			Slab &slab = findSlab(buffer);
+			_free[slab.numberOfTSPackets].push_back(buffer);
+			if (++slab.free == SLAB_BUFFERS) {
+				idleSize = slab.numberOfTSPackets;
+			}
+		}
+		_inUse -= buffers.size();
+		buffers.clear();
+		if (idleSize != 0) {
+			trimSlabs(idleSize);
+		}
+	}
+
+	std::size_t PacketBufferPool::getSlabBytes(const std::size_t numberOfTSPackets) {
+		const std::size_t bufferBytes = PacketBuffer::RTP_HEADER_LEN +
+			(numberOfTSPackets * PacketBuffer::TS_PACKET_SIZE);
+		return SLAB_BUFFERS * (((bufferBytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE);
+	}
+
+	PacketBufferPool::Slab &PacketBufferPool::findSlab(const PacketBuffer *buffer) {
+		SlabMap::iterator it = _slab.upper_bound(buffer);
+		--it;
+		return *it->second;
+	}
+
+	void PacketBufferPool::addSlab(const std::size_t numberOfTSPackets) {
+		const std::size_t slabBytes = getSlabBytes(numberOfTSPackets);
+		const std::size_t stride = slabBytes / SLAB_BUFFERS;
+		std::unique_ptr<Slab> slab(new Slab);
+		// One extra cache line, so the first buffer can start on one
+		slab->storage.reset(new unsigned char[slabBytes + CACHE_LINE_SIZE]);
+		slab->buffer.reset(new PacketBuffer[SLAB_BUFFERS]);
+		slab->numberOfTSPackets = numberOfTSPackets;
+		slab->free = SLAB_BUFFERS;
+		const uintptr_t address = reinterpret_cast<uintptr_t>(slab->storage.get());
+		unsigned char *storage = slab->storage.get() +
+			(CACHE_LINE_SIZE - (address % CACHE_LINE_SIZE)) % CACHE_LINE_SIZE;
+		BufferVector &free = _free[numberOfTSPackets];
+		for (std::size_t i = 0; i < SLAB_BUFFERS; ++i) {
+			slab->buffer[i].useStorage(storage + (i * stride), numberOfTSPackets);
+			slab->buffer[i].initialize(0, 0, numberOfTSPackets);
+			free.push_back(&slab->buffer[i]);
+		}
+		const PacketBuffer *key = slab->buffer.get();
+		_slab[key] = std::move(slab);
+		_buffers += SLAB_BUFFERS;
+		_bytes += slabBytes;
+		if (_bytes > _bytesHighWater) {
+			_bytesHighWater = _bytes;
+		}
+	}
+
+	void PacketBufferPool::trimSlabs(const std::size_t numberOfTSPackets) {
+		BufferVector &free = _free[numberOfTSPackets];
+		const std::size_t slabBytes = getSlabBytes(numberOfTSPackets);
+		SlabMap::iterator it = _slab.begin();
+		while (it != _slab.end() && free.size() >= RESERVE_BUFFERS + SLAB_BUFFERS) {
+			const Slab &slab = *it->second;
+			if (slab.numberOfTSPackets != numberOfTSPackets || slab.free != SLAB_BUFFERS) {
+				++it;
+				continue;
+			}
+			const PacketBuffer *begin = slab.buffer.get();
+			const PacketBuffer *end = begin + SLAB_BUFFERS;
+			free.erase(std::remove_if(free.begin(), free.end(),
+				[begin, end](const PacketBuffer *buffer) {
+					return buffer >= begin && buffer < end;
+				}), free.end());
+			it = _slab.erase(it);
+			_buffers -= SLAB_BUFFERS;
+			_bytes -= slabBytes;
+			++_slabsFreed;
+		}
+	}
+
+} // namespace mpegts
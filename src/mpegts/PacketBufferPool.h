@@ -0,0 +1,144 @@
+/* PacketBufferPool.h
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef MPEGTS_PACKET_BUFFER_POOL_H_INCLUDE
+#define MPEGTS_PACKET_BUFFER_POOL_H_INCLUDE MPEGTS_PACKET_BUFFER_POOL_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/XMLSupport.h>
+#include <mpegts/PacketBuffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+FW_DECL_SP_NS1(mpegts, PacketBufferPool);
+
+namespace mpegts {
+
+	/// The class @c PacketBufferPool is the process wide pool of packet buffers
+	/// used by the streaming rings. The buffers are allocated in slabs, the data
+	/// of all buffers of a slab is one block, each buffer starting on a cache
+	/// line. A released buffer goes back to the free list of its size, so
+	/// stopping and starting a stream does not allocate again. Only slabs that
+	/// are completely idle, above a reserve of free buffers, are freed. An idle
+	/// stream holds no buffers, a busy stream may borrow a deeper ring as long
+	/// as the pool stays within its memory limit.
+	///
+	/// The buffers are only taken and given back when a stream starts, pauses
+	/// or stops, not for each packet, so one lock is enough and there are no
+	/// per thread caches.
+	class PacketBufferPool :
+		public base::XMLSupport {
+		public:
+
+			using BufferVector = std::vector<PacketBuffer *>;
+
+			// =======================================================================
+			//  -- Constructors and destructor ---------------------------------------
+			// =======================================================================
+
+			PacketBufferPool();
+
+			virtual ~PacketBufferPool();
+
+			// =======================================================================
+			// -- base::XMLSupport ---------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			virtual void addToXML(std::string &xml) const override;
+
+			virtual void fromXML(const std::string &xml) override;
+
+			// =======================================================================
+			//  -- Other member functions --------------------------------------------
+			// =======================================================================
+
+		public:
+
+			/// Take buffers of @a numberOfTSPackets from the pool. The first
+			/// @a minCount buffers are always given, the buffers above it only
+			/// if the pool stays within its memory limit
+			/// @param buffers will get the buffers, it should be empty
+			/// @param wantedCount specifies the amount of buffers wanted
+			void allocate(std::size_t numberOfTSPackets, std::size_t minCount,
+				std::size_t wantedCount, BufferVector &buffers);
+
+			/// Give @a buffers back to the pool, @a buffers will be empty after it
+			void release(BufferVector &buffers);
+
+		private:
+
+			/// Add a slab of buffers to the free list of @a numberOfTSPackets
+			void addSlab(std::size_t numberOfTSPackets);
+
+			/// Free the slabs of @a numberOfTSPackets that are completely idle,
+			/// as long as the free list stays above the reserve
+			void trimSlabs(std::size_t numberOfTSPackets);
+
+			/// Get the Bytes of one slab with buffers of @a numberOfTSPackets
+			static std::size_t getSlabBytes(std::size_t numberOfTSPackets);
+
+			// =======================================================================
+			// -- Data members -------------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			static constexpr std::size_t SLAB_BUFFERS = 16;
+			/// Free buffers of each size kept, even when their slab is idle
+			static constexpr std::size_t RESERVE_BUFFERS = 128;
+			static constexpr std::size_t CACHE_LINE_SIZE = 64;
+			static constexpr std::size_t DEFAULT_MEMORY_LIMIT_MB = 64;
+			static constexpr std::size_t MAX_MEMORY_LIMIT_MB = 4096;
+
+		private:
+
+			struct Slab {
+				std::unique_ptr<unsigned char[]> storage;
+				std::unique_ptr<PacketBuffer[]> buffer;
+				std::size_t numberOfTSPackets;
+				std::size_t free;
+			};
+			/// The slabs by the address of their first buffer
+			using SlabMap = std::map<const PacketBuffer *, std::unique_ptr<Slab>>;
+			using FreeMap = std::map<std::size_t, BufferVector>;
+
+			/// Get the slab @a buffer belongs to
+			Slab &findSlab(const PacketBuffer *buffer);
+
+			std::size_t _memoryLimitMB;     /// 0 = no limit
+			SlabMap _slab;
+			FreeMap _free;                  /// free buffers for each amount of TS packets
+			std::size_t _bytes;             /// memory of all slabs
+			std::size_t _buffers;           /// buffers in all slabs
+			std::size_t _inUse;
+			std::size_t _inUseHighWater;
+			std::size_t _bytesHighWater;
+			uint64_t _allocationFailures;   /// buffers not given because of the limit
+			uint64_t _slabsFreed;
+	};
+
+} // namespace mpegts
+
+#endif // MPEGTS_PACKET_BUFFER_POOL_H_INCLUDE
@@ -0,0 +1,154 @@
+/* PidFilter.cpp
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <mpegts/PidFilter.h>
+
+#include <StringConverter.h>
+
+#include <cstdlib>
+
+namespace mpegts {
+
+	constexpr std::size_t PidFilter::MAX_PIDS;
+	constexpr std::size_t PidFilter::WORDS;
+
+	// ========================================================================
+	//  -- Constructors and destructor ----------------------------------------
+	// ========================================================================
+
+	PidFilter::PidFilter() {
+		clear();
+	}
+
+	PidFilter::~PidFilter() {}
+
+	// ========================================================================
+	//  -- Other member functions ---------------------------------------------
+	// ========================================================================
+
+	void PidFilter::clear() {
+		for (std::size_t i = 0; i < WORDS; ++i) {
+			_bits[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void PidFilter::setAll() {
+		for (std::size_t i = 0; i < WORDS; ++i) {
+			_bits[i].store(~static_cast<uint64_t>(0), std::memory_order_relaxed);
+		}
+	}
+
+	void PidFilter::set(const int pid, const bool use) {
+		if (pid < 0 || pid >= static_cast<int>(MAX_PIDS)) {
+			return;
+		}
+		const uint64_t mask = static_cast<uint64_t>(1) << (pid & 63);
+		if (use) {
+			_bits[pid >> 6].fetch_or(mask, std::memory_order_relaxed);
+		} else {
+			_bits[pid >> 6].fetch_and(~mask, std::memory_order_relaxed);
+		}
+	}
+
+	bool PidFilter::isAllSet() const {
+		for (std::size_t i = 0; i < WORDS; ++i) {
+			if (_bits[i].load(std::memory_order_relaxed) != ~static_cast<uint64_t>(0)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool PidFilter::isEqual(const PidFilter &filter) const {
+		for (std::size_t i = 0; i < WORDS; ++i) {
+			if (_bits[i].load(std::memory_order_relaxed) != filter._bits[i].load(std::memory_order_relaxed)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void PidFilter::merge(const PidFilter &filter) {
+		for (std::size_t i = 0; i < WORDS; ++i) {
+			_bits[i].fetch_or(filter._bits[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	void PidFilter::parseStreamString(const std::string &msg, const std::string &method) {
+		// A new transponder also starts with a new set of PIDs
+		if ((method == "SETUP" || method == "PLAY") &&
+		    StringConverter::getDoubleParameter(msg, method, "freq=") != -1.0) {
+			clear();
+		}
+		// Same PIDs as the frontend always adds (PAT and user defined PIDs)
+		const std::string addPids = ",0,1,16,17,18";
+		std::string strVal;
+		if (StringConverter::getStringParameter(msg, method, "pids=", strVal)) {
+			parsePIDString(strVal, true, true);
+			parsePIDString(addPids, false, true);
+		}
+		if (StringConverter::getStringParameter(msg, method, "addpids=", strVal)) {
+			parsePIDString(strVal, false, true);
+			parsePIDString(addPids, false, true);
+		}
+		if (StringConverter::getStringParameter(msg, method, "delpids=", strVal)) {
+			parsePIDString(strVal, false, false);
+		}
+	}
+
+	std::string PidFilter::toString() const {
+		if (isAllSet()) {
+			return "all";
+		}
+		std::string pids;
+		for (std::size_t pid = 0; pid < MAX_PIDS; ++pid) {
+			if (isSet(pid)) {
+				if (!pids.empty()) {
+					pids += ",";
+				}
+				pids += std::to_string(pid);
+			}
+		}
+		return pids;
+	}
+
+	void PidFilter::parsePIDString(const std::string &pids,
+			const bool clearPidsFirst, const bool add) {
+		if (pids == "all" || pids == "none") {
+			clear();
+			if (pids == "all" && add) {
+				setAll();
+			}
+			return;
+		}
+		if (clearPidsFirst) {
+			clear();
+		}
+		std::string::size_type begin = 0;
+		while (begin < pids.size()) {
+			std::string::size_type end = pids.find_first_of(",", begin);
+			if (end == std::string::npos) {
+				end = pids.size();
+			}
+			set(std::atoi(pids.substr(begin, end - begin).c_str()), add);
+			begin = end + 1;
+		}
+	}
+
+} // namespace mpegts
@@ -0,0 +1,101 @@
+/* PidFilter.h
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef MPEGTS_PIDFILTER_H_INCLUDE
+#define MPEGTS_PIDFILTER_H_INCLUDE MPEGTS_PIDFILTER_H_INCLUDE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mpegts {
+
+	/// The class @c PidFilter is a software PID filter with one bit for each
+	/// of the 8192 PIDs. It can be read from the streaming thread while it is
+	/// changed by another thread
+	class PidFilter {
+		public:
+
+			// ================================================================
+			//  -- Constructors and destructor --------------------------------
+			// ================================================================
+			PidFilter();
+
+			virtual ~PidFilter();
+
+			// ================================================================
+			//  -- Other member functions -------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Remove all PIDs from this filter
+			void clear();
+
+			/// Add all PIDs to this filter
+			void setAll();
+
+			/// Add or remove one PID of this filter
+			void set(int pid, bool use);
+
+			/// Check if this PID should pass this filter
+			bool isSet(int pid) const {
+				return ((_bits[pid >> 6].load(std::memory_order_relaxed) >> (pid & 63)) & 1) != 0;
+			}
+
+			/// Check if all PIDs pass this filter
+			bool isAllSet() const;
+
+			/// Check if @a filter has exactly the same PIDs as this filter
+			bool isEqual(const PidFilter &filter) const;
+
+			/// Add all PIDs of @a filter to this filter
+			void merge(const PidFilter &filter);
+
+			/// Parse the pids, addpids and delpids of the transport parameters
+			/// in @a msg, the same way as the frontend does
+			void parseStreamString(const std::string &msg, const std::string &method);
+
+			/// Get the PIDs of this filter as 'all' or a comma separated list
+			std::string toString() const;
+
+		private:
+
+			/// Parse the comma separated PID list, or 'all' and 'none'
+			void parsePIDString(const std::string &pids, bool clearPidsFirst, bool add);
+
+			// ================================================================
+			//  -- Data members -----------------------------------------------
+			// ================================================================
+
+		public:
+
+			static constexpr std::size_t MAX_PIDS = 8192;
+
+		private:
+
+			static constexpr std::size_t WORDS = MAX_PIDS / 64;
+
+			std::atomic<uint64_t> _bits[WORDS];
+	};
+
+} // namespace mpegts
+
+#endif // MPEGTS_PIDFILTER_H_INCLUDE
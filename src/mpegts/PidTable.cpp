@@ -28,6 +28,10 @@ namespace mpegts {
 	PidTable::PidTable() {
 		for (size_t i = 0; i < MAX_PIDS; ++i) {
 			_data[i].fd_dmx = -1;
+			_stats[i].count = 0;
+			_stats[i].cc_error = 0;
+			_stats[i].cc = 0x80;
+			_stats[i].reset = false;
 			resetPidData(i);
 		}
 		_changed = false;
@@ -51,13 +55,23 @@ namespace mpegts {
 	void PidTable::resetPidData(int pid) {
 		_data[pid].used        = false;
 		_data[pid].shouldClose = false;
-		_data[pid].cc          = 0x80;
-		_data[pid].cc_error    = 0;
-		_data[pid].count       = 0;
+		_stats[pid].reset.store(true, std::memory_order_release);
+	}
+
+	void PidTable::resetStatsIfRequested(int pid) {
+		PidStats &stats = _stats[pid];
+		if (stats.reset.load(std::memory_order_acquire)) {
+			stats.reset.store(false, std::memory_order_relaxed);
+			stats.count.store(0, std::memory_order_relaxed);
+			stats.cc_error.store(0, std::memory_order_relaxed);
+			stats.cc.store(0x80, std::memory_order_relaxed);
+		}
 	}
 
 	uint32_t PidTable::getPacketCounter(int pid) const {
-		return _data[pid].count;
+		const PidStats &stats = _stats[pid];
+		return stats.reset.load(std::memory_order_acquire) ?
+			0 : stats.count.load(std::memory_order_relaxed);
 	}
 
 	void PidTable::setDMXFileDescriptor(int pid, int fd) {
@@ -75,6 +89,29 @@ namespace mpegts {
 		_data[pid].used = used;
 	}
 
+	void PidTable::resetDMXFileDescriptor(int pid) {
+		_data[pid].fd_dmx = -1;
+		const bool used = _data[pid].used;
+		resetPidData(pid);
+		_data[pid].used = used;
+	}
+
+	void PidTable::getPIDChanges(std::vector<int> &toClose, std::vector<int> &toOpen) {
+		for (size_t i = 0; i < MAX_PIDS; ++i) {
+			PidData &data = _data[i];
+			if (data.shouldClose) {
+				if (data.used && data.fd_dmx != -1) {
+					// requested again, so just keep it open
+					data.shouldClose = false;
+				} else {
+					toClose.push_back(i);
+				}
+			} else if (data.used && data.fd_dmx == -1) {
+				toOpen.push_back(i);
+			}
+		}
+	}
+
 	void PidTable::resetPIDTableChanged() {
 		_changed = false;
 	}
@@ -103,22 +140,23 @@ namespace mpegts {
 	}
 
 	void PidTable::addPIDData(int pid, uint8_t cc) {
-		PidData &data = _data[pid];
-		++data.count;
-		if (data.cc == 0x80) {
-			data.cc = cc;
-		} else {
-			++data.cc;
-			data.cc %= 0x10;
-			if (data.cc != cc) {
-				int diff = cc - data.cc;
+		resetStatsIfRequested(pid);
+		// Only this thread writes the statistics, so no read-modify-write needed
+		PidStats &stats = _stats[pid];
+		stats.count.store(stats.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		const uint8_t lastCC = stats.cc.load(std::memory_order_relaxed);
+		if (lastCC != 0x80) {
+			const uint8_t expectedCC = (lastCC + 1) % 0x10;
+			if (expectedCC != cc) {
+				int diff = cc - expectedCC;
 				if (diff < 0) {
 					diff += 0x10;
 				}
-				data.cc = cc;
-				data.cc_error += diff;
+				stats.cc_error.store(stats.cc_error.load(std::memory_order_relaxed) + diff,
+					std::memory_order_relaxed);
 			}
 		}
+		stats.cc.store(cc, std::memory_order_relaxed);
 	}
 
 	void PidTable::setPID(int pid, bool use) {
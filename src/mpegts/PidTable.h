@@ -20,12 +20,17 @@
 #ifndef MPEGTS_PIDTABLE_H_INCLUDE
 #define MPEGTS_PIDTABLE_H_INCLUDE MPEGTS_PIDTABLE_H_INCLUDE
 
+#include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace mpegts {
 
-	/// The class @c PidTable carries all the PID and DMX information
+	/// The class @c PidTable carries all the PID and DMX information.
+	/// The PID statistics are only written by the thread that reads the
+	/// input, without a lock, and can be read by any thread. All other
+	/// functions should be protected by the owner of this table
 	class PidTable {
 		public:
 
@@ -60,13 +65,26 @@ namespace mpegts {
 			/// Close DMX file descriptor and reset data, but keep used flag
 			void closeDMXFileDescriptor(int pid);
 
-			/// Get the amount of packet that were received of this pid
+			/// Reset DMX file descriptor and data, but keep used flag. The file
+			/// descriptor is not closed, because it is shared with other PIDs
+			void resetDMXFileDescriptor(int pid);
+
+			/// Collect the difference between the requested PIDs and the PIDs that
+			/// have an DMX file descriptor. PIDs that were removed and requested
+			/// again will stay open and are not part of the difference
+			/// @param toClose will get the PIDs that should be closed
+			/// @param toOpen will get the PIDs that should be opened
+			void getPIDChanges(std::vector<int> &toClose, std::vector<int> &toOpen);
+
+			/// Get the amount of packet that were received of this pid,
+			/// can be called from any thread without a lock
 			uint32_t getPacketCounter(int pid) const;
 
 			/// Get the CSV of all the requested PID
 			std::string getPidCSV() const;
 
-			/// Set the continuity counter for pid
+			/// Set the continuity counter for pid. Only the thread reading the
+			/// input should call this, it does not need a lock
 			void addPIDData(int pid, uint8_t cc);
 
 			/// Set pid used or not
@@ -86,6 +104,9 @@ namespace mpegts {
 			/// Reset the pid data like counters etc. (Not DMX File Descriptor)
 			void resetPidData(int pid);
 
+			/// Reset the statistics of pid, when requested by another thread
+			void resetStatsIfRequested(int pid);
+
 			// ================================================================
 			//  -- Data members -----------------------------------------------
 			// ================================================================
@@ -103,13 +124,21 @@ namespace mpegts {
 				int fd_dmx;        /// used DMX file descriptor for PID
 				bool used;         /// used pid (0 = not used, 1 = in use)
 				bool shouldClose;  /// indicate that this PID should close
-				uint8_t cc;        /// continuity counter (0 - 15) of this PID
-				uint32_t cc_error; /// cc error count
-				uint32_t count;    /// the number of times this pid occurred
 			};
 
-			bool _changed;           /// if something changed to 'pid' array
-			PidData _data[MAX_PIDS]; /// used pids
+			// PID statistics, only written by the thread reading the input.
+			// Other threads do not reset them, but request a reset that is done
+			// with the next packet of this PID
+			struct PidStats {
+				std::atomic<uint32_t> count;    /// the number of times this pid occurred
+				std::atomic<uint32_t> cc_error; /// cc error count
+				std::atomic<uint8_t> cc;        /// continuity counter (0 - 15) of this PID
+				std::atomic<bool> reset;        /// reset requested by another thread
+			};
+
+			bool _changed;             /// if something changed to 'pid' array
+			PidData _data[MAX_PIDS];   /// used pids
+			PidStats _stats[MAX_PIDS]; /// statistics of each pid
 
 	};
 
@@ -0,0 +1,248 @@
+/* TSHeaderParser.cpp
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <mpegts/TSHeaderParser.h>
+
+#include <mpegts/PacketBuffer.h>
+
+#include <cstring>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+	#define TS_HEADER_PARSER_X86
+	#include <immintrin.h>
+#endif
+
+namespace mpegts {
+
+	static_assert(sizeof(TSPacketHeader) == 4 && std::is_standard_layout<TSPacketHeader>::value,
+		"TSPacketHeader should be one 32 bit word, the SIMD versions store it like that");
+
+	constexpr uint8_t TSPacketHeader::SYNC;
+	constexpr uint8_t TSPacketHeader::TEI;
+	constexpr uint8_t TSPacketHeader::PUSI;
+	constexpr uint8_t TSPacketHeader::ADAPTATION;
+	constexpr uint8_t TSPacketHeader::PAYLOAD;
+	constexpr uint8_t TSPacketHeader::SCRAMBLED;
+	constexpr uint16_t TSPacketHeader::NULL_PID;
+
+	namespace {
+
+		constexpr std::size_t TS_SIZE = PacketBuffer::TS_PACKET_SIZE;
+		constexpr unsigned char SYNC_BYTE = 0x47;
+
+		using ParseFunction = std::size_t (*)(const unsigned char *, std::size_t, TSPacketHeader *);
+		using FindSyncFunction = std::size_t (*)(const unsigned char *, std::size_t);
+
+		struct Implementation {
+			const char *name;
+			ParseFunction parse;
+			FindSyncFunction findSync;
+		};
+
+		// ===================================================================
+		//  -- Scalar version -------------------------------------------------
+		// ===================================================================
+
+		std::size_t parseScalar(const unsigned char *ts, const std::size_t count,
+				TSPacketHeader *header) {
+			std::size_t synced = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				const unsigned char *ptr = ts + (i * TS_SIZE);
+				const bool sync = ptr[0] == SYNC_BYTE;
+				header[i].pid   = ((ptr[1] & 0x1f) << 8) | ptr[2];
+				header[i].cc    = ptr[3] & 0x0f;
+				header[i].flags = (sync ? TSPacketHeader::SYNC : 0) |
+					((ptr[1] >> 6) & TSPacketHeader::TEI) |
+					((ptr[1] >> 4) & TSPacketHeader::PUSI) |
+					((ptr[3] >> 2) & TSPacketHeader::ADAPTATION) |
+					(ptr[3] & (TSPacketHeader::PAYLOAD | 0xc0));
+				synced += sync ? 1 : 0;
+			}
+			return synced;
+		}
+
+		std::size_t findSyncScalar(const unsigned char *data, const std::size_t size,
+				std::size_t offset) {
+			for (std::size_t i = offset; i + (TS_SIZE * 2) < size; ++i) {
+				if (data[i] == SYNC_BYTE &&
+					data[i + (TS_SIZE * 1)] == SYNC_BYTE &&
+					data[i + (TS_SIZE * 2)] == SYNC_BYTE) {
+					return i;
+				}
+			}
+			return size;
+		}
+
+		std::size_t findSyncScalar(const unsigned char *data, const std::size_t size) {
+			return findSyncScalar(data, size, 0);
+		}
+
+#ifdef TS_HEADER_PARSER_X86
+
+		// ===================================================================
+		//  -- SSE2 and AVX2 versions -----------------------------------------
+		// ===================================================================
+		//
+		// Each lane has the 4 header Bytes of one TS packet as a little endian
+		// word, and is rearranged into the TSPacketHeader layout:
+		//   bits  0 - 12  PID (Byte 1 bits 0-4 are already at bits 8-12)
+		//   bits 16 - 19  CC
+		//   bits 24 - 31  flags
+
+		inline int load32(const unsigned char *ptr) {
+			int word;
+			std::memcpy(&word, ptr, sizeof(word));
+			return word;
+		}
+
+		__attribute__((target("sse2")))
+		inline __m128i toHeaderSSE2(const __m128i w, const __m128i sync) {
+			__m128i v = _mm_and_si128(w, _mm_set1_epi32(0x00001f00));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(w, 16), _mm_set1_epi32(0x000000ff)));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(w,  8), _mm_set1_epi32(0x000f0000)));
+			v = _mm_or_si128(v, _mm_and_si128(sync, _mm_set1_epi32(0x01000000)));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(w, 10), _mm_set1_epi32(0x02000000)));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_slli_epi32(w, 12), _mm_set1_epi32(0x04000000)));
+			v = _mm_or_si128(v, _mm_and_si128(_mm_srli_epi32(w,  2), _mm_set1_epi32(0x08000000)));
+			v = _mm_or_si128(v, _mm_and_si128(w, _mm_set1_epi32(static_cast<int>(0xd0000000))));
+			return v;
+		}
+
+		__attribute__((target("sse2")))
+		std::size_t parseSSE2(const unsigned char *ts, const std::size_t count,
+				TSPacketHeader *header) {
+			const __m128i syncByte = _mm_set1_epi32(SYNC_BYTE);
+			const __m128i byteMask = _mm_set1_epi32(0xff);
+			std::size_t synced = 0;
+			std::size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				const unsigned char *ptr = ts + (i * TS_SIZE);
+				const __m128i w = _mm_set_epi32(load32(ptr + (TS_SIZE * 3)), load32(ptr + (TS_SIZE * 2)),
+					load32(ptr + (TS_SIZE * 1)), load32(ptr));
+				const __m128i sync = _mm_cmpeq_epi32(_mm_and_si128(w, byteMask), syncByte);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(&header[i]), toHeaderSSE2(w, sync));
+				synced += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(sync)));
+			}
+			return synced + parseScalar(ts + (i * TS_SIZE), count - i, &header[i]);
+		}
+
+		__attribute__((target("sse2")))
+		std::size_t findSyncSSE2(const unsigned char *data, const std::size_t size) {
+			const __m128i syncByte = _mm_set1_epi8(SYNC_BYTE);
+			std::size_t i = 0;
+			for (; i + 16 + (TS_SIZE * 2) <= size; i += 16) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + (TS_SIZE * 1)));
+				const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + (TS_SIZE * 2)));
+				const __m128i m = _mm_and_si128(_mm_cmpeq_epi8(a, syncByte),
+					_mm_and_si128(_mm_cmpeq_epi8(b, syncByte), _mm_cmpeq_epi8(c, syncByte)));
+				const int mask = _mm_movemask_epi8(m);
+				if (mask != 0) {
+					return i + __builtin_ctz(mask);
+				}
+			}
+			return findSyncScalar(data, size, i);
+		}
+
+		__attribute__((target("avx2")))
+		std::size_t parseAVX2(const unsigned char *ts, const std::size_t count,
+				TSPacketHeader *header) {
+			const __m256i syncByte = _mm256_set1_epi32(SYNC_BYTE);
+			const __m256i byteMask = _mm256_set1_epi32(0xff);
+			const __m256i offset = _mm256_setr_epi32(TS_SIZE * 0, TS_SIZE * 1, TS_SIZE * 2, TS_SIZE * 3,
+				TS_SIZE * 4, TS_SIZE * 5, TS_SIZE * 6, TS_SIZE * 7);
+			std::size_t synced = 0;
+			std::size_t i = 0;
+			for (; i + 8 <= count; i += 8) {
+				const int *ptr = reinterpret_cast<const int *>(ts + (i * TS_SIZE));
+				const __m256i w = _mm256_i32gather_epi32(ptr, offset, 1);
+				const __m256i sync = _mm256_cmpeq_epi32(_mm256_and_si256(w, byteMask), syncByte);
+				__m256i v = _mm256_and_si256(w, _mm256_set1_epi32(0x00001f00));
+				v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(0x000000ff)));
+				v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi32(w,  8), _mm256_set1_epi32(0x000f0000)));
+				v = _mm256_or_si256(v, _mm256_and_si256(sync, _mm256_set1_epi32(0x01000000)));
+				v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi32(w, 10), _mm256_set1_epi32(0x02000000)));
+				v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi32(w, 12), _mm256_set1_epi32(0x04000000)));
+				v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi32(w,  2), _mm256_set1_epi32(0x08000000)));
+				v = _mm256_or_si256(v, _mm256_and_si256(w, _mm256_set1_epi32(static_cast<int>(0xd0000000))));
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(&header[i]), v);
+				synced += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(sync)));
+			}
+			return synced + parseSSE2(ts + (i * TS_SIZE), count - i, &header[i]);
+		}
+
+		__attribute__((target("avx2")))
+		std::size_t findSyncAVX2(const unsigned char *data, const std::size_t size) {
+			const __m256i syncByte = _mm256_set1_epi8(SYNC_BYTE);
+			std::size_t i = 0;
+			for (; i + 32 + (TS_SIZE * 2) <= size; i += 32) {
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + (TS_SIZE * 1)));
+				const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + (TS_SIZE * 2)));
+				const __m256i m = _mm256_and_si256(_mm256_cmpeq_epi8(a, syncByte),
+					_mm256_and_si256(_mm256_cmpeq_epi8(b, syncByte), _mm256_cmpeq_epi8(c, syncByte)));
+				const unsigned int mask = _mm256_movemask_epi8(m);
+				if (mask != 0) {
+					return i + __builtin_ctz(mask);
+				}
+			}
+			return findSyncScalar(data, size, i);
+		}
+
+#endif
+
+		Implementation selectImplementation() {
+#ifdef TS_HEADER_PARSER_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2")) {
+				return { "AVX2", parseAVX2, findSyncAVX2 };
+			}
+			if (__builtin_cpu_supports("sse2")) {
+				return { "SSE2", parseSSE2, findSyncSSE2 };
+			}
+#endif
+			return { "Scalar", parseScalar, findSyncScalar };
+		}
+
+		const Implementation &getImplementation() {
+			static const Implementation implementation = selectImplementation();
+			return implementation;
+		}
+
+	} // namespace
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	std::size_t TSHeaderParser::parse(const unsigned char *ts, const std::size_t count,
+			TSPacketHeader *header) {
+		return getImplementation().parse(ts, count, header);
+	}
+
+	std::size_t TSHeaderParser::findSync(const unsigned char *data, const std::size_t size) {
+		return getImplementation().findSync(data, size);
+	}
+
+	const char *TSHeaderParser::getImplementationName() {
+		return getImplementation().name;
+	}
+
+} // namespace mpegts
@@ -0,0 +1,107 @@
+/* TSHeaderParser.h
+
+   Copyright (C) 2014 - 2018 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef MPEGTS_TSHEADERPARSER_H_INCLUDE
+#define MPEGTS_TSHEADERPARSER_H_INCLUDE MPEGTS_TSHEADERPARSER_H_INCLUDE
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mpegts {
+
+	/// The struct @c TSPacketHeader is the decoded 4 byte header of one TS
+	/// packet, so the later stages do not have to decode it again
+	struct TSPacketHeader {
+		static constexpr uint8_t SYNC       = 0x01;  /// sync byte is 0x47
+		static constexpr uint8_t TEI        = 0x02;  /// transport error indicator
+		static constexpr uint8_t PUSI       = 0x04;  /// payload unit start indicator
+		static constexpr uint8_t ADAPTATION = 0x08;  /// adaptation field present
+		static constexpr uint8_t PAYLOAD    = 0x10;  /// payload present
+		static constexpr uint8_t SCRAMBLED  = 0x80;  /// scrambling control, odd/even key
+		static constexpr uint16_t NULL_PID  = 0x1fff;  /// stuffing packets
+
+		/// Check if the packet had a sync byte
+		bool isSynced() const {
+			return (flags & SYNC) != 0;
+		}
+
+		/// Check if the packet had a sync byte and no transport error
+		bool isValid() const {
+			return (flags & (SYNC | TEI)) == SYNC;
+		}
+
+		/// Check if the packet is a null (stuffing) packet
+		bool isNullPacket() const {
+			return pid == NULL_PID && isSynced();
+		}
+
+		/// Check if the packet has an adaptation field
+		bool hasAdaptationField() const {
+			return (flags & ADAPTATION) != 0;
+		}
+
+		/// Check if the packet is scrambled
+		bool isScrambled() const {
+			return (flags & SCRAMBLED) != 0;
+		}
+
+		/// Get the 2 bits transport scrambling control
+		uint8_t getScramblingControl() const {
+			return flags >> 6;
+		}
+
+		uint16_t pid;
+		uint8_t  cc;
+		uint8_t  flags;
+	};
+
+	/// The class @c TSHeaderParser validates and decodes the headers of many
+	/// TS packets at once. It uses SSE2 or AVX2 when the processor has it,
+	/// which is checked once at runtime, otherwise a plain C++ version
+	class TSHeaderParser {
+		public:
+
+			// ================================================================
+			//  -- Other member functions -------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Decode the headers of @a count TS packets of 188 Bytes
+			/// @param ts specifies the first TS packet
+			/// @param header will get the decoded header of each TS packet
+			/// @return the amount of TS packets with a sync byte
+			static std::size_t parse(const unsigned char *ts, std::size_t count,
+				TSPacketHeader *header);
+
+			/// Find the first offset in @a data from which three TS packets
+			/// have a sync byte
+			/// @param size specifies the amount of Bytes in @a data, the three
+			/// sync bytes of an offset should all be within these Bytes
+			/// @return the offset or @a size when no sync was found
+			static std::size_t findSync(const unsigned char *data, std::size_t size);
+
+			/// Get the name of the implementation used on this processor
+			static const char *getImplementationName();
+
+	};
+
+} // namespace mpegts
+
+#endif // MPEGTS_TSHEADERPARSER_H_INCLUDE
@@ -0,0 +1,270 @@
+/* Headend.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/Headend.h>
+
+#include <Log.h>
+#include <Stream.h>
+#include <StringConverter.h>
+#include <base/M3UParser.h>
+#include <input/Device.h>
+
+#include <cstdlib>
+
+namespace output {
+
+	constexpr unsigned int Headend::DEFAULT_RELOCK_TIMEOUT;
+	constexpr unsigned int Headend::MAX_RELOCK_TIMEOUT;
+
+	/// Time before starting a channel that did not start is tried again
+	static constexpr std::chrono::seconds START_RETRY_TIME(5);
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	Headend::Headend() :
+		_enabled(false),
+		_relockTimeout(DEFAULT_RELOCK_TIMEOUT),
+		_generation(0),
+		_starts(0),
+		_startFails(0),
+		_restarts(0) {}
+
+	Headend::~Headend() {}
+
+	// =======================================================================
+	//  -- base::XMLSupport --------------------------------------------------
+	// =======================================================================
+
+	void Headend::addToXML(std::string &xml) const {
+		base::MutexLock lock(_xmlMutex);
+		ADD_XML_CHECKBOX(xml, "enable", (_enabled ? "true" : "false"));
+		ADD_XML_TEXT_INPUT(xml, "channelsM3U", _channelsM3U);
+		ADD_XML_NUMBER_INPUT(xml, "relocktimeout", _relockTimeout, 1, MAX_RELOCK_TIMEOUT);
+		ADD_XML_ELEMENT(xml, "channels", _channel.size());
+		std::size_t streaming = 0;
+		std::size_t i = 0;
+		for (const Channel &channel : _channel) {
+			std::string element;
+			ADD_XML_ELEMENT(element, "name", channel.name);
+			ADD_XML_ELEMENT(element, "group", channel.group);
+			ADD_XML_ELEMENT(element, "port", channel.port);
+			ADD_XML_ELEMENT(element, "stream", channel.streamID);
+			ADD_XML_ELEMENT(element, "locked", ((channel.streamID != -1 && channel.locked) ? "true" : "false"));
+			ADD_XML_N_ELEMENT(xml, "channel", i, element);
+			if (channel.streamID != -1) {
+				++streaming;
+			}
+			++i;
+		}
+		ADD_XML_ELEMENT(xml, "streaming", streaming);
+		ADD_XML_ELEMENT(xml, "starts", _starts);
+		ADD_XML_ELEMENT(xml, "startfails", _startFails);
+		ADD_XML_ELEMENT(xml, "restarts", _restarts);
+	}
+
+	void Headend::fromXML(const std::string &xml) {
+		base::MutexLock lock(_xmlMutex);
+		std::string element;
+		if (findXMLElement(xml, "enable.value", element)) {
+			const bool enabled = (element == "true") ? true : false;
+			if (_enabled && !enabled) {
+				stopChannels();
+			}
+			_enabled = enabled;
+		}
+		if (findXMLElement(xml, "channelsM3U.value", element)) {
+			if (element != _channelsM3U) {
+				_channelsM3U = element;
+				readChannels();
+			}
+		}
+		if (findXMLElement(xml, "relocktimeout.value", element)) {
+			const unsigned int timeout = std::stoi(element);
+			_relockTimeout = (timeout >= 1 && timeout <= MAX_RELOCK_TIMEOUT) ? timeout : DEFAULT_RELOCK_TIMEOUT;
+		}
+	}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void Headend::setAppDataPath(const std::string &appDataPath) {
+		base::MutexLock lock(_xmlMutex);
+		_channelsM3U = appDataPath + "/" + "headend.m3u";
+		readChannels();
+	}
+
+	void Headend::readChannels() {
+		stopChannels();
+		_channel.clear();
+		base::M3UParser::EntryVector entries;
+		if (!base::M3UParser::readEntries(_channelsM3U, entries)) {
+			return;
+		}
+		for (const base::M3UParser::Entry &entry : entries) {
+			const auto multicast = entry.attribute.find("satip-multicast");
+			if (multicast == entry.attribute.end()) {
+				continue;
+			}
+			Channel channel;
+			channel.name = entry.title;
+			const std::string::size_type colon = multicast->second.find(':');
+			channel.group = multicast->second.substr(0, colon);
+			channel.port = (colon != std::string::npos) ? std::atoi(multicast->second.c_str() + colon + 1) : 0;
+			const std::string::size_type query = entry.uri.find('?');
+			if (!Stream::isMulticastAddress(channel.group) || channel.port < 1024 || channel.port > 65534 ||
+			    query == std::string::npos) {
+				SI_LOG_ERROR("Headend: Skipping channel %s with %s to %s", entry.title.c_str(),
+					entry.uri.c_str(), multicast->second.c_str());
+				continue;
+			}
+			channel.query = entry.uri.substr(query + 1);
+			const std::string method("SETUP");
+			const std::string msg = StringConverter::stringFormat("%1 /?%2 RTSP/1.0\r\n\r\n", method, channel.query);
+			channel.msys = StringConverter::getMSYSParameter(msg, method);
+			channel.streamID = -1;
+			channel.locked = false;
+			_channel.push_back(channel);
+		}
+		SI_LOG_INFO("Headend: Found %zu channels in %s", _channel.size(), _channelsM3U.c_str());
+	}
+
+	void Headend::stopChannels() {
+		for (Channel &channel : _channel) {
+			if (channel.streamID != -1) {
+				_stopStream.push_back(channel.streamID);
+				channel.streamID = -1;
+			}
+		}
+		++_generation;
+	}
+
+	void Headend::update(const StreamVector &streams) {
+		std::vector<int> stopStream;
+		ChannelVector channels;
+		bool enabled;
+		uint64_t generation;
+		std::chrono::seconds relockTimeout;
+		{
+			base::MutexLock lock(_xmlMutex);
+			stopStream.swap(_stopStream);
+			enabled = _enabled;
+			channels = _channel;
+			generation = _generation;
+			relockTimeout = std::chrono::seconds(_relockTimeout);
+		}
+		for (const int streamID : stopStream) {
+			streams[streamID]->stopHeadend();
+		}
+		if (!enabled) {
+			return;
+		}
+
+		// Check and (re)start the channels outside the lock, tuning takes some time
+		uint64_t starts = 0;
+		uint64_t startFails = 0;
+		uint64_t restarts = 0;
+		const Clock::time_point now = Clock::now();
+		for (Channel &channel : channels) {
+			if (channel.streamID != -1) {
+				const SpStream stream = streams[channel.streamID];
+				if (!stream->isHeadend()) {
+					// The stream was taken from us, for instance it was disabled
+					SI_LOG_INFO("Headend: Channel %s stopped on Stream: %d", channel.name.c_str(), channel.streamID);
+					channel.streamID = -1;
+					channel.lastStart = Clock::time_point();
+				} else if (stream->hasInputLock()) {
+					channel.locked = true;
+				} else {
+					if (channel.locked) {
+						channel.locked = false;
+						channel.lockLost = now;
+					}
+					if (now - channel.lockLost >= relockTimeout) {
+						// Re-tune the same stream, so the group keeps one sender and
+						// the joined RTSP clients stay attached
+						SI_LOG_INFO("Headend: Channel %s without lock on Stream: %d, re-tuning",
+							channel.name.c_str(), channel.streamID);
+						stream->retuneHeadend(channel.query);
+						channel.lockLost = now;
+						++restarts;
+					}
+				}
+			}
+			if (channel.streamID != -1 ||
+			    (channel.lastStart != Clock::time_point() && now - channel.lastStart < START_RETRY_TIME)) {
+				continue;
+			}
+			channel.lastStart = now;
+			// A stopped channel may still be streaming to the group for the RTSP
+			// clients that joined it, do not start a second sender then
+			bool groupInUse = false;
+			for (SpStream stream : streams) {
+				if (stream->isMulticastStreamingTo(channel.group, channel.port)) {
+					SI_LOG_DEBUG("Headend: Channel %s waits, Stream: %d is still streaming to %s:%d",
+						channel.name.c_str(), stream->getStreamID(), channel.group.c_str(), channel.port);
+					groupInUse = true;
+					break;
+				}
+			}
+			if (groupInUse) {
+				continue;
+			}
+			// Only try the first idle stream, a channel without signal should
+			// not tune all the tuners
+			for (SpStream stream : streams) {
+				if (stream->streamEnabled() && !stream->streamInUse() &&
+				    stream->getInputDevice()->capableOf(channel.msys)) {
+					if (stream->startHeadend(channel.query, channel.group, channel.port)) {
+						SI_LOG_INFO("Headend: Channel %s started on Stream: %d", channel.name.c_str(),
+							stream->getStreamID());
+						channel.streamID = stream->getStreamID();
+						channel.locked = false;
+						channel.lockLost = now;
+					}
+					break;
+				}
+			}
+			if (channel.streamID != -1) {
+				++starts;
+			} else {
+				++startFails;
+			}
+		}
+
+		base::MutexLock lock(_xmlMutex);
+		_starts += starts;
+		_startFails += startFails;
+		_restarts += restarts;
+		if (generation == _generation) {
+			_channel.swap(channels);
+		} else {
+			// The channels were stopped while we were busy, so stop the
+			// ones we started also
+			for (const Channel &channel : channels) {
+				if (channel.streamID != -1) {
+					_stopStream.push_back(channel.streamID);
+				}
+			}
+		}
+	}
+
+} // namespace output
@@ -0,0 +1,127 @@
+/* Headend.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_HEADEND_H_INCLUDE
+#define OUTPUT_HEADEND_H_INCLUDE OUTPUT_HEADEND_H_INCLUDE
+
+#include <FwDecl.h>
+#include <base/XMLSupport.h>
+#include <input/InputSystem.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+FW_DECL_VECTOR_NS0(Stream);
+
+FW_DECL_SP_NS1(output, Headend);
+
+namespace output {
+
+	/// The class @c Headend streams the channels of an M3U file permanently
+	/// to their multicast group, without any RTSP session. Each channel uses
+	/// an idle stream, and is tuned again when its input device lost the lock.
+	/// A channel in the M3U file looks like:
+	///   #EXTINF:0 satip-multicast="239.1.1.1:5004",Channel name
+	///   rtsp://server/?src=1&freq=11494&pol=h&msys=dvbs2&sr=22000&pids=0,17,18,5100
+	class Headend :
+		public base::XMLSupport {
+		public:
+
+			// =======================================================================
+			//  -- Constructors and destructor ---------------------------------------
+			// =======================================================================
+
+			Headend();
+
+			virtual ~Headend();
+
+			// =======================================================================
+			// -- base::XMLSupport ---------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			virtual void addToXML(std::string &xml) const override;
+
+			virtual void fromXML(const std::string &xml) override;
+
+			// =======================================================================
+			//  -- Other member functions --------------------------------------------
+			// =======================================================================
+
+		public:
+
+			/// Set the path the default channel file is in, and read it
+			void setAppDataPath(const std::string &appDataPath);
+
+			/// Start the channels that are not streaming yet on an idle stream
+			/// of @a streams, and restart the channels that lost the lock.
+			/// Called from the headend thread, it tunes outside the lock
+			void update(const StreamVector &streams);
+
+		private:
+
+			/// Read the channels of the M3U file, the running ones are stopped
+			void readChannels();
+
+			/// Stop all running channels with the next update
+			void stopChannels();
+
+			// =======================================================================
+			// -- Data members -------------------------------------------------------
+			// =======================================================================
+
+		public:
+
+			static constexpr unsigned int DEFAULT_RELOCK_TIMEOUT = 10;
+			static constexpr unsigned int MAX_RELOCK_TIMEOUT = 300;
+
+		private:
+
+			using Clock = std::chrono::steady_clock;
+
+			struct Channel {
+				std::string name;
+				std::string query;            /// tuning parameters and PIDs
+				input::InputSystem msys;      /// requested delivery system
+				std::string group;
+				int port;
+				int streamID;                 /// stream of this channel, -1 if not streaming
+				Clock::time_point lastStart;  /// last time starting was tried
+				Clock::time_point lockLost;   /// time the lock was lost
+				bool locked;
+			};
+			using ChannelVector = std::vector<Channel>;
+
+			bool _enabled;
+			std::string _channelsM3U;
+			unsigned int _relockTimeout;      /// seconds without lock before a re-tune
+			ChannelVector _channel;
+			std::vector<int> _stopStream;     /// streams to stop with the next update
+			uint64_t _generation;             /// changes when the channels are stopped
+			uint64_t _starts;
+			uint64_t _startFails;
+			uint64_t _restarts;
+	};
+
+} // namespace output
+
+#endif // OUTPUT_HEADEND_H_INCLUDE
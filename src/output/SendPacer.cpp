@@ -0,0 +1,124 @@
+/* SendPacer.cpp
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#include <output/SendPacer.h>
+
+#include <algorithm>
+
+namespace output {
+
+	constexpr std::size_t SendPacer::BUCKET_BUFFERS;
+	constexpr std::size_t SendPacer::BACKLOG_BUFFERS;
+
+	/// Time of one bitrate measurement
+	static constexpr std::chrono::milliseconds MEASURE_TIME(100);
+	/// Headroom above the input bitrate, so the output drains the ring
+	static constexpr double HEADROOM = 1.1;
+
+	// =======================================================================
+	// -- Constructors and destructor ----------------------------------------
+	// =======================================================================
+
+	SendPacer::SendPacer() :
+		_enabled(true),
+		_inputBytes(0),
+		_bitrate(0),
+		_bursts(0),
+		_measureBytes(0),
+		_tokens(0.0),
+		_bucketBuffers(BUCKET_BUFFERS),
+		_burst(false) {}
+
+	SendPacer::~SendPacer() {}
+
+	// =======================================================================
+	//  -- Other member functions --------------------------------------------
+	// =======================================================================
+
+	void SendPacer::start(const bool enabled) {
+		const Clock::time_point now = Clock::now();
+		_enabled = enabled;
+		_bitrate = 0;
+		_bursts = 0;
+		_measureBytes = _inputBytes;
+		_measureStart = now;
+		_refillTime = now;
+		_tokens = 0.0;
+		_burst = false;
+	}
+
+	void SendPacer::refill() {
+		const Clock::time_point now = Clock::now();
+
+		// Measure the input bitrate, smoothed over a few measurements
+		const Clock::duration measured = now - _measureStart;
+		if (measured >= MEASURE_TIME) {
+			const uint64_t inputBytes = _inputBytes;
+			const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(measured).count();
+			const uint64_t bitrate = ((inputBytes - _measureBytes) * 1000000) / us;
+			_bitrate = (_bitrate == 0) ? bitrate : ((_bitrate * 3) + bitrate) / 4;
+			_measureBytes = inputBytes;
+			_measureStart = now;
+		}
+
+		// Add the tokens of the elapsed time
+		const double elapsed = std::chrono::duration<double>(now - _refillTime).count();
+		_refillTime = now;
+		_tokens += elapsed * _bitrate * HEADROOM;
+	}
+
+	bool SendPacer::mayWrite(const std::size_t bytes, const std::size_t backlog) {
+		if (!_enabled) {
+			return true;
+		}
+		refill();
+		// No bitrate measured yet, so there is nothing to pace on
+		if (_bitrate == 0) {
+			_tokens = 0.0;
+			return true;
+		}
+		// Behind on the input, send a burst until we caught up
+		if (backlog >= BACKLOG_BUFFERS) {
+			if (!_burst) {
+				_burst = true;
+				++_bursts;
+			}
+			_tokens = std::max(_tokens, static_cast<double>(bytes));
+			return true;
+		}
+		_burst = false;
+
+		// Do not save more tokens than the bucket can hold
+		const double bucket = static_cast<double>(bytes * _bucketBuffers);
+		if (_tokens > bucket) {
+			_tokens = bucket;
+		}
+		return _tokens >= bytes;
+	}
+
+	std::chrono::microseconds SendPacer::getWaitTime(const std::size_t bytes) const {
+		const uint64_t bitrate = _bitrate;
+		if (!_enabled || bitrate == 0 || _tokens >= bytes) {
+			return std::chrono::microseconds(0);
+		}
+		const double wait = (bytes - _tokens) / (bitrate * HEADROOM);
+		return std::chrono::microseconds(static_cast<long>(wait * 1000000.0) + 1);
+	}
+
+} // namespace output
@@ -0,0 +1,129 @@
+/* SendPacer.h
+
+   Copyright (C) 2014 - 2019 Marc Postema (mpostema09 -at- gmail.com)
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+   Or, point your browser to http://www.gnu.org/copyleft/gpl.html
+*/
+#ifndef OUTPUT_SENDPACER_H_INCLUDE
+#define OUTPUT_SENDPACER_H_INCLUDE OUTPUT_SENDPACER_H_INCLUDE
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace output {
+
+	/// The class @c SendPacer is a token bucket that spreads the sending of
+	/// the packet buffers over time. The bucket is refilled with the measured
+	/// input bitrate (with some headroom), so there is no fixed ceiling. The
+	/// bucket can hold a few buffers, and when the output is behind on the
+	/// input it may send a burst to catch up. The input stage accounts the
+	/// read Bytes, all other functions are called from the output stage
+	class SendPacer {
+		public:
+
+			// ================================================================
+			//  -- Constructors and destructor --------------------------------
+			// ================================================================
+			SendPacer();
+
+			virtual ~SendPacer();
+
+			// ================================================================
+			//  -- Other member functions -------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Start pacing (again) and forget the measured bitrate
+			/// @param enabled specifies if sending should be paced, without
+			/// pacing everything is send as soon as it is ready (TCP)
+			void start(bool enabled);
+
+			/// Check if sending is paced
+			bool isEnabled() const {
+				return _enabled;
+			}
+
+			/// Account the Bytes read from the input device (input stage)
+			void addInputBytes(std::size_t bytes) {
+				_inputBytes += bytes;
+			}
+
+			/// Check if a buffer of @a bytes may be send now
+			/// @param backlog specifies the amount of buffers ready to send
+			bool mayWrite(std::size_t bytes, std::size_t backlog);
+
+			/// Set the amount of buffers the bucket can hold, so a batch of
+			/// buffers can be send at once. Not less than @c BUCKET_BUFFERS
+			void setBucketSize(std::size_t buffers) {
+				_bucketBuffers = (buffers > BUCKET_BUFFERS) ? buffers : BUCKET_BUFFERS;
+			}
+
+			/// Account a buffer of @a bytes that was send
+			void addWritten(std::size_t bytes) {
+				_tokens -= bytes;
+			}
+
+			/// Get the time to wait before the next buffer of @a bytes may be send
+			std::chrono::microseconds getWaitTime(std::size_t bytes) const;
+
+			/// Get the measured input bitrate in Bits/s
+			uint64_t getBitrate() const {
+				return _bitrate * 8;
+			}
+
+			/// Get the amount of times a burst was send to catch up
+			uint64_t getBursts() const {
+				return _bursts;
+			}
+
+		private:
+
+			/// Measure the input bitrate and add the tokens of the elapsed time
+			void refill();
+
+			// ================================================================
+			//  -- Data members -----------------------------------------------
+			// ================================================================
+
+		public:
+
+			/// Buffers that may be send at once without waiting
+			static constexpr std::size_t BUCKET_BUFFERS = 4;
+			/// Buffers ready to send that are considered as 'behind'
+			static constexpr std::size_t BACKLOG_BUFFERS = 16;
+
+		private:
+
+			using Clock = std::chrono::steady_clock;
+
+			bool _enabled;
+			std::atomic<uint64_t> _inputBytes;
+			std::atomic<uint64_t> _bitrate;    /// in Bytes/s, 0 = unknown yet
+			std::atomic<uint64_t> _bursts;
+			uint64_t _measureBytes;            /// input Bytes at measure start
+			Clock::time_point _measureStart;
+			Clock::time_point _refillTime;
+			double _tokens;                    /// Bytes that may be send now
+			std::size_t _bucketBuffers;        /// buffers the bucket can hold
+			bool _burst;                       /// sending a burst to catch up
+	};
+
+} // namespace output
+
+#endif // OUTPUT_SENDPACER_H_INCLUDE
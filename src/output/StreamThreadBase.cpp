@@ -19,38 +19,77 @@
  */
 #include <output/StreamThreadBase.h>
 
+#include <base/Thread.h>
 #include <base/TimeCounter.h>
 #include <StreamInterface.h>
 #include <StreamClient.h>
 #include <StringConverter.h>
 #include <Log.h>
 #include <input/Device.h>
+#include <input/InputReactor.h>
+#include <mpegts/PacketBufferPool.h>
+#include <mpegts/TSHeaderParser.h>
 #ifdef LIBDVBCSA
 	#include <decrypt/dvbapi/Client.h>
 #endif
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <functional>
 #include <thread>
 
 namespace output {
 
+	constexpr size_t StreamThreadBase::MIN_RING_SIZE;
+	constexpr size_t StreamThreadBase::DEFAULT_RING_SIZE;
+	constexpr size_t StreamThreadBase::MAX_RING_SIZE;
+	constexpr std::size_t StreamThreadBase::MAX_OUTPUT_BATCH;
+	constexpr std::chrono::milliseconds StreamThreadBase::FILTERED_BUFFER_MAX_AGE;
+
 	StreamThreadBase::StreamThreadBase(const std::string &protocol, StreamInterface &stream) :
 		ThreadBase(StringConverter::getFormattedString("Streaming%d", stream.getStreamID())),
 		_stream(stream),
 		_protocol(protocol),
 		_state(State::Paused),
 		_writeIndex(0),
+		_publishIndex(0),
 		_readIndex(0),
-		_sendInterval(100) {
-		// Initialize all TS packets
-		uint32_t ssrc = _stream.getSSRC();
-		long timestamp = _stream.getTimestamp();
-		for (size_t i = 0; i < MAX_BUF; ++i) {
-			_tsBuffer[i].initialize(ssrc, timestamp);
+		_pool(stream.getPacketBufferPool()),
+		_ringSize(0),
+		_wantedRingSize(DEFAULT_RING_SIZE),
+		_inputStallsAtAcquire(0),
+		_reactor(stream.getInputReactor()),
+		_reactorFD(-1),
+		_inputWaiting(false),
+		_fanOut(false),
+		_fanOutIndex(0),
+		_outputWaiting(false),
+		_ringSpaceWaiting(false),
+		_inputOccupancyMax(0),
+		_outputOccupancyMax(0),
+		_inputStalls(0),
+		_outputStalls(0),
+		_outputStarved(0),
+		_nullPacketsStripped(0),
+		_congestionDroppedMedium(0),
+		_congestionDroppedLow(0),
+		_pauseTime(0),
+		_pauseToRestart(0),
+		_pauseToRestartMax(0),
+		_batchWaiting(false),
+		_sendCalls(0),
+		_sendPackets(0),
+		_inFlight(0) {
+		if (_pool == nullptr) {
+			_pool = std::make_shared<mpegts::PacketBufferPool>();
 		}
 	}
 
 	StreamThreadBase::~StreamThreadBase() {
+		stopOutputStage();
+		releaseRing();
+		releaseHeldBuffers();
 #ifdef LIBDVBCSA
 		decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
 		if (decrypt != nullptr) {
@@ -64,22 +103,40 @@ namespace output {
 		const int clientID = 0;
 		const StreamClient &client = _stream.getStreamClient(clientID);
 
-		_writeIndex = 0;
-		_readIndex = 0;
-		_tsBuffer[_writeIndex].reset();
+		_inputOccupancyMax = 0;
+		_outputOccupancyMax = 0;
+		_inputStalls = 0;
+		_outputStalls = 0;
+		_outputStarved = 0;
+		_nullPacketsStripped = 0;
+		_congestionDroppedMedium = 0;
+		_congestionDroppedLow = 0;
+		_sendCalls = 0;
+		_sendPackets = 0;
+		acquireRing();
+		resetRing();
+		_pacer.start(isPacingNeeded());
+		startOutputStage();
+
+		if (addToInputReactor()) {
+			_pauseStart = std::chrono::steady_clock::now();
+			setState(State::Running);
+			SI_LOG_INFO("Stream: %d, Start %s stream to %s:%d (input reactor)", streamID, _protocol.c_str(),
+					client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
+			return true;
+		}
 
 		if (!startThread()) {
 			SI_LOG_ERROR("Stream: %d, Start %s Start stream to %s:%d ERROR", streamID, _protocol.c_str(),
 					client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
+			stopOutputStage();
 			return false;
 		}
 		// Set priority above normal for this Thread
 		setPriority(Priority::AboveNormal);
 
-		// set begin timestamp
-		_t1 = std::chrono::steady_clock::now();
-
-		_state = State::Running;
+		_pauseStart = std::chrono::steady_clock::now();
+		setState(State::Running);
 		SI_LOG_INFO("Stream: %d, Start %s stream to %s:%d", streamID, _protocol.c_str(),
 				client.getIPAddressOfStream().c_str(), getStreamSocketPort(clientID));
 
@@ -88,14 +145,30 @@ namespace output {
 
 	bool StreamThreadBase::restartStreaming(int clientID) {
 		// Check if thread is running
-		if (running()) {
-			_writeIndex = 0;
-			_readIndex  = 0;
-			_tsBuffer[_writeIndex].reset();
-			_state = State::Running;
-			SI_LOG_INFO("Stream: %d, Restart %s stream to %s:%d", _stream.getStreamID(),
+		if (isStreaming()) {
+			// The ring was given back when the stream was paused
+			if (_ringSize == 0) {
+				acquireRing();
+			}
+			resetRing();
+			_pacer.start(isPacingNeeded());
+			startOutputStage();
+			// The input device was probably reopened, so add the new one
+			if (!running() && !addToInputReactor()) {
+				SI_LOG_ERROR("Stream: %d, Restart %s stream, unable to add input to reactor",
+					_stream.getStreamID(), _protocol.c_str());
+				return false;
+			}
+			setState(State::Running);
+			const uint64_t pauseToRestart = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - _pauseStart).count();
+			_pauseToRestart = pauseToRestart;
+			if (pauseToRestart > _pauseToRestartMax) {
+				_pauseToRestartMax = pauseToRestart;
+			}
+			SI_LOG_INFO("Stream: %d, Restart %s stream to %s:%d (%.3f ms after pause)", _stream.getStreamID(),
 					_protocol.c_str(), _stream.getStreamClient(clientID).getIPAddressOfStream().c_str(),
-					getStreamSocketPort(clientID));
+					getStreamSocketPort(clientID), pauseToRestart / 1000.0);
 		}
 		return true;
 	}
@@ -103,23 +176,31 @@ namespace output {
 	bool StreamThreadBase::pauseStreaming(int clientID) {
 		bool paused = true;
 		// Check if thread is running
-		if (running()) {
-			_state = State::Pause;
+		if (isStreaming()) {
+			_pauseStart = std::chrono::steady_clock::now();
+			setState(State::Pause);
+			if (!running()) {
+				// This will wait until the reactor is finished with us
+				removeFromInputReactor();
+				setState(State::Paused);
+			}
 			const StreamClient &client = _stream.getStreamClient(clientID);
 			const double payload = _stream.getRtpPayload() / (1024.0 * 1024.0);
-			// try waiting on pause
-			auto timeout = 0;
-			while (_state != State::Paused) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
-				++timeout;
-				if (timeout > 50) {
-					SI_LOG_ERROR("Stream: %d, Pause %s stream to %s:%d  TIMEOUT (Streamed %.3f MBytes)",
-							_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str(),
-							getStreamSocketPort(clientID), payload);
-					paused = false;
-					break;
-				}
+			// wait until the streaming thread is paused
+			{
+				std::unique_lock<std::mutex> lock(_stateMutex);
+				paused = _stateChanged.wait_for(lock, std::chrono::milliseconds(2500),
+					[this] { return _state == State::Paused; });
 			}
+			_pauseTime = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - _pauseStart).count();
+			if (!paused) {
+				SI_LOG_ERROR("Stream: %d, Pause %s stream to %s:%d  TIMEOUT (Streamed %.3f MBytes)",
+						_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str(),
+						getStreamSocketPort(clientID), payload);
+			}
+			// The output stage is stopped, so the ring can be reset on restart
+			stopOutputStage();
 			if (paused) {
 				SI_LOG_INFO("Stream: %d, Pause %s stream to %s:%d (Streamed %.3f MBytes)",
 						_stream.getStreamID(), _protocol.c_str(), client.getIPAddressOfStream().c_str(),
@@ -131,52 +212,775 @@ namespace output {
 				decrypt->stopDecrypt(_stream.getStreamID());
 			}
 #endif
+			if (paused) {
+				// Send what the filtered clients still have, then give the
+				// buffers back while paused, nothing refers to them now
+				flushFilteredBuffers(true);
+				releaseRing();
+			}
 		}
 		return paused;
 	}
 
-	void StreamThreadBase::readDataFromInputDevice(StreamClient &client) {
+	void StreamThreadBase::wakeUpThread() {
+		// Take the lock, so a thread checking running() is waiting already
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+		}
+		_stateChanged.notify_all();
+		notifyStageWaits();
+		_stream.getInputDevice()->wakeUp();
+	}
+
+	void StreamThreadBase::notifyStageWaits() {
+		{
+			std::unique_lock<std::mutex> lock(_outputMutex);
+		}
+		_outputReady.notify_all();
+		_ringSpace.notify_all();
+	}
+
+	void StreamThreadBase::setState(const State state) {
+		{
+			std::unique_lock<std::mutex> lock(_stateMutex);
+			_state = state;
+		}
+		_stateChanged.notify_all();
+		notifyStageWaits();
+		// The streaming thread may be waiting on input data, so let it see
+		// the pause at once
+		if (state == State::Pause) {
+			_stream.getInputDevice()->wakeUp();
+		}
+	}
+
+	void StreamThreadBase::waitWhilePaused() {
+		std::unique_lock<std::mutex> lock(_stateMutex);
+		_stateChanged.wait(lock, [this] { return _state != State::Paused || !running(); });
+	}
+
+	void StreamThreadBase::terminateStreaming() {
+		removeFromInputReactor();
+		terminateThread();
+		stopOutputStage();
+	}
+
+	void StreamThreadBase::addToXML(std::string &xml) const {
+		const size_t writeIndex = _writeIndex;
+		const size_t publishIndex = _publishIndex;
+		const size_t readIndex = _readIndex;
+		const size_t ringSize = _ringSize;
+		ADD_XML_ELEMENT(xml, "splitStreamingRunning", (_outputThread != nullptr) ? "yes" : "no");
+		ADD_XML_ELEMENT(xml, "ringSize", ringSize);
+		ADD_XML_ELEMENT(xml, "inputOccupancy", (ringSize == 0) ? 0 : (writeIndex + ringSize - publishIndex) % ringSize);
+		ADD_XML_ELEMENT(xml, "inputOccupancyMax", _inputOccupancyMax.load());
+		ADD_XML_ELEMENT(xml, "inputStalls", _inputStalls.load());
+		ADD_XML_ELEMENT(xml, "outputOccupancy", (ringSize == 0) ? 0 : (publishIndex + ringSize - readIndex) % ringSize);
+		ADD_XML_ELEMENT(xml, "outputOccupancyMax", _outputOccupancyMax.load());
+		ADD_XML_ELEMENT(xml, "outputStalls", _outputStalls.load());
+		ADD_XML_ELEMENT(xml, "outputStarved", _outputStarved.load());
+		ADD_XML_ELEMENT(xml, "nullPacketsStripped", _nullPacketsStripped.load());
+		ADD_XML_ELEMENT(xml, "nullBytesSaved", _nullPacketsStripped.load() * mpegts::PacketBuffer::TS_PACKET_SIZE);
+		ADD_XML_ELEMENT(xml, "congestionDroppedMedium", _congestionDroppedMedium.load());
+		ADD_XML_ELEMENT(xml, "congestionDroppedLow", _congestionDroppedLow.load());
+		ADD_XML_ELEMENT(xml, "pauseTime", _pauseTime.load());
+		ADD_XML_ELEMENT(xml, "pauseToRestart", _pauseToRestart.load());
+		ADD_XML_ELEMENT(xml, "pauseToRestartMax", _pauseToRestartMax.load());
+		const uint64_t sendCalls = _sendCalls;
+		ADD_XML_ELEMENT(xml, "sendCalls", sendCalls);
+		ADD_XML_ELEMENT(xml, "packetsPerSend", (sendCalls == 0) ? 0.0 : static_cast<double>(_sendPackets) / sendCalls);
+		ADD_XML_ELEMENT(xml, "pacing", _pacer.isEnabled() ? "Token bucket" : "None");
+		ADD_XML_ELEMENT(xml, "pacingBitrate", _pacer.getBitrate() / 1000);
+		ADD_XML_ELEMENT(xml, "pacingBursts", _pacer.getBursts());
+	}
+
+	void StreamThreadBase::acquireRing() {
+		releaseRing();
+
+		const std::size_t numberOfTSPackets = _stream.getTSPacketsPerBuffer();
+		_pool->allocate(numberOfTSPackets, MIN_RING_SIZE, _wantedRingSize, _tsBuffer);
+		const uint32_t ssrc = _stream.getSSRC();
+		const long timestamp = _stream.getTimestamp();
+		for (mpegts::PacketBuffer *buffer : _tsBuffer) {
+			buffer->initialize(ssrc, timestamp, numberOfTSPackets);
+		}
+		if (!_clientBuffer.empty() &&
+		    _clientBuffer[0].getNumberOfTSPackets() != _tsBuffer[0]->getNumberOfTSPackets()) {
+			_clientBuffer.clear();
+		}
+		_ringSize = _tsBuffer.size();
+		_inputStallsAtAcquire = _inputStalls.load();
+		_inputOccupancyMax = 0;
+		_outputOccupancyMax = 0;
+		SI_LOG_DEBUG("Stream: %d, Using a ring of %zu buffers with %zu TS packets", _stream.getStreamID(),
+			_tsBuffer.size(), _tsBuffer[0]->getNumberOfTSPackets());
+	}
+
+	void StreamThreadBase::releaseRing() {
+		const size_t ringSize = _ringSize;
+		if (ringSize == 0) {
+			return;
+		}
+		// Let a busy stream borrow a deeper ring next time, when the input had
+		// to wait on a full ring, and give buffers back when it hardly used it
+		const size_t used = _inputOccupancyMax + _outputOccupancyMax;
+		if (_inputStalls != _inputStallsAtAcquire) {
+			_wantedRingSize = std::min(ringSize * 2, MAX_RING_SIZE);
+		} else if (used > 0 && used < ringSize / 4) {
+			_wantedRingSize = std::max(ringSize / 2, MIN_RING_SIZE);
+		}
+		releaseInFlightBuffers(true);
+		_ringSize = 0;
+		_pool->release(_tsBuffer);
+	}
+
+	void StreamThreadBase::resetRing() {
+		releaseInFlightBuffers(true);
+		_writeIndex = 0;
+		_publishIndex = 0;
+		_readIndex = 0;
+		_tsBuffer[0]->reset();
+		_fanOut = false;
+		_batchWaiting = false;
+	}
+
+	void StreamThreadBase::startOutputStage() {
+		if (_outputThread != nullptr || !_stream.isSplitStreaming()) {
+			return;
+		}
+		_outputThread.reset(new base::Thread(
+			StringConverter::getFormattedString("Sending%d", _stream.getStreamID()),
+			std::bind(&StreamThreadBase::outputStage, this)));
+		if (!_outputThread->startThread()) {
+			SI_LOG_ERROR("Stream: %d, Unable to start output thread, sending from the input stage",
+				_stream.getStreamID());
+			_outputThread.reset();
+			return;
+		}
+		_outputThread->setPriority(base::Thread::Priority::AboveNormal);
+	}
+
+	void StreamThreadBase::stopOutputStage() {
+		if (_outputThread == nullptr) {
+			return;
+		}
+		{
+			std::unique_lock<std::mutex> lock(_outputMutex);
+			_outputReady.notify_one();
+		}
+		_outputThread->terminateThread();
+		_outputThread.reset();
+	}
+
+	bool StreamThreadBase::outputStage() {
+		if (_state == State::Running) {
+			StreamClient &client = _stream.getStreamClient(0);
+			if (writePacedBuffers(client)) {
+				resumeInput();
+				if (_ringSpaceWaiting) {
+					std::unique_lock<std::mutex> lock(_outputMutex);
+					_ringSpace.notify_one();
+				}
+				return true;
+			}
+			if (_readIndex != _publishIndex) {
+				// Wait on the pacer, or the output device is busy, try again soon.
+				// A state change ends the wait at once
+				std::chrono::microseconds wait = _pacer.getWaitTime(_tsBuffer[0]->getBufferSize());
+				if (wait.count() == 0 || wait > std::chrono::microseconds(10000)) {
+					wait = std::chrono::microseconds((wait.count() == 0) ? 500 : 10000);
+				}
+				std::unique_lock<std::mutex> lock(_outputMutex);
+				_outputReady.wait_for(lock, wait, [this] { return _state != State::Running; });
+				return true;
+			}
+			++_outputStarved;
+		}
+		// Wait until the input stage published some buffers or the state
+		// changed, the timeout is for stop
+		std::unique_lock<std::mutex> lock(_outputMutex);
+		_outputWaiting = true;
+		_outputReady.wait_for(lock, std::chrono::milliseconds(10), [this] {
+			return _state != State::Running || _readIndex != _publishIndex;
+		});
+		_outputWaiting = false;
+		return true;
+	}
+
+	bool StreamThreadBase::addToInputReactor() {
+		removeFromInputReactor();
 		const input::SpDevice inputDevice = _stream.getInputDevice();
+		const int fd = inputDevice->getInputFileDescriptor();
+		if (_reactor == nullptr || fd == -1 || !_reactor->isEnabled()) {
+			return false;
+		}
+		if (!_reactor->add(fd, std::bind(&StreamThreadBase::inputDeviceReady, this))) {
+			return false;
+		}
+		_reactorFD = fd;
+		return true;
+	}
+
+	void StreamThreadBase::removeFromInputReactor() {
+		const int fd = _reactorFD;
+		if (fd != -1) {
+			_reactorFD = -1;
+			_reactor->remove(fd);
+		}
+		_inputWaiting = false;
+	}
+
+	void StreamThreadBase::resumeInput() {
+		if (_inputWaiting.exchange(false)) {
+			const int fd = _reactorFD;
+			if (fd != -1) {
+				_reactor->resume(fd);
+			}
+		}
+	}
+
+	std::chrono::microseconds StreamThreadBase::inputDeviceReady() {
+		if (_state != State::Running) {
+			return std::chrono::microseconds(0);
+		}
+		const input::SpDevice inputDevice = _stream.getInputDevice();
+		// Client 0 is the owner, when the stream is shared the other clients
+		// get their buffers from writeFanOutBuffers()
+		StreamClient &client = _stream.getStreamClient(0);
+		// Drain the input device and send all that is ready, but give the
+		// other devices on this reactor worker also a chance
+		bool progress = true;
+		for (std::size_t round = 0; progress && round < 8; ++round) {
+			progress = false;
+			while (readInputDevice(*inputDevice)) {
+				progress = true;
+			}
+			if (_outputThread != nullptr) {
+				break;
+			}
+			if (writePacedBuffers(client)) {
+				progress = true;
+			}
+		}
+		if (!isRingFull()) {
+			return std::chrono::microseconds(0);
+		}
+		// The input device is still readable, so the reactor would call us
+		// again at once. Do not let it watch the input device until the
+		// output thread did send some buffers, or until the pacer or output
+		// device lets us send again
+		if (_outputThread != nullptr) {
+			_inputWaiting = true;
+			return std::chrono::microseconds(10000);
+		}
+		std::chrono::microseconds wait = _pacer.getWaitTime(_tsBuffer[0]->getBufferSize());
+		if (wait.count() == 0 || wait > std::chrono::microseconds(10000)) {
+			wait = std::chrono::microseconds((wait.count() == 0) ? 500 : 10000);
+		}
+		return wait;
+	}
 
-		size_t availableSize = (MAX_BUF - (_writeIndex - _readIndex));
-		if (availableSize > MAX_BUF) {
-			availableSize %= MAX_BUF;
+	bool StreamThreadBase::readInputDevice(input::Device &inputDevice) {
+		const size_t ringSize = _ringSize;
+		if (ringSize == 0) {
+			return false;
+		}
+		const size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+		const size_t readIndex = _readIndex.load(std::memory_order_acquire);
+		const size_t availableSize = ringSize - ((writeIndex + ringSize - readIndex) % ringSize);
+//		SI_LOG_DEBUG("Stream: %d, PacketBuffer MAX %d W %d R %d  S %d", _stream.getStreamID(), ringSize, writeIndex, readIndex, availableSize);
+		if (availableSize <= 1) {
+			++_inputStalls;
+			flushDecryptBatch();
+			publishReadyBuffers();
+			return false;
 		}
-//		SI_LOG_DEBUG("Stream: %d, PacketBuffer MAX %d W %d R %d  S %d", _stream.getStreamID(), MAX_BUF, _writeIndex, _readIndex, availableSize);
-		if (inputDevice->isDataAvailable() && availableSize > 1) {
-			if (inputDevice->readFullTSPacket(_tsBuffer[_writeIndex])) {
+		mpegts::PacketBuffer &buffer = *_tsBuffer[writeIndex];
+		const std::size_t bytesToWrite = buffer.getAmountOfBytesToWrite();
+		if (inputDevice.readFullTSPacket(buffer)) {
+			// Under congestion drop the lowest priority PIDs first, instead of
+			// letting the DVR overflow and lose random packets
+			const bool stripNull = _stream.isNullPacketStripping();
+			const mpegts::Filter::Priority lowestKept = getLowestKeptPriority(ringSize, ringSize - availableSize);
+			if ((stripNull || lowestKept != mpegts::Filter::Priority::Low) &&
+			    !dropTSPackets(inputDevice.getFilter(), buffer, stripNull, lowestKept)) {
+				// Packets removed, so fill the rest of the buffer first
+				return true;
+			}
 #ifdef LIBDVBCSA
-				decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
-				if (decrypt != nullptr) {
-					decrypt->decrypt(_stream.getStreamID(), _tsBuffer[_writeIndex]);
+			decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
+			if (decrypt != nullptr) {
+				decrypt->decrypt(_stream.getStreamID(), buffer);
+			}
+#endif
+			// goto next, so inc write index and reset next
+			const size_t nextIndex = (writeIndex + 1) % ringSize;
+			_tsBuffer[nextIndex]->reset();
+			_writeIndex.store(nextIndex, std::memory_order_relaxed);
+			_pacer.addInputBytes(buffer.getBufferSize());
+			publishReadyBuffers();
+			return true;
+		}
+		if (buffer.getAmountOfBytesToWrite() != bytesToWrite) {
+			return true;
+		}
+		flushDecryptBatch();
+		publishReadyBuffers();
+		return false;
+	}
+
+	mpegts::Filter::Priority StreamThreadBase::getLowestKeptPriority(
+			const size_t ringSize, const size_t used) const {
+		const size_t threshold = _stream.getCongestionDropThreshold();
+		if (threshold == 0) {
+			return mpegts::Filter::Priority::Low;
+		}
+		// Drop the low priority PIDs above the threshold, and also the medium
+		// ones when halfway between the threshold and a full ring
+		const size_t lowLevel = (ringSize * threshold) / 100;
+		const size_t mediumLevel = (lowLevel + ringSize) / 2;
+		if (used >= mediumLevel) {
+			return mpegts::Filter::Priority::High;
+		} else if (used >= lowLevel) {
+			return mpegts::Filter::Priority::Medium;
+		}
+		return mpegts::Filter::Priority::Low;
+	}
+
+	bool StreamThreadBase::dropTSPackets(const mpegts::Filter &filter, mpegts::PacketBuffer &buffer,
+			const bool stripNull, const mpegts::Filter::Priority lowestKept) {
+		mpegts::TSPacketHeader header[mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS];
+		const std::size_t size = buffer.getNumberOfTSPackets();
+		mpegts::TSHeaderParser::parse(buffer.getTSReadBufferPtr(), size, header);
+		// The kept packets that are accounted already stay in front
+		const std::size_t accounted = buffer.getAccountedTSPackets();
+		std::size_t keep = 0;
+		std::size_t keepAccounted = 0;
+		for (std::size_t i = 0; i < size; ++i) {
+			if (header[i].isNullPacket()) {
+				if (stripNull) {
+					++_nullPacketsStripped;
+					continue;
+				}
+			} else if (lowestKept != mpegts::Filter::Priority::Low && header[i].isSynced()) {
+				const mpegts::Filter::Priority priority = filter.getPriority(header[i].pid);
+				if (priority > lowestKept) {
+					if (priority == mpegts::Filter::Priority::Low) {
+						++_congestionDroppedLow;
+					} else {
+						++_congestionDroppedMedium;
+					}
+					continue;
 				}
+			}
+			if (keep != i) {
+				std::memcpy(buffer.getTSPacketPtr(keep), buffer.getTSPacketPtr(i),
+					mpegts::PacketBuffer::TS_PACKET_SIZE);
+			}
+			keepAccounted += (i < accounted) ? 1 : 0;
+			++keep;
+		}
+		if (keep == size) {
+			return true;
+		}
+		buffer.truncateToTSPackets(keep);
+		buffer.setAccountedTSPackets(keepAccounted);
+		return false;
+	}
+
+	void StreamThreadBase::publishReadyBuffers() {
+		const size_t ringSize = _ringSize;
+		const size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+		const size_t publishIndex = _publishIndex.load(std::memory_order_relaxed);
+		size_t index = publishIndex;
+		while (index != writeIndex && _tsBuffer[index]->isReadyToSend()) {
+			index = (index + 1) % ringSize;
+		}
+		const size_t inputOccupancy = (writeIndex + ringSize - index) % ringSize;
+		if (inputOccupancy > _inputOccupancyMax.load(std::memory_order_relaxed)) {
+			_inputOccupancyMax.store(inputOccupancy, std::memory_order_relaxed);
+		}
+		if (index == publishIndex) {
+			return;
+		}
+		_publishIndex.store(index, std::memory_order_release);
+		const size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+		const size_t outputOccupancy = (index + ringSize - readIndex) % ringSize;
+		if (outputOccupancy > _outputOccupancyMax.load(std::memory_order_relaxed)) {
+			_outputOccupancyMax.store(outputOccupancy, std::memory_order_relaxed);
+		}
+		if (_outputWaiting) {
+			std::unique_lock<std::mutex> lock(_outputMutex);
+			_outputReady.notify_one();
+		}
+	}
+
+	void StreamThreadBase::flushDecryptBatch() {
+#ifdef LIBDVBCSA
+		if (_publishIndex.load(std::memory_order_relaxed) == _writeIndex.load(std::memory_order_relaxed)) {
+			return;
+		}
+		decrypt::dvbapi::SpClient decrypt = _stream.getDecryptDevice();
+		if (decrypt != nullptr) {
+			decrypt->flushExpiredBatch(_stream.getStreamID());
+		}
 #endif
-				// goto next, so inc write index
-				++_writeIndex;
-				_writeIndex %= MAX_BUF;
+	}
 
-				// reset next
-				_tsBuffer[_writeIndex].reset();
+	bool StreamThreadBase::writeReadyBuffer(StreamClient &client) {
+		if (_stream.isShared()) {
+			return writeFanOutBuffers();
+		} else if (_fanOut) {
+			stopFanOut();
+		}
+		const size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+		if (readIndex == _publishIndex.load(std::memory_order_acquire)) {
+			return false;
+		}
+		if (!_tsBuffer[readIndex]->isSynced()) {
+			SI_LOG_ERROR("Stream: %d, PacketBuffer not in sync!", _stream.getStreamID());
+		}
+		if (writeDataToOutputDevice(*_tsBuffer[readIndex], client)) {
+			// inc read index only when send is successful
+			_readIndex.store((readIndex + 1) % _ringSize, std::memory_order_release);
+			return true;
+		}
+		++_outputStalls;
+		return false;
+	}
+
+	bool StreamThreadBase::writePacedBuffers(StreamClient &client) {
+		bool progress = false;
+		const std::size_t batchSize = std::min(getOutputBatchSize(), MAX_OUTPUT_BATCH);
+		if (batchSize > 1 && !_stream.isShared()) {
+			while (writeBatchedBuffers(client, batchSize)) {
+				progress = true;
 			}
+			return progress;
+		}
+		releaseInFlightBuffers(true);
+		const std::size_t size = _tsBuffer[0]->getBufferSize();
+		while (_pacer.mayWrite(size, getBacklog()) && writeReadyBuffer(client)) {
+			_pacer.addWritten(size);
+			progress = true;
 		}
+		return progress;
+	}
 
-		// calculate interval
-		_t2 = std::chrono::steady_clock::now();
-		const unsigned long interval = std::chrono::duration_cast<std::chrono::microseconds>(_t2 - _t1).count();
-		if (interval > _sendInterval && _tsBuffer[_readIndex].isReadyToSend()) {
-			//
-			_t1 = _t2;
+	bool StreamThreadBase::writeBatchedBuffers(StreamClient &client, const std::size_t batchSize) {
+		if (_fanOut) {
+			stopFanOut();
+		}
+		const size_t ringSize = _ringSize;
+		if (ringSize == 0) {
+			return false;
+		}
+		// The buffers in flight are send already, so start after them
+		releaseInFlightBuffers(false);
+		const size_t sendIndex = (_readIndex.load(std::memory_order_relaxed) + _inFlight) % ringSize;
+		const size_t ready = (_publishIndex.load(std::memory_order_acquire) + ringSize - sendIndex) % ringSize;
+		if (ready == 0) {
+			return false;
+		}
+		// Wait a little for a full batch, unless we are behind on the input
+		const std::chrono::milliseconds latency = getOutputBatchLatency();
+		if (ready < batchSize && ready < SendPacer::BACKLOG_BUFFERS && latency.count() > 0) {
+			const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			if (!_batchWaiting) {
+				_batchWaiting = true;
+				_batchWaitStart = now;
+			}
+			if (now - _batchWaitStart < latency) {
+				return false;
+			}
+		}
+		_batchWaiting = false;
 
-			if (!_tsBuffer[_readIndex].isSynced()) {
+		// A batch is send at once, so the pacer bucket should be able to hold it
+		_pacer.setBucketSize((latency.count() > 0) ? batchSize : SendPacer::BUCKET_BUFFERS);
+		const std::size_t size = _tsBuffer[0]->getBufferSize();
+		mpegts::PacketBuffer *batch[MAX_OUTPUT_BATCH];
+		std::size_t count = 0;
+		while (count < batchSize && count < ready && _pacer.mayWrite(size, ready - count)) {
+			mpegts::PacketBuffer *buffer = _tsBuffer[(sendIndex + count) % ringSize];
+			if (!buffer->isSynced()) {
 				SI_LOG_ERROR("Stream: %d, PacketBuffer not in sync!", _stream.getStreamID());
 			}
+			batch[count] = buffer;
+			// Tokens of buffers that are not send are not given back, the
+			// output device is behind then anyway
+			_pacer.addWritten(size);
+			++count;
+		}
+		if (count == 0) {
+			return false;
+		}
+		const std::size_t written = writeBatchToOutputDevice(batch, count, client);
+		if (written < count) {
+			++_outputStalls;
+		}
+		// inc read index only with the buffers that were send, and the output
+		// device is done with
+		_inFlight += written;
+		releaseInFlightBuffers(false);
+		return written > 0;
+	}
 
-			if (writeDataToOutputDevice(_tsBuffer[_readIndex], client)) {
-				// inc read index only when send is successful
-				++_readIndex;
-				_readIndex %= MAX_BUF;
+	void StreamThreadBase::releaseInFlightBuffers(const bool all) {
+		const std::size_t held = _heldBuffers.size();
+		if (_inFlight == 0 && held == 0) {
+			return;
+		}
+		// The held buffers were send before the buffers in flight
+		std::size_t released = releaseSentBuffers(held + _inFlight, all);
+		if (released > 0 && held > 0) {
+			const std::size_t done = std::min(released, held);
+			mpegts::PacketBufferPool::BufferVector buffers(_heldBuffers.begin(), _heldBuffers.begin() + done);
+			_heldBuffers.erase(_heldBuffers.begin(), _heldBuffers.begin() + done);
+			_pool->release(buffers);
+			released -= done;
+		}
+		if (released > _inFlight) {
+			released = _inFlight;
+		}
+		const size_t ringSize = _ringSize;
+		const size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+		if (all && released < _inFlight && ringSize != 0) {
+			// The output device may still read from these buffers, so they can
+			// not be filled again. Take them out of the ring until it is done
+			const std::size_t busy = _inFlight - released;
+			const std::size_t numberOfTSPackets = _tsBuffer[0]->getNumberOfTSPackets();
+			mpegts::PacketBufferPool::BufferVector buffers;
+			_pool->allocate(numberOfTSPackets, busy, busy, buffers);
+			const uint32_t ssrc = _stream.getSSRC();
+			const long timestamp = _stream.getTimestamp();
+			for (std::size_t i = 0; i < busy; ++i) {
+				const size_t index = (readIndex + released + i) % ringSize;
+				buffers[i]->initialize(ssrc, timestamp, numberOfTSPackets);
+				_heldBuffers.push_back(_tsBuffer[index]);
+				_tsBuffer[index] = buffers[i];
 			}
+			SI_LOG_DEBUG("Stream: %d, %s holds %zu send buffers until the output device is done with them",
+				_stream.getStreamID(), _protocol.c_str(), _heldBuffers.size());
+			released = _inFlight;
 		}
+		_inFlight -= released;
+		if (ringSize != 0) {
+			_readIndex.store((readIndex + released) % ringSize, std::memory_order_release);
+		}
+	}
+
+	void StreamThreadBase::releaseHeldBuffers() {
+		if (!_heldBuffers.empty()) {
+			_pool->release(_heldBuffers);
+		}
+	}
+
+	std::size_t StreamThreadBase::writeBatchToOutputDevice(mpegts::PacketBuffer *buffer[],
+			const std::size_t count, StreamClient &client) {
+		std::size_t written = 0;
+		while (written < count && writeDataToOutputDevice(*buffer[written], client)) {
+			++written;
+		}
+		return written;
+	}
+
+	void StreamThreadBase::startFanOut() {
+		const std::size_t clients = _stream.getMaxStreamClients();
+		if (_clientBuffer.size() != clients) {
+			_clientBuffer.resize(clients);
+			const uint32_t ssrc = _stream.getSSRC();
+			const long timestamp = _stream.getTimestamp();
+			for (mpegts::PacketBuffer &clientBuffer : _clientBuffer) {
+				clientBuffer.initialize(ssrc, timestamp, _tsBuffer[0]->getNumberOfTSPackets());
+			}
+		}
+		for (mpegts::PacketBuffer &clientBuffer : _clientBuffer) {
+			clientBuffer.reset();
+		}
+		_clientBufferStart.assign(clients, std::chrono::steady_clock::time_point());
+		_sendIndex.assign(clients, _readIndex);
+		_fullView.assign(clients, false);
+		_fanOutIndex = _readIndex;
+		_fanOut = true;
+	}
+
+	void StreamThreadBase::stopFanOut() {
+		flushFilteredBuffers(true);
+		// Continue with the buffer the owner did not send yet
+		_readIndex = _fullView[0] ? _sendIndex[0] : _fanOutIndex;
+		_fanOut = false;
+	}
+
+	bool StreamThreadBase::writeFanOutBuffers() {
+		if (!_fanOut) {
+			startFanOut();
+		}
+		const std::size_t clients = _sendIndex.size();
+
+		// Check which clients get the buffers without filtering, a client that
+		// stops doing so releases the buffers it did not send yet
+		for (std::size_t i = 0; i < clients; ++i) {
+			const StreamClient &client = _stream.getStreamClient(i);
+			const bool fullView = client.isInUse() && client.isFullView();
+			if (fullView != _fullView[i]) {
+				if (_fullView[i]) {
+					for (std::size_t j = _sendIndex[i]; j != _fanOutIndex; j = (j + 1) % _ringSize) {
+						_tsBuffer[j]->releaseReference();
+					}
+				}
+				_sendIndex[i] = _fanOutIndex;
+				_fullView[i] = fullView;
+			}
+		}
+
+		// Fan out the buffers that became ready: the full view clients take
+		// a reference, the other clients get a filtered copy
+		bool progress = false;
+		const size_t publishIndex = _publishIndex.load(std::memory_order_acquire);
+		while (_fanOutIndex != publishIndex) {
+			mpegts::PacketBuffer &buffer = *_tsBuffer[_fanOutIndex];
+			if (!buffer.isSynced()) {
+				SI_LOG_ERROR("Stream: %d, PacketBuffer not in sync!", _stream.getStreamID());
+			}
+			std::size_t references = 0;
+			for (std::size_t i = 0; i < clients; ++i) {
+				const StreamClient &client = _stream.getStreamClient(i);
+				if (_fullView[i]) {
+					++references;
+				} else if (client.isInUse()) {
+					writeFilteredBuffer(buffer, i);
+				} else {
+					_clientBuffer[i].reset();
+				}
+			}
+			buffer.setReferences(references);
+			++_fanOutIndex;
+			_fanOutIndex %= _ringSize;
+			progress = true;
+		}
+		// Low rate PIDs do not fill a buffer soon, so do not let them wait
+		flushFilteredBuffers(false);
+
+		// Send the referenced buffers, each client from its own send cursor
+		for (std::size_t i = 0; i < clients; ++i) {
+			if (!_fullView[i]) {
+				continue;
+			}
+			StreamClient &client = _stream.getStreamClient(i);
+			while (_sendIndex[i] != _fanOutIndex) {
+				mpegts::PacketBuffer &buffer = *_tsBuffer[_sendIndex[i]];
+				if (!writeDataToOutputDevice(buffer, client)) {
+					// try again later
+					++_outputStalls;
+					break;
+				}
+				buffer.releaseReference();
+				++_sendIndex[i];
+				_sendIndex[i] %= _ringSize;
+				progress = true;
+			}
+		}
+
+		// When the ring is (almost) full, a slow client loses its oldest
+		// buffer, so it will not stall the input device and the other clients
+		size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+		const std::size_t used = (_writeIndex.load(std::memory_order_relaxed) + _ringSize - readIndex) % _ringSize;
+		if (used >= _ringSize - 2 && readIndex != _fanOutIndex) {
+			for (std::size_t i = 0; i < clients; ++i) {
+				if (_fullView[i] && _sendIndex[i] == readIndex) {
+					_tsBuffer[readIndex]->releaseReference();
+					++_sendIndex[i];
+					_sendIndex[i] %= _ringSize;
+				}
+			}
+		}
+
+		// Buffers that are send to all clients can be used again
+		while (readIndex != _fanOutIndex && _tsBuffer[readIndex]->getReferences() == 0) {
+			readIndex = (readIndex + 1) % _ringSize;
+		}
+		_readIndex.store(readIndex, std::memory_order_release);
+		return progress;
+	}
+
+	void StreamThreadBase::writeFilteredBuffer(mpegts::PacketBuffer &buffer, const std::size_t clientID) {
+		const mpegts::PidFilter &filter = _stream.getStreamClient(clientID).getPidFilter();
+		mpegts::PacketBuffer &clientBuffer = _clientBuffer[clientID];
+		mpegts::TSPacketHeader header[mpegts::PacketBuffer::MAX_NUMBER_OF_TS_PACKETS];
+		const std::size_t size = buffer.getNumberOfTSPackets();
+		mpegts::TSHeaderParser::parse(buffer.getTSReadBufferPtr(), size, header);
+		for (std::size_t i = 0; i < size; ++i) {
+			if (!header[i].isSynced() || !filter.isSet(header[i].pid)) {
+				continue;
+			}
+			// A full buffer is still there when the client could not take it
+			if (clientBuffer.full() && !flushFilteredBuffer(clientID)) {
+				continue;
+			}
+			if (clientBuffer.empty()) {
+				_clientBufferStart[clientID] = std::chrono::steady_clock::now();
+			}
+			std::memcpy(clientBuffer.getWriteBufferPtr(), buffer.getTSPacketPtr(i),
+				mpegts::PacketBuffer::TS_PACKET_SIZE);
+			clientBuffer.addAmountOfBytesWritten(mpegts::PacketBuffer::TS_PACKET_SIZE);
+			if (clientBuffer.full()) {
+				flushFilteredBuffer(clientID);
+			}
+		}
+	}
+
+	bool StreamThreadBase::flushFilteredBuffer(const std::size_t clientID) {
+		mpegts::PacketBuffer &clientBuffer = _clientBuffer[clientID];
+		if (clientBuffer.empty()) {
+			return true;
+		}
+		// The output devices send whole buffers
+		clientBuffer.fillUpWithNullPackets();
+		if (!writeDataToOutputDevice(clientBuffer, _stream.getStreamClient(clientID))) {
+			// try again later
+			++_outputStalls;
+			return false;
+		}
+		clientBuffer.reset();
+		return true;
+	}
+
+	void StreamThreadBase::flushFilteredBuffers(const bool all) {
+		if (!_fanOut) {
+			return;
+		}
+		std::chrono::milliseconds maxAge = getOutputBatchLatency();
+		if (maxAge < FILTERED_BUFFER_MAX_AGE) {
+			maxAge = FILTERED_BUFFER_MAX_AGE;
+		}
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < _clientBuffer.size(); ++i) {
+			if (!_fullView[i] && !_clientBuffer[i].empty() && _stream.getStreamClient(i).isInUse() &&
+			    (all || now - _clientBufferStart[i] >= maxAge)) {
+				flushFilteredBuffer(i);
+			}
+		}
+	}
+
+	void StreamThreadBase::readDataFromInputDevice(StreamClient &client) {
+		const input::SpDevice inputDevice = _stream.getInputDevice();
+		if (inputDevice->isDataAvailable()) {
+			if (!readInputDevice(*inputDevice) && _outputThread != nullptr) {
+				// Ring is full, wait until the output thread did send some
+				std::unique_lock<std::mutex> lock(_outputMutex);
+				_ringSpaceWaiting = true;
+				_ringSpace.wait_for(lock, std::chrono::milliseconds(10), [this] {
+					return _state != State::Running || !running() || !isRingFull();
+				});
+				_ringSpaceWaiting = false;
+			}
+		}
+		if (_outputThread != nullptr) {
+			return;
+		}
+
+		writePacedBuffers(client);
 	}
 
 } // namespace output
@@ -22,19 +22,34 @@
 
 #include <FwDecl.h>
 #include <base/ThreadBase.h>
+#include <mpegts/Filter.h>
 #include <mpegts/PacketBuffer.h>
+#include <mpegts/PacketBufferPool.h>
+#include <output/SendPacer.h>
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 FW_DECL_NS0(StreamClient);
+FW_DECL_NS1(base, Thread);
 FW_DECL_NS0(StreamInterface);
+FW_DECL_NS1(input, Device);
+FW_DECL_SP_NS1(input, InputReactor);
 
 FW_DECL_UP_NS1(output, StreamThreadBase);
 
 namespace output {
 
-	/// Streaming thread
+	/// Streaming thread. The input device fills the buffers of a ring, which
+	/// are send from the same thread, or from a separate output thread when
+	/// the stream is split into two stages. The ring is a single-producer /
+	/// single-consumer ring: the input stage owns the write index and publishes
+	/// the buffers that are ready to send, the output stage owns the read index
 	class StreamThreadBase :
 		public base::ThreadBase {
 		public:
@@ -58,6 +73,9 @@ namespace output {
 			/// @see ThreadBase
 			virtual void threadEntry() override {}
 
+			/// @see ThreadBase
+			virtual void wakeUpThread() override;
+
 			// =======================================================================
 			//  -- Other member functions --------------------------------------------
 			// =======================================================================
@@ -76,30 +94,229 @@ namespace output {
 			/// @return true if stream is restarted else false on error
 			virtual bool restartStreaming(int clientID);
 
+			/// Add the occupancy and stall counters of both stages to @a xml
+			virtual void addToXML(std::string &xml) const;
+
 		protected:
 
+			enum class State {
+				Running,
+				Pause,
+				Paused,
+			};
+
+			/// Stop the streaming thread, or stop being called by the input reactor.
+			/// Should be called from the destructor of the derived class
+			void terminateStreaming();
+
+			/// Set the new state and wake up the ones waiting on a state change
+			void setState(State state);
+
+			/// Called from the streaming thread in the Paused state, it will
+			/// return when the state changed or the thread should stop
+			void waitWhilePaused();
+
 			/// This function will read data from the input device
 			/// @param client specifies were it should be sended to
 			virtual void readDataFromInputDevice(StreamClient &client);
 
+			/// Check if this stream is running in its own thread or is
+			/// called from the input reactor
+			bool isStreaming() const {
+				return running() || _reactorFD != -1;
+			}
+
 			/// send the TS packets to an output device
 			virtual bool writeDataToOutputDevice(mpegts::PacketBuffer &buffer,
 				StreamClient &client) = 0;
 
+			/// Send @a count buffers to the output device, with as few syscalls as
+			/// possible. The default sends them one by one
+			/// @return the amount of buffers send, the others are tried again later
+			virtual std::size_t writeBatchToOutputDevice(mpegts::PacketBuffer *buffer[],
+				std::size_t count, StreamClient &client);
+
+			/// Get the maximum amount of buffers that may be send with one call
+			/// of @c writeBatchToOutputDevice, 1 means no batching
+			virtual std::size_t getOutputBatchSize() const {
+				return 1;
+			}
+
+			/// Get the time ready buffers may wait to fill up a batch
+			virtual std::chrono::milliseconds getOutputBatchLatency() const {
+				return std::chrono::milliseconds(0);
+			}
+
+			/// Check how many of the @a inFlight oldest buffers, that were send
+			/// but may still be used by the output device (like with zero copy
+			/// sends), can be used again. The default is done with them at once
+			/// @param all specifies that the ring is reset or given back, the
+			/// buffers the output device is not done with are taken out of the
+			/// ring then, and are asked for again with the later calls
+			/// @return the amount of buffers that can be used again, in order
+			virtual std::size_t releaseSentBuffers(std::size_t inFlight, bool all) {
+				(void)all;
+				return inFlight;
+			}
+
+			/// Account one send syscall that did send @a packets packets
+			void addSendStatistics(std::size_t packets) {
+				++_sendCalls;
+				_sendPackets += packets;
+			}
+
 			///
 			virtual int getStreamSocketPort(int clientID) const = 0;
 
+			/// Check if sending should be paced, for TCP outputs the kernel
+			/// does the flow control
+			virtual bool isPacingNeeded() const {
+				return true;
+			}
+
+		private:
+
+			/// Try to let the input reactor call us when there is input data
+			/// @return true if the reactor is used, false if we need our own thread
+			bool addToInputReactor();
+
+			/// Stop being called by the input reactor
+			void removeFromInputReactor();
+
+			/// Called from an input reactor worker when the input device is readable
+			/// @return the time the reactor should not watch the input device,
+			/// because the ring is full
+			std::chrono::microseconds inputDeviceReady();
+
+			/// Let the input reactor watch the input device again, when it waits
+			/// on a full ring and the output stage did send some buffers
+			void resumeInput();
+
+			/// Read into the current write buffer of the ring
+			/// @return true if some data was read from the input device
+			bool readInputDevice(input::Device &inputDevice);
+
+			/// Get the lowest PID priority that should be kept, with the
+			/// congestion drop threshold and the amount of buffers used
+			mpegts::Filter::Priority getLowestKeptPriority(size_t ringSize, size_t used) const;
+
+			/// Remove the null packets and the packets with a priority below
+			/// @a lowestKept from the full @a buffer, by moving the other packets
+			/// to the front
+			/// @return true if the buffer is still full
+			bool dropTSPackets(const mpegts::Filter &filter, mpegts::PacketBuffer &buffer,
+				bool stripNull, mpegts::Filter::Priority lowestKept);
+
+			/// Publish the buffers that are ready to send (decrypted) to the
+			/// output stage, in order
+			void publishReadyBuffers();
+
+			/// When buffers are held back by a partial decrypt batch, let the
+			/// decrypt device flush it if it waited too long
+			void flushDecryptBatch();
+
+			/// Start the output thread, when this stream should be split
+			void startOutputStage();
+
+			/// Stop the output thread, if running
+			void stopOutputStage();
+
+			/// Thread execute function of the output thread
+			bool outputStage();
+
+			/// Take the buffers of the ring from the packet buffer pool, with
+			/// the amount of TS packets of this output type. The depth of the
+			/// ring follows the stalls and occupancy of the previous run.
+			/// Both stages should be stopped
+			void acquireRing();
+
+			/// Give the buffers of the ring back to the packet buffer pool,
+			/// both stages should be stopped
+			void releaseRing();
+
+			/// Reset the ring, both stages should be stopped
+			void resetRing();
+
+			/// Send the buffer at the read index, if it is ready to be send
+			/// @return true if the buffer was send
+			bool writeReadyBuffer(StreamClient &client);
+
+			/// Send the ready buffers, as far as the pacer allows
+			/// @return true if some buffer was send
+			bool writePacedBuffers(StreamClient &client);
+
+			/// Send one batch of ready buffers, as far as the pacer allows. When
+			/// less than @a batchSize buffers are ready, wait for more until the
+			/// batch latency passed
+			/// @return true if some buffer was send
+			bool writeBatchedBuffers(StreamClient &client, std::size_t batchSize);
+
+			/// Move the read index over the buffers in flight that the output
+			/// device is done with, see @c releaseSentBuffers. With @a all the
+			/// buffers it still uses are replaced in the ring by new ones
+			void releaseInFlightBuffers(bool all);
+
+			/// Give the held buffers back to the pool, even when the output
+			/// device may still use them
+			void releaseHeldBuffers();
+
+			/// Wake the input and output stage from their waits on the ring,
+			/// so they see a state change at once
+			void notifyStageWaits();
+
+			/// Check if the input stage can not read into the ring, because
+			/// it is full
+			bool isRingFull() const {
+				const size_t ringSize = _ringSize;
+				return ringSize != 0 && ((_writeIndex + ringSize - _readIndex) % ringSize) + 1 >= ringSize;
+			}
+
+			/// Get the amount of buffers published, but not send yet
+			size_t getBacklog() const {
+				const size_t ringSize = _ringSize;
+				return (ringSize == 0) ? 0 : (_publishIndex + ringSize - _readIndex) % ringSize;
+			}
+
+			/// Start sending the ring buffers to more clients, when the stream
+			/// becomes shared
+			void startFanOut();
+
+			/// Stop sending the ring buffers to more clients, the owner is
+			/// the only client again
+			void stopFanOut();
+
+			/// Send the ready ring buffers to all clients of a shared stream.
+			/// Clients with a full view get the same buffers (without copying),
+			/// each with its own send cursor into the ring. Buffers are used
+			/// again after all these clients did send them
+			/// @return true if some buffer was fanned out or send
+			bool writeFanOutBuffers();
+
+			/// Copy the TS packets of @a buffer with a PID requested by client
+			/// @a clientID into its filtered buffer, and send it when it is full.
+			/// When the client can not take a full buffer, its new packets are
+			/// dropped
+			void writeFilteredBuffer(mpegts::PacketBuffer &buffer, std::size_t clientID);
+
+			/// Send the filtered buffer of client @a clientID, also when it is
+			/// only partly filled
+			/// @return true if the buffer was send or empty
+			bool flushFilteredBuffer(std::size_t clientID);
+
+			/// Send the partly filled buffers of the filtered clients, of all of
+			/// them with @a all, or else the ones older than the batch latency
+			void flushFilteredBuffers(bool all);
+
 			// =======================================================================
 			// -- Data members -------------------------------------------------------
 			// =======================================================================
 
-		protected:
+		public:
 
-			enum class State {
-				Running,
-				Pause,
-				Paused,
-			};
+			/// Maximum amount of buffers send with one @c writeBatchToOutputDevice
+			static constexpr std::size_t MAX_OUTPUT_BATCH = 64;
+
+		protected:
 
 			StreamInterface &_stream;
 			std::string _protocol;
@@ -107,13 +324,56 @@ namespace output {
 
 		private:
 
-			static constexpr size_t MAX_BUF = 100;
-			mpegts::PacketBuffer _tsBuffer[MAX_BUF];
-			size_t _writeIndex;
-			size_t _readIndex;
-			unsigned long _sendInterval;
-			std::chrono::steady_clock::time_point _t1;
-			std::chrono::steady_clock::time_point _t2;
+			static constexpr size_t MIN_RING_SIZE = 32;
+			/// Time a partly filled buffer of a filtered client may wait, when
+			/// the batch latency is shorter
+			static constexpr std::chrono::milliseconds FILTERED_BUFFER_MAX_AGE{50};
+			static constexpr size_t DEFAULT_RING_SIZE = 100;
+			static constexpr size_t MAX_RING_SIZE = 800;
+			mpegts::PacketBufferPool::BufferVector _tsBuffer; /// the ring, borrowed from the pool
+			std::atomic<size_t> _writeIndex;      /// input stage: buffer being filled
+			std::atomic<size_t> _publishIndex;    /// input stage: first buffer not ready to send
+			std::atomic<size_t> _readIndex;       /// output stage: first buffer not send
+			mpegts::SpPacketBufferPool _pool;
+			std::atomic<size_t> _ringSize;        /// 0 when the ring is given back
+			size_t _wantedRingSize;               /// grows when the input stalled
+			uint64_t _inputStallsAtAcquire;
+			SendPacer _pacer;
+			input::SpInputReactor _reactor;
+			std::atomic<int> _reactorFD;
+			std::atomic<bool> _inputWaiting;      /// reactor does not watch the input, the ring is full
+			bool _fanOut;                         /// ring buffers are send to more clients
+			size_t _fanOutIndex;                  /// next ring buffer to fan out
+			std::vector<size_t> _sendIndex;       /// send cursor of each client into the ring
+			std::vector<bool> _fullView;          /// clients that send the ring buffers
+			std::vector<mpegts::PacketBuffer> _clientBuffer; /// filtered buffer of each client
+			std::vector<std::chrono::steady_clock::time_point> _clientBufferStart; /// first packet in the filtered buffer
+			std::unique_ptr<base::Thread> _outputThread;   /// running when split in two stages
+			std::atomic<bool> _outputWaiting;     /// output thread waits on published buffers
+			std::mutex _outputMutex;
+			std::condition_variable _outputReady; /// buffers published or state changed
+			std::atomic<bool> _ringSpaceWaiting;  /// input thread waits on a full ring
+			std::condition_variable _ringSpace;   /// output stage freed ring buffers or state changed
+			std::atomic<size_t> _inputOccupancyMax;
+			std::atomic<size_t> _outputOccupancyMax;
+			std::atomic<uint64_t> _inputStalls;   /// ring was full, input could not be read
+			std::atomic<uint64_t> _outputStalls;  /// output device did not take the buffer
+			std::atomic<uint64_t> _outputStarved; /// output thread waited on the input stage
+			std::atomic<uint64_t> _nullPacketsStripped;
+			std::atomic<uint64_t> _congestionDroppedMedium; /// audio packets dropped
+			std::atomic<uint64_t> _congestionDroppedLow;    /// other packets dropped
+			std::mutex _stateMutex;
+			std::condition_variable _stateChanged;
+			std::chrono::steady_clock::time_point _pauseStart;
+			std::atomic<uint64_t> _pauseTime;          /// us until the last pause was done
+			std::atomic<uint64_t> _pauseToRestart;     /// us from the last pause until restarted
+			std::atomic<uint64_t> _pauseToRestartMax;
+			bool _batchWaiting;                   /// waiting for a batch to fill up
+			std::chrono::steady_clock::time_point _batchWaitStart;
+			std::atomic<uint64_t> _sendCalls;     /// send syscalls done by the output device
+			std::atomic<uint64_t> _sendPackets;   /// packets send with these syscalls
+			std::size_t _inFlight;                /// send buffers after the read index, still used by the output device
+			mpegts::PacketBufferPool::BufferVector _heldBuffers; /// send buffers taken out of the ring, oldest first, still used by the output device
 
 	};
 
@@ -25,18 +25,29 @@
 #include <StreamClient.h>
 #include <base/TimeCounter.h>
 
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 namespace output {
 
+	/// Time the kernel gets to complete the MSG_ZEROCOPY sends, before the
+	/// buffers it still uses are taken out of the ring
+	static const std::size_t ZEROCOPY_COMPLETION_WAIT_MS = 100;
+
 	StreamThreadHttp::StreamThreadHttp(
 		StreamInterface &stream) :
 		StreamThreadBase("HTTP", stream),
-		_clientID(0) {}
+		_clientID(0),
+		_zeroCopyBuffers(0),
+		_zeroCopyID(0),
+		_zeroCopySupported(false),
+		_zeroCopySends(0),
+		_zeroCopyCopied(0) {}
 
 	StreamThreadHttp::~StreamThreadHttp() {
-		terminateThread();
+		terminateStreaming();
 		const int streamID = _stream.getStreamID();
 		StreamClient &client = _stream.getStreamClient(_clientID);
 		SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID, _protocol.c_str(),
@@ -54,24 +65,51 @@ namespace output {
 
 //		client.setSocketTimeoutInSec(2);
 
+		// A new connection counts its MSG_ZEROCOPY sends from 0. The buffers
+		// still held for the sends on the old, closed, one are released then
+		_zeroCopySupported = client.setHttpZeroCopy();
+		_zeroCopySend.clear();
+		_zeroCopyBuffers = 0;
+		_zeroCopyID = 0;
+		_zeroCopySends = 0;
+		_zeroCopyCopied = 0;
+		SI_LOG_COND_DEBUG(!_zeroCopySupported, "Stream: %d, %s zero copy (SO_ZEROCOPY) not supported",
+			streamID, _protocol.c_str());
+
 		StreamThreadBase::startStreaming();
 		return true;
 	}
 
+	void StreamThreadHttp::addToXML(std::string &xml) const {
+		StreamThreadBase::addToXML(xml);
+		if (!_stream.isHttpZeroCopy()) {
+			ADD_XML_ELEMENT(xml, "httpZeroCopyStatus", "Off");
+		} else {
+			ADD_XML_ELEMENT(xml, "httpZeroCopyStatus", _zeroCopySupported ? "Active" : "Not supported (writev)");
+		}
+		ADD_XML_ELEMENT(xml, "httpZeroCopySends", _zeroCopySends.load());
+		ADD_XML_ELEMENT(xml, "httpZeroCopyCopied", _zeroCopyCopied.load());
+	}
+
 	int StreamThreadHttp::getStreamSocketPort(int clientID) const {
 		return _stream.getStreamClient(clientID).getHttpSocketPort();
 	}
 
+	bool StreamThreadHttp::isPacingNeeded() const {
+		// TCP, so the kernel does the flow control
+		return false;
+	}
+
 	void StreamThreadHttp::threadEntry() {
 		StreamClient &client = _stream.getStreamClient(0);
 		while (running()) {
 			switch (_state) {
 			case State::Pause:
-				_state = State::Paused;
+				setState(State::Paused);
 				break;
 			case State::Paused:
-				// Do nothing here, just wait
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				// Do nothing here, just wait until restarted or stopped
+				waitWhilePaused();
 				break;
 			case State::Running:
 				readDataFromInputDevice(client);
@@ -99,14 +137,131 @@ namespace output {
 		iov[0].iov_len = size;
 
 		// send the HTTP packet
-		if (!client.writeHttpData(iov, 1)) {
-			if (!client.isSelfDestructing()) {
-				SI_LOG_ERROR("Stream: %d, Error sending HTTP Stream Data to %s", _stream.getStreamID(),
-					client.getIPAddressOfStream().c_str());
-				client.selfDestruct();
-			}
+		if (client.writeHttpData(iov, 1)) {
+			addSendStatistics(1);
+		} else if (!client.isSelfDestructing()) {
+			SI_LOG_ERROR("Stream: %d, Error sending HTTP Stream Data to %s", _stream.getStreamID(),
+				client.getIPAddressOfStream().c_str());
+			client.selfDestruct();
 		}
 		return true;
 	}
 
+	std::size_t StreamThreadHttp::getOutputBatchSize() const {
+		return _stream.getHttpBatchSize();
+	}
+
+	std::size_t StreamThreadHttp::writeBatchToOutputDevice(mpegts::PacketBuffer *buffer[],
+			const std::size_t count, StreamClient &client) {
+		const long timestamp = base::TimeCounter::getTicks() * 90;
+		for (std::size_t i = 0; i < count; ++i) {
+			const unsigned int size = buffer[i]->getBufferSize();
+			_iov[i].iov_base = buffer[i]->getTSReadBufferPtr();
+			_iov[i].iov_len  = size;
+
+			// RTP packet octet count (Bytes)
+			_stream.addRtpData(size, timestamp);
+		}
+
+		// send all buffers with one call, the socket is blocking so normally
+		// all is send at once. Like with one buffer they are not send again
+		// when it fails, so all buffers are done
+		bool zeroCopy = _zeroCopySupported && _stream.isHttpZeroCopy();
+		bool lastZeroCopy = false;
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov    = _iov;
+		msg.msg_iovlen = count;
+		while (msg.msg_iovlen > 0) {
+			const ssize_t sent = client.sendHttpMessage(&msg, zeroCopy ? MSG_ZEROCOPY : 0);
+			if (sent == -1 && errno == EINTR) {
+				continue;
+			} else if (sent == -1 && zeroCopy && errno == ENOBUFS) {
+				// No memory to pin more pages now, copy this one
+				zeroCopy = false;
+				continue;
+			} else if (sent <= 0) {
+				if (!client.isSelfDestructing()) {
+					SI_LOG_ERROR("Stream: %d, Error sending HTTP Stream Data to %s", _stream.getStreamID(),
+						client.getIPAddressOfStream().c_str());
+					client.selfDestruct();
+				}
+				break;
+			}
+			addSendStatistics(msg.msg_iovlen);
+			lastZeroCopy = zeroCopy;
+			if (zeroCopy) {
+				_zeroCopySend.push_back({_zeroCopyID++, 0, false});
+				++_zeroCopySends;
+			}
+			// skip what is send, a partial send continues with the rest
+			std::size_t done = sent;
+			while (msg.msg_iovlen > 0 && done >= msg.msg_iov->iov_len) {
+				done -= msg.msg_iov->iov_len;
+				++msg.msg_iov;
+				--msg.msg_iovlen;
+			}
+			if (msg.msg_iovlen > 0) {
+				msg.msg_iov->iov_base = static_cast<unsigned char *>(msg.msg_iov->iov_base) + done;
+				msg.msg_iov->iov_len -= done;
+			}
+		}
+
+		// The kernel may read from the buffers until the last send is done.
+		// Copied buffers are done at once, unless older sends are still busy
+		if (lastZeroCopy) {
+			_zeroCopySend.back().buffers = count;
+			_zeroCopyBuffers += count;
+		} else if (!_zeroCopySend.empty()) {
+			_zeroCopySend.push_back({0, count, true});
+			_zeroCopyBuffers += count;
+		}
+		return count;
+	}
+
+	std::size_t StreamThreadHttp::releaseSentBuffers(const std::size_t inFlight, const bool all) {
+		if (!_zeroCopySend.empty()) {
+			StreamClient &client = _stream.getStreamClient(_clientID);
+			readZeroCopyCompletions(client);
+			if (all) {
+				// Give the kernel a little time, the buffers of the sends that
+				// are not completed then are held until they are
+				for (std::size_t i = 0; !_zeroCopySend.empty() && i < ZEROCOPY_COMPLETION_WAIT_MS; ++i) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					readZeroCopyCompletions(client);
+				}
+				SI_LOG_COND_DEBUG(!_zeroCopySend.empty(), "Stream: %d, %s %zu zero copy sends not completed",
+					_stream.getStreamID(), _protocol.c_str(), _zeroCopySend.size());
+			}
+		}
+		// The buffers of the sends that are not done are the newest ones
+		return (inFlight > _zeroCopyBuffers) ? (inFlight - _zeroCopyBuffers) : 0;
+	}
+
+	void StreamThreadHttp::readZeroCopyCompletions(StreamClient &client) {
+		uint32_t lo;
+		uint32_t hi;
+		bool copied;
+		while (client.readHttpZeroCopyCompletion(lo, hi, copied)) {
+			if (copied) {
+				_zeroCopyCopied += hi - lo + 1;
+			}
+			// A completion of a send we did not count means the connection
+			// was used before, then count from there and forget the others
+			const bool resync = (hi - _zeroCopyID) < 0x80000000u;
+			if (resync) {
+				_zeroCopyID = hi + 1;
+			}
+			for (ZeroCopySend &send : _zeroCopySend) {
+				if (resync || (send.id - lo) <= (hi - lo)) {
+					send.done = true;
+				}
+			}
+		}
+		while (!_zeroCopySend.empty() && _zeroCopySend.front().done) {
+			_zeroCopyBuffers -= _zeroCopySend.front().buffers;
+			_zeroCopySend.pop_front();
+		}
+	}
+
 } // namespace output
@@ -23,6 +23,12 @@
 #include <FwDecl.h>
 #include <output/StreamThreadBase.h>
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+
+#include <sys/uio.h>
+
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
 
@@ -57,15 +63,55 @@ namespace output {
 				mpegts::PacketBuffer &buffer,
 				StreamClient &client) override;
 
+			virtual std::size_t writeBatchToOutputDevice(
+				mpegts::PacketBuffer *buffer[],
+				std::size_t count,
+				StreamClient &client) override;
+
+			virtual std::size_t getOutputBatchSize() const override;
+
+			virtual std::size_t releaseSentBuffers(std::size_t inFlight, bool all) override;
+
 			virtual int getStreamSocketPort(int clientID) const override;
 
+			virtual bool isPacingNeeded() const override;
+
+		public:
+
+			virtual void addToXML(std::string &xml) const override;
+
+			// =======================================================================
+			//  -- Other member functions --------------------------------------------
+			// =======================================================================
+
+		private:
+
+			/// Read the completion notifications of the MSG_ZEROCOPY sends, and
+			/// forget the sends the kernel is done with
+			void readZeroCopyCompletions(StreamClient &client);
+
 			// =======================================================================
 			// -- Data members -------------------------------------------------------
 			// =======================================================================
 
 		private:
 
+			/// A MSG_ZEROCOPY send, with the ring buffers the kernel may still
+			/// read from until it is done
+			struct ZeroCopySend {
+				uint32_t id;            /// counts the MSG_ZEROCOPY sends on the socket
+				std::size_t buffers;    /// buffers that are done with this send
+				bool done;
+			};
+
 			int _clientID;
+			struct iovec _iov[MAX_OUTPUT_BATCH];
+			std::deque<ZeroCopySend> _zeroCopySend;   /// sends, oldest first, the kernel is not done with
+			std::size_t _zeroCopyBuffers;             /// buffers of these sends
+			uint32_t _zeroCopyID;                     /// id of the next MSG_ZEROCOPY send
+			std::atomic<bool> _zeroCopySupported;     /// SO_ZEROCOPY could be set on the socket
+			std::atomic<uint64_t> _zeroCopySends;
+			std::atomic<uint64_t> _zeroCopyCopied;    /// sends the kernel did copy after all
 	};
 
 } // namespace output
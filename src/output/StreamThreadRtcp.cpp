@@ -48,6 +48,9 @@ bool StreamThreadRtcp::startStreaming() {
 	if (!rtcp.setupSocketHandle(SOCK_DGRAM, IPPROTO_UDP)) {
 		SI_LOG_ERROR("Stream: %d, Get RTCP handle failed", _stream.getStreamID());
 	}
+	if (_stream.isMulticast()) {
+		rtcp.setMulticastOptions(_stream.getMulticastTTL(), _stream.getMulticastInterface());
+	}
 
 	if (!_thread.startThread()) {
 		SI_LOG_ERROR("Stream: %d, Start RTCP/UDP stream to %s:%d ERROR", _stream.getStreamID(),
@@ -80,8 +83,6 @@ bool StreamThreadRtcp::restartStreaming(int clientID) {
 }
 
 bool StreamThreadRtcp::threadExecuteFunction() {
-	StreamClient &client = _stream.getStreamClient(_clientID);
-
 	// check do we need to update Device monitor signals
 	if (_mon_update == 0) {
 		_stream.getInputDevice()->monitorSignal(false);
@@ -107,11 +108,26 @@ bool StreamThreadRtcp::threadExecuteFunction() {
 		std::memcpy(data + srlen, sdes, sdeslen);
 		std::memcpy(data + srlen + sdeslen, app, applen);
 
-		// send the RTCP/UDP packet
-		SocketAttr &rtcp = client.getRtcpSocketAttr();
-		if (!rtcp.sendDataTo(data, len, 0)) {
-			SI_LOG_ERROR("Stream: %d, Error sending RTCP/UDP data to %s:%d", _stream.getStreamID(),
-						 rtcp.getIPAddressOfSocket().c_str(), rtcp.getSocketPort());
+		// send the RTCP/UDP packet to all clients of this stream. With RTSP
+		// multicast the joined clients receive the group of client 0, so send
+		// one report for the SSRC of the RTP stream only
+		const std::size_t clients = _stream.isMulticast() ? 1 : _stream.getMaxStreamClients();
+		for (std::size_t i = 0; i < clients; ++i) {
+			StreamClient &client = _stream.getStreamClient(i);
+			if (!client.isInUse()) {
+				continue;
+			}
+			setSSRC(data, client.getSSRC());
+			setSSRC(data + srlen, client.getSSRC());
+			setSSRC(data + srlen + sdeslen, client.getSSRC());
+			SocketAttr &rtcp = client.getRtcpSocketAttr();
+			if (rtcp.getFD() == -1) {
+				rtcp.setupSocketHandle(SOCK_DGRAM, IPPROTO_UDP);
+			}
+			if (!rtcp.sendDataTo(data, len, 0)) {
+				SI_LOG_ERROR("Stream: %d, Error sending RTCP/UDP data to %s:%d", _stream.getStreamID(),
+							 rtcp.getIPAddressOfSocket().c_str(), rtcp.getSocketPort());
+			}
 		}
 	}
 	DELETE_ARRAY(sr);
@@ -34,6 +34,13 @@ StreamThreadRtcpBase::StreamThreadRtcpBase(StreamInterface &stream) :
 
 StreamThreadRtcpBase::~StreamThreadRtcpBase() {}
 
+void StreamThreadRtcpBase::setSSRC(uint8_t *packet, const uint32_t ssrc) {
+	packet[4] = (ssrc >> 24) & 0xff; // synchronization source
+	packet[5] = (ssrc >> 16) & 0xff; // synchronization source
+	packet[6] = (ssrc >>  8) & 0xff; // synchronization source
+	packet[7] = (ssrc >>  0) & 0xff; // synchronization source
+}
+
 uint8_t *StreamThreadRtcpBase::get_app_packet(std::size_t *len) {
 	uint8_t app[1024 * 2];
 
@@ -70,6 +70,10 @@ class StreamThreadRtcpBase {
 		uint8_t *get_sdes_packet(std::size_t *len);
 		uint8_t *get_sr_packet(std::size_t *len);
 
+		/// Set the synchronisation source of the RTCP packet in @a packet,
+		/// so each client gets its own SSRC
+		static void setSSRC(uint8_t *packet, uint32_t ssrc);
+
 		// =====================================================================
 		//  -- Data members ----------------------------------------------------
 		// =====================================================================
@@ -78,8 +78,6 @@ bool StreamThreadRtcpTcp::restartStreaming(int UNUSED(clientID)) {
 }
 
 bool StreamThreadRtcpTcp::threadExecuteFunction() {
-	StreamClient &client = _stream.getStreamClient(_clientID);
-
 	// check do we need to update Device monitor signals
 	if (_mon_update == 0) {
 		_stream.getInputDevice()->monitorSignal(false);
@@ -115,10 +113,19 @@ bool StreamThreadRtcpTcp::threadExecuteFunction() {
 		iov[3].iov_base = app;
 		iov[3].iov_len = applen;
 
-		// send the RTCP/TCP packet
-		if (!client.writeHttpData(iov, 4)) {
-			SI_LOG_ERROR("Stream: %d, Error sending RTCP/TCP Stream Data to %s", _stream.getStreamID(),
-				client.getIPAddressOfStream().c_str());
+		// send the RTCP/TCP packet to all clients of this stream
+		for (std::size_t i = 0; i < _stream.getMaxStreamClients(); ++i) {
+			StreamClient &client = _stream.getStreamClient(i);
+			if (!client.isInUse()) {
+				continue;
+			}
+			setSSRC(sr, client.getSSRC());
+			setSSRC(sdes, client.getSSRC());
+			setSSRC(app, client.getSSRC());
+			if (!client.writeHttpData(iov, 4)) {
+				SI_LOG_ERROR("Stream: %d, Error sending RTCP/TCP Stream Data to %s", _stream.getStreamID(),
+					client.getIPAddressOfStream().c_str());
+			}
 		}
 	}
 	DELETE_ARRAY(sr);
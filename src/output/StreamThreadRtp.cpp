@@ -24,21 +24,31 @@
 #include <StreamInterface.h>
 #include <InterfaceAttr.h>
 #include <base/TimeCounter.h>
+#include <socket/SocketAttr.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 namespace output {
 
+	/// Maximum amount of segments the kernel splits one message in
+	static const std::size_t UDP_MAX_SEGMENTS = 64;
+	/// Maximum UDP payload of one message (IPv4)
+	static const std::size_t UDP_MAX_PAYLOAD = 65507;
+
 	StreamThreadRtp::StreamThreadRtp(StreamInterface &stream) :
 		StreamThreadBase("RTP/UDP", stream),
 		_clientID(0),
-		_cseq(0),
-		_rtcp(stream) {
+		_rtcp(stream),
+		_gsoSupported(false),
+		_gsoSends(0) {
 	}
 
 	StreamThreadRtp::~StreamThreadRtp() {
-		terminateThread();
+		terminateStreaming();
 		const int streamID = _stream.getStreamID();
 		StreamClient &client = _stream.getStreamClient(_clientID);
 		SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID, _protocol.c_str(),
@@ -55,15 +65,24 @@ namespace output {
 			SI_LOG_ERROR("Stream: %d, Get RTP handle failed", streamID);
 		}
 
+		if (_stream.isMulticast()) {
+			rtp.setMulticastOptions(_stream.getMulticastTTL(), _stream.getMulticastInterface());
+		}
+
 		// Get default buffer size and set it x times as big
 		const int bufferSize = rtp.getNetworkSendBufferSize() * 20;
 		rtp.setNetworkSendBufferSize(bufferSize);
 		SI_LOG_INFO("Stream: %d, %s set network buffer size: %d KBytes", streamID, _protocol.c_str(), bufferSize / 1024);
 
+		_gsoSupported = rtp.isUdpSegmentationSupported();
+		_gsoSends = 0;
+		SI_LOG_COND_DEBUG(!_gsoSupported, "Stream: %d, %s UDP segmentation offload not supported",
+			streamID, _protocol.c_str());
+
 		// RTCP
 		_rtcp.startStreaming();
 
-		_cseq = 0x0000;
+		_stream.getStreamClient(_clientID).resetRtpSequenceNumber();
 		return StreamThreadBase::startStreaming();
 	}
 
@@ -81,6 +100,16 @@ namespace output {
 		return StreamThreadBase::restartStreaming(clientID);
 	}
 
+	void StreamThreadRtp::addToXML(std::string &xml) const {
+		StreamThreadBase::addToXML(xml);
+		if (!_stream.isRtpSegmentationOffload()) {
+			ADD_XML_ELEMENT(xml, "rtpGsoStatus", "Off");
+		} else {
+			ADD_XML_ELEMENT(xml, "rtpGsoStatus", _gsoSupported ? "Active" : "Not supported (sendmmsg)");
+		}
+		ADD_XML_ELEMENT(xml, "rtpGsoSends", _gsoSends.load());
+	}
+
 	int StreamThreadRtp::getStreamSocketPort(int clientID) const {
 		return  _stream.getStreamClient(clientID).getRtpSocketAttr().getSocketPort();
 	}
@@ -90,11 +119,11 @@ namespace output {
 		while (running()) {
 			switch (_state) {
 				case State::Pause:
-					_state = State::Paused;
+					setState(State::Paused);
 					break;
 				case State::Paused:
-					// Do nothing here, just wait
-					std::this_thread::sleep_for(std::chrono::milliseconds(50));
+					// Do nothing here, just wait until restarted or stopped
+					waitWhilePaused();
 					break;
 				case State::Running:
 					readDataFromInputDevice(client);
@@ -107,13 +136,21 @@ namespace output {
 		}
 	}
 
-	bool StreamThreadRtp::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &client) {
+	std::size_t StreamThreadRtp::getOutputBatchSize() const {
+		return _stream.getRtpBatchSize();
+	}
+
+	std::chrono::milliseconds StreamThreadRtp::getOutputBatchLatency() const {
+		return std::chrono::milliseconds(_stream.getRtpBatchLatency());
+	}
+
+	void StreamThreadRtp::writeRtpHeader(mpegts::PacketBuffer &buffer, StreamClient &client) {
 		unsigned char *rtpBuffer = buffer.getReadBufferPtr();
 
 		// update sequence number
-		++_cseq;
-		rtpBuffer[2] = ((_cseq >> 8) & 0xFF); // sequence number
-		rtpBuffer[3] =  (_cseq & 0xFF);       // sequence number
+		const uint16_t cseq = client.getNextRtpSequenceNumber();
+		rtpBuffer[2] = ((cseq >> 8) & 0xFF); // sequence number
+		rtpBuffer[3] =  (cseq & 0xFF);       // sequence number
 
 		// update timestamp
 		const long timestamp = base::TimeCounter::getTicks() * 90;
@@ -122,19 +159,144 @@ namespace output {
 		rtpBuffer[6] = (timestamp >>  8) & 0xFF; // timestamp
 		rtpBuffer[7] = (timestamp >>  0) & 0xFF; // timestamp
 
+		// update synchronisation source, buffers can be send to more clients
+		const uint32_t ssrc = client.getSSRC();
+		rtpBuffer[8]  = (ssrc >> 24) & 0xFF; // synchronisation source
+		rtpBuffer[9]  = (ssrc >> 16) & 0xFF; // synchronisation source
+		rtpBuffer[10] = (ssrc >>  8) & 0xFF; // synchronisation source
+		rtpBuffer[11] = (ssrc >>  0) & 0xFF; // synchronisation source
+
 		const size_t size = buffer.getBufferSize();
 
 		// RTP packet octet count (Bytes)
 		_stream.addRtpData(size, timestamp);
+	}
+
+	bool StreamThreadRtp::openRtpSocket(StreamClient &client) {
+		// other clients sharing this stream get their socket with the first packet
+		SocketAttr &rtp = client.getRtpSocketAttr();
+		if (rtp.getFD() == -1 && !client.isSelfDestructing()) {
+			rtp.setupSocketHandle(SOCK_DGRAM, IPPROTO_UDP);
+		}
+		return rtp.getFD() != -1;
+	}
+
+	void StreamThreadRtp::rtpSocketFailed(StreamClient &client) {
+		if (!client.isSelfDestructing()) {
+			const SocketAttr &rtp = client.getRtpSocketAttr();
+			SI_LOG_ERROR("Stream: %d, Error sending RTP/UDP data to %s:%d", _stream.getStreamID(),
+				rtp.getIPAddressOfSocket().c_str(), rtp.getSocketPort());
+			client.selfDestruct();
+		}
+	}
+
+	bool StreamThreadRtp::writeDataToOutputDevice(mpegts::PacketBuffer &buffer, StreamClient &client) {
+		writeRtpHeader(buffer, client);
 
 		// send the RTP/UDP packet
 		SocketAttr &rtp = client.getRtpSocketAttr();
-		if (!rtp.sendDataTo(rtpBuffer, size + mpegts::PacketBuffer::RTP_HEADER_LEN, MSG_DONTWAIT)) {
-			if (!client.isSelfDestructing()) {
-				SI_LOG_ERROR("Stream: %d, Error sending RTP/UDP data to %s:%d", _stream.getStreamID(),
-					rtp.getIPAddressOfSocket().c_str(), rtp.getSocketPort());
-				client.selfDestruct();
+		openRtpSocket(client);
+		const size_t size = buffer.getBufferSize() + mpegts::PacketBuffer::RTP_HEADER_LEN;
+		if (rtp.sendDataTo(buffer.getReadBufferPtr(), size, MSG_DONTWAIT)) {
+			addSendStatistics(1);
+		} else {
+			rtpSocketFailed(client);
+		}
+		return true;
+	}
+
+	std::size_t StreamThreadRtp::writeBatchToOutputDevice(mpegts::PacketBuffer *buffer[],
+			const std::size_t count, StreamClient &client) {
+		for (std::size_t i = 0; i < count; ++i) {
+			writeRtpHeader(*buffer[i], client);
+			_iov[i].iov_base = buffer[i]->getReadBufferPtr();
+			_iov[i].iov_len  = buffer[i]->getBufferSize() + mpegts::PacketBuffer::RTP_HEADER_LEN;
+		}
+
+		// send the RTP/UDP packets, like with one packet they are not send
+		// again when it fails, so all buffers are done
+		SocketAttr &rtp = client.getRtpSocketAttr();
+		if (!openRtpSocket(client)) {
+			return count;
+		}
+		if (_gsoSupported && _stream.isRtpSegmentationOffload() && writeSegmentedBatch(count, client)) {
+			return count;
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			std::memset(&_msg[i], 0, sizeof(_msg[i]));
+			_msg[i].msg_hdr.msg_iov    = &_iov[i];
+			_msg[i].msg_hdr.msg_iovlen = 1;
+		}
+		std::size_t sent = 0;
+		while (sent < count) {
+			const int n = rtp.sendMultipleDataTo(&_msg[sent], count - sent, MSG_DONTWAIT);
+			if (n <= 0) {
+				rtpSocketFailed(client);
+				break;
+			}
+			addSendStatistics(n);
+			sent += n;
+		}
+		return count;
+	}
+
+	bool StreamThreadRtp::writeSegmentedBatch(const std::size_t count, StreamClient &client) {
+		// Put the packets of the same size in one message, the kernel or NIC
+		// splits it again in packets of this segment size. Only the last
+		// packet of a message may be smaller
+		std::size_t messages = 0;
+		for (std::size_t i = 0; i < count; ++messages) {
+			const std::size_t segmentSize = _iov[i].iov_len;
+			const std::size_t maxSegments = std::min(UDP_MAX_SEGMENTS, UDP_MAX_PAYLOAD / segmentSize);
+			std::size_t segments = 1;
+			while (i + segments < count && segments < maxSegments && _iov[i + segments].iov_len <= segmentSize) {
+				++segments;
+				if (_iov[i + segments - 1].iov_len < segmentSize) {
+					break;
+				}
+			}
+			struct mmsghdr &msg = _msg[messages];
+			std::memset(&msg, 0, sizeof(msg));
+			msg.msg_hdr.msg_iov    = &_iov[i];
+			msg.msg_hdr.msg_iovlen = segments;
+			if (segments > 1) {
+				msg.msg_hdr.msg_control    = _control[messages];
+				msg.msg_hdr.msg_controllen = sizeof(_control[messages]);
+				struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+				cmsg->cmsg_level = SOL_UDP;
+				cmsg->cmsg_type  = UDP_SEGMENT;
+				cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+				const uint16_t size = segmentSize;
+				std::memcpy(CMSG_DATA(cmsg), &size, sizeof(size));
+			}
+			_segments[messages] = segments;
+			i += segments;
+		}
+
+		SocketAttr &rtp = client.getRtpSocketAttr();
+		std::size_t sent = 0;
+		while (sent < messages) {
+			const int n = rtp.sendMultipleDataTo(&_msg[sent], messages - sent, MSG_DONTWAIT);
+			if (n <= 0) {
+				// The output device can not do the checksum of the segments
+				if (sent == 0 && (errno == EIO || errno == EINVAL)) {
+					SI_LOG_INFO("Stream: %d, %s UDP segmentation offload not possible, sending without it",
+						_stream.getStreamID(), _protocol.c_str());
+					_gsoSupported = false;
+					return false;
+				}
+				rtpSocketFailed(client);
+				break;
+			}
+			std::size_t packets = 0;
+			for (std::size_t m = sent; m < sent + n; ++m) {
+				packets += _segments[m];
+				if (_segments[m] > 1) {
+					++_gsoSends;
+				}
 			}
+			addSendStatistics(packets);
+			sent += n;
 		}
 		return true;
 	}
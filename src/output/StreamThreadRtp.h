@@ -24,6 +24,9 @@
 #include <output/StreamThreadBase.h>
 #include <output/StreamThreadRtcp.h>
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+
 FW_DECL_NS0(StreamClient);
 FW_DECL_NS0(StreamInterface);
 
@@ -65,8 +68,42 @@ class StreamThreadRtp :
 			mpegts::PacketBuffer &buffer,
 			StreamClient &client) override;
 
+		virtual std::size_t writeBatchToOutputDevice(
+			mpegts::PacketBuffer *buffer[],
+			std::size_t count,
+			StreamClient &client) override;
+
+		virtual std::size_t getOutputBatchSize() const override;
+
+		virtual std::chrono::milliseconds getOutputBatchLatency() const override;
+
 		virtual int getStreamSocketPort(int clientID) const override;
 
+	public:
+
+		virtual void addToXML(std::string &xml) const override;
+
+		// =====================================================================
+		//  -- Other member functions ------------------------------------------
+		// =====================================================================
+
+	private:
+
+		/// Update the RTP header of @a buffer for @a client and account it
+		void writeRtpHeader(mpegts::PacketBuffer &buffer, StreamClient &client);
+
+		/// Get the RTP socket of @a client, open it when needed
+		/// @return true if the socket can be used
+		bool openRtpSocket(StreamClient &client);
+
+		/// The RTP socket of @a client failed, stop this client
+		void rtpSocketFailed(StreamClient &client);
+
+		/// Send the @a count packets in @c _iov with UDP segmentation offload,
+		/// the packets of the same size are send as one buffer
+		/// @return false if the kernel can not do it, nothing is send then
+		bool writeSegmentedBatch(std::size_t count, StreamClient &client);
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
@@ -74,8 +111,13 @@ class StreamThreadRtp :
 	private:
 
 		int _clientID;
-		uint16_t _cseq;         /// RTP sequence number
 		StreamThreadRtcp _rtcp; ///
+		struct mmsghdr _msg[MAX_OUTPUT_BATCH];
+		struct iovec _iov[MAX_OUTPUT_BATCH];
+		std::size_t _segments[MAX_OUTPUT_BATCH];  /// packets in each GSO message
+		char _control[MAX_OUTPUT_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+		std::atomic<bool> _gsoSupported;          /// UDP_SEGMENT can be used on the socket
+		std::atomic<uint64_t> _gsoSends;          /// messages split by the kernel or NIC
 
 };
 
@@ -33,12 +33,11 @@ namespace output {
 	StreamThreadRtpTcp::StreamThreadRtpTcp(StreamInterface &stream) :
 		StreamThreadBase("RTP/TCP", stream),
 		_clientID(0),
-		_cseq(0),
 		_rtcp(stream) {
 	}
 
 	StreamThreadRtpTcp::~StreamThreadRtpTcp() {
-		terminateThread();
+		terminateStreaming();
 		const int streamID = _stream.getStreamID();
 		StreamClient &client = _stream.getStreamClient(_clientID);
 		SI_LOG_INFO("Stream: %d, Destroy %s stream to %s:%d", streamID, _protocol.c_str(),
@@ -57,7 +56,7 @@ namespace output {
 		// RTCP/TCP
 		_rtcp.startStreaming();
 
-		_cseq = 0x0000;
+		_stream.getStreamClient(_clientID).resetRtpSequenceNumber();
 		StreamThreadBase::startStreaming();
 		return true;
 	}
@@ -80,16 +79,21 @@ namespace output {
 		return  _stream.getStreamClient(clientID).getHttpSocketPort();
 	}
 
+	bool StreamThreadRtpTcp::isPacingNeeded() const {
+		// TCP, so the kernel does the flow control
+		return false;
+	}
+
 	void StreamThreadRtpTcp::threadEntry() {
 		StreamClient &client = _stream.getStreamClient(0);
 		while (running()) {
 			switch (_state) {
 			case State::Pause:
-				_state = State::Paused;
+				setState(State::Paused);
 				break;
 			case State::Paused:
-				// Do nothing here, just wait
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				// Do nothing here, just wait until restarted or stopped
+				waitWhilePaused();
 				break;
 			case State::Running:
 				readDataFromInputDevice(client);
@@ -106,9 +110,9 @@ namespace output {
 		unsigned char *rtpBuffer = buffer.getReadBufferPtr();
 
 		// update sequence number
-		++_cseq;
-		rtpBuffer[2] = ((_cseq >> 8) & 0xFF); // sequence number
-		rtpBuffer[3] =  (_cseq & 0xFF);       // sequence number
+		const uint16_t cseq = client.getNextRtpSequenceNumber();
+		rtpBuffer[2] = ((cseq >> 8) & 0xFF); // sequence number
+		rtpBuffer[3] =  (cseq & 0xFF);       // sequence number
 
 		// update timestamp
 		const long timestamp = base::TimeCounter::getTicks() * 90;
@@ -117,6 +121,13 @@ namespace output {
 		rtpBuffer[6] = (timestamp >>  8) & 0xFF; // timestamp
 		rtpBuffer[7] = (timestamp >>  0) & 0xFF; // timestamp
 
+		// update synchronisation source, buffers can be send to more clients
+		const uint32_t ssrc = client.getSSRC();
+		rtpBuffer[8]  = (ssrc >> 24) & 0xFF; // synchronisation source
+		rtpBuffer[9]  = (ssrc >> 16) & 0xFF; // synchronisation source
+		rtpBuffer[10] = (ssrc >>  8) & 0xFF; // synchronisation source
+		rtpBuffer[11] = (ssrc >>  0) & 0xFF; // synchronisation source
+
 		const size_t bufSize = buffer.getBufferSize();
 
 		// RTP packet octet count (Bytes)
@@ -67,6 +67,8 @@ class StreamThreadRtpTcp :
 
 		virtual int getStreamSocketPort(int clientID) const override;
 
+		virtual bool isPacingNeeded() const override;
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
@@ -74,7 +76,6 @@ class StreamThreadRtpTcp :
 	private:
 
 		int _clientID;
-		uint16_t _cseq;            /// RTP sequence number
 		StreamThreadRtcpTcp _rtcp; ///
 };
 
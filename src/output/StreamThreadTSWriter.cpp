@@ -38,24 +38,29 @@ namespace output {
 		_filePath(file) {}
 
 	StreamThreadTSWriter::~StreamThreadTSWriter() {
-		terminateThread();
+		terminateStreaming();
 	}
 
 	int StreamThreadTSWriter::getStreamSocketPort(int UNUSED(clientID)) const {
 		return 0;
 	}
 
+	bool StreamThreadTSWriter::isPacingNeeded() const {
+		// Writing to a file, so no need to pace
+		return false;
+	}
+
 	void StreamThreadTSWriter::threadEntry() {
 		StreamClient &client = _stream.getStreamClient(0);
 		_file.open(_filePath, std::ofstream::binary);
 		while (running()) {
 			switch (_state) {
 			case State::Pause:
-				_state = State::Paused;
+				setState(State::Paused);
 				break;
 			case State::Paused:
-				// Do nothing here, just wait
-				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				// Do nothing here, just wait until restarted or stopped
+				waitWhilePaused();
 				break;
 			case State::Running:
 				readDataFromInputDevice(client);
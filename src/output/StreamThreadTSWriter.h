@@ -58,6 +58,8 @@ namespace output {
 
 			virtual int getStreamSocketPort(int clientID) const override;
 
+			virtual bool isPacingNeeded() const override;
+
 			// =======================================================================
 			//  -- Data members ------------------------------------------------------
 			// =======================================================================
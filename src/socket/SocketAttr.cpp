@@ -26,8 +26,11 @@
 #include <string>
 #include <cstring>
 
+#include <cerrno>
+
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <linux/errqueue.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
@@ -174,6 +177,87 @@
 		return true;
 	}
 
+	int SocketAttr::sendMultipleDataTo(struct mmsghdr *msg, const unsigned int count, const int flags) {
+		for (unsigned int i = 0; i < count; ++i) {
+			msg[i].msg_hdr.msg_name = &_addr;
+			msg[i].msg_hdr.msg_namelen = sizeof(_addr);
+		}
+		const int sent = ::sendmmsg(_fd, msg, count, flags);
+		if (sent == -1) {
+			// keep errno for the caller
+			const int error = errno;
+			PERROR("sendmmsg");
+			errno = error;
+		}
+		return sent;
+	}
+
+	ssize_t SocketAttr::sendMessage(const struct msghdr *msg, const int flags) {
+		const ssize_t sent = ::sendmsg(_fd, msg, flags);
+		if (sent == -1 && errno != EBADF && errno != ENOBUFS && errno != EINTR) {
+			// keep errno for the caller
+			const int error = errno;
+			PERROR("sendmsg");
+			errno = error;
+		}
+		return sent;
+	}
+
+	bool SocketAttr::setZeroCopy() {
+		const int val = 1;
+		return ::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) == 0;
+	}
+
+	bool SocketAttr::readZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied) {
+		char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+		struct msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_control    = control;
+		msg.msg_controllen = sizeof(control);
+		if (::recvmsg(_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+			return false;
+		}
+		for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+			    (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+				struct sock_extended_err err;
+				std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+				if (err.ee_errno == 0 && err.ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+					lo = err.ee_info;
+					hi = err.ee_data;
+					copied = (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	bool SocketAttr::setMulticastOptions(const unsigned int ttl, const std::string &ifaceIPAddr) {
+		const int val = ttl;
+		if (::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, &val, sizeof(val)) == -1) {
+			PERROR("setsockopt: IP_MULTICAST_TTL");
+			return false;
+		}
+		if (!ifaceIPAddr.empty() && ifaceIPAddr != "0.0.0.0") {
+			struct in_addr iface;
+			iface.s_addr = inet_addr(ifaceIPAddr.c_str());
+			if (::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) == -1) {
+				PERROR("setsockopt: IP_MULTICAST_IF");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SocketAttr::isUdpSegmentationSupported() const {
+		// Older kernels do not know this option, and would ignore it when
+		// send as control message
+		int size = 0;
+		socklen_t len = sizeof(size);
+		return ::getsockopt(_fd, SOL_UDP, UDP_SEGMENT, &size, &len) == 0;
+	}
+
 	ssize_t SocketAttr::recvDatafrom(void *buf, std::size_t len, int flags) {
 		struct sockaddr_in si_other;
 		socklen_t addrlen = sizeof(si_other);
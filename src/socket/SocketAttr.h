@@ -22,12 +22,24 @@
 
 #include <FwDecl.h>
 
+#include <cstdint>
 #include <string>
 
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 
+#ifndef UDP_SEGMENT
+	#define UDP_SEGMENT 103
+#endif
+#ifndef SO_ZEROCOPY
+	#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+	#define MSG_ZEROCOPY 0x4000000
+#endif
+
 FW_DECL_NS0(SocketClient);
 
 /// Socket attributes
@@ -79,6 +91,27 @@ class SocketAttr {
 		/// connection-mode (SOCK_STREAM)
 		bool sendDataTo(const void *buf, std::size_t len, int flags);
 
+		/// Send the @a count messages with one syscall (sendmmsg) to the
+		/// address of this Socket, the destination of @a msg is set here
+		/// @return the amount of messages send, or -1 on error (see errno)
+		int sendMultipleDataTo(struct mmsghdr *msg, unsigned int count, int flags);
+
+		/// Send @a msg on a connected Socket, like with MSG_ZEROCOPY
+		/// @return the amount of Bytes send, or -1 on error (see errno)
+		ssize_t sendMessage(const struct msghdr *msg, int flags);
+
+		/// Let this Socket accept sends with MSG_ZEROCOPY (SO_ZEROCOPY)
+		/// @return false if the kernel does not support it
+		bool setZeroCopy();
+
+		/// Read one completion notification of MSG_ZEROCOPY sends from the
+		/// error queue, without waiting
+		/// @param lo specifies the first send that is completed
+		/// @param hi specifies the last send that is completed
+		/// @param copied is set when the kernel did copy the data after all
+		/// @return false if there is no notification
+		bool readZeroCopyCompletion(uint32_t &lo, uint32_t &hi, bool &copied);
+
 		/// Get the port of this Socket
 		int getSocketPort() const;
 
@@ -91,6 +124,17 @@ class SocketAttr {
 		/// Set the network receive buffer size for this Socket
 		bool setNetworkReceiveBufferSize(int size);
 
+		/// Set the TTL and outgoing interface for multicast packets send with
+		/// this Socket
+		/// @param ttl specifies the time to live (hops) of the packets
+		/// @param ifaceIPAddr specifies the IP address of the outgoing interface,
+		/// or empty to let the kernel choose
+		bool setMulticastOptions(unsigned int ttl, const std::string &ifaceIPAddr);
+
+		/// Check if the kernel supports UDP segmentation offload (UDP_SEGMENT)
+		/// on this Socket
+		bool isUdpSegmentationSupported() const;
+
 		/// Set the Receive and Send timeout in Sec for this socket
 		void setSocketTimeoutInSec(unsigned int timeout);
 
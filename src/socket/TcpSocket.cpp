@@ -36,6 +36,7 @@ TcpSocket::TcpSocket(int maxClients, const std::string &protocol) :
 		_MAX_CLIENTS(maxClients),
 		_MAX_POLL(maxClients + 1),
 		_pfd(new pollfd[maxClients + 1]),
+		_parked(maxClients + 1, false),
 		_client(new SocketClient[maxClients]),
 		_protocolString(protocol) {}
 
@@ -62,7 +63,27 @@ void TcpSocket::initialize(const std::string &ipAddr, int port, bool nonblock) {
 	}
 }
 
+/// Check if the socket has a pending error, this clears it
+static bool hasSocketError(const int fd) {
+	int error = 0;
+	socklen_t len = sizeof(error);
+	return ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == -1 || error != 0;
+}
+
+void TcpSocket::unparkClients(const int timeout) {
+	if (std::chrono::steady_clock::now() - _parkTime < std::chrono::milliseconds(timeout)) {
+		return;
+	}
+	for (std::size_t i = 1; i < _MAX_POLL; ++i) {
+		if (_parked[i]) {
+			_pfd[i].fd = _client[i - 1].getFD();
+			_parked[i] = false;
+		}
+	}
+}
+
 int TcpSocket::poll(int timeout) {
+	unparkClients(timeout);
 	if (::poll(_pfd, _MAX_POLL, timeout) > 0) {
 		// Check who is sending data, so iterate over pfd
 		for (std::size_t i = 0; i < _MAX_POLL; ++i) {
@@ -70,7 +91,7 @@ int TcpSocket::poll(int timeout) {
 				if (i == 0) {
 					// Try to find a free poll entry
 					for (std::size_t j = 0; j < _MAX_CLIENTS; ++j) {
-						if (_pfd[j + 1].fd == -1) {
+						if (_pfd[j + 1].fd == -1 && !_parked[j + 1]) {
 							if (acceptConnection(_client[j], true)) {
 								// setup polling
 								_pfd[j + 1].fd = _client[j].getFD();
@@ -80,6 +101,14 @@ int TcpSocket::poll(int timeout) {
 							}
 						}
 					}
+				} else if (_pfd[i].revents == POLLERR && !hasSocketError(_pfd[i].fd)) {
+					// Only the error queue has data, these are the MSG_ZEROCOPY
+					// completions of an HTTP stream that its streaming thread
+					// reads. Poll would keep waking up, so do not watch this
+					// client until the next timeout
+					_pfd[i].fd = -1;
+					_parked[i] = true;
+					_parkTime = std::chrono::steady_clock::now();
 				} else {
 					// receive httpc messages
 					const auto dataSize = recvHttpcMessage(_client[i-1], MSG_DONTWAIT);
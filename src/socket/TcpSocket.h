@@ -24,6 +24,7 @@
 #include <socket/HttpcSocket.h>
 #include <socket/SocketAttr.h>
 
+#include <chrono>
 #include <vector>
 
 #include <poll.h>
@@ -79,6 +80,10 @@ class TcpSocket :
 		/// Accept an connection and save client IP address etc.
 		bool acceptConnection(SocketClient &client, bool showLogInfo);
 
+		/// Watch the parked clients again, after they were parked for
+		/// @a timeout ms
+		void unparkClients(int timeout);
+
 		// =====================================================================
 		// -- Data members -----------------------------------------------------
 		// =====================================================================
@@ -88,6 +93,8 @@ class TcpSocket :
 		std::size_t        _MAX_CLIENTS;   //
 		std::size_t        _MAX_POLL;      //
 		struct pollfd     *_pfd;           //
+		std::vector<bool>  _parked;        // poll entry not watched for a while
+		std::chrono::steady_clock::time_point _parkTime; //
 		SocketAttr         _server;        //
 		SocketClient      *_client;        //
 		const std::string  _protocolString;//